@@ -0,0 +1,69 @@
+#include "BKTree.h"
+#include "PerceptualHash.h"
+#include <QVarLengthArray>
+
+// Insert a new hash, walking down edges labelled with the distance to each node
+void BKTree::insert(quint64 hash, int value)
+{
+    Node node{ hash, value, 0 };
+
+    if (m_nodes.isEmpty()) // First entry becomes the root
+    {
+        m_nodes.append(node);
+        return;
+    }
+
+    int current = 0;
+    for (;;)
+    {
+        const int d = PerceptualHash::distance(hash, m_nodes[current].hash);
+
+        // Look for an existing child connected by an edge of the same distance
+        int child = m_nodes[current].firstChild;
+        while (child != -1 && m_nodes[child].distance != d)
+            child = m_nodes[child].nextSibling;
+
+        if (child != -1) // Descend into matching subtree
+        {
+            current = child;
+            continue;
+        }
+
+        // No such edge yet - attach as new child
+        node.distance = d;
+        node.nextSibling = m_nodes[current].firstChild;
+        m_nodes.append(node);
+        m_nodes[current].firstChild = m_nodes.size() - 1;
+        return;
+    }
+}
+
+// Collect all values within the radius, pruning subtrees via the triangle inequality
+QList<int> BKTree::find(quint64 hash, int radius) const
+{
+    QList<int> result;
+    if (m_nodes.isEmpty())
+        return result;
+
+    QVarLengthArray<int, 64> stack; // Nodes still to visit
+    stack.append(0);
+
+    while (!stack.isEmpty())
+    {
+        const int index = stack.takeLast();
+        const Node& node = m_nodes[index];
+        const int d = PerceptualHash::distance(hash, node.hash);
+
+        if (d <= radius) // Node itself matches
+            result.append(node.value);
+
+        // Only children with edge distance in [d - radius, d + radius] can contain matches
+        for (int child = node.firstChild; child != -1; child = m_nodes[child].nextSibling)
+        {
+            const int edge = m_nodes[child].distance;
+            if (edge >= d - radius && edge <= d + radius)
+                stack.append(child);
+        }
+    }
+    return result;
+}
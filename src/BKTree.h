@@ -0,0 +1,68 @@
+#pragma once
+#include <QtGlobal>
+#include <QList>
+
+/**
+ * @class BKTree
+ * @brief Burkhard-Keller tree over 64-bit hashes with Hamming distance.
+ *
+ * @details
+ * Indexes perceptual hashes so that all entries within a given Hamming
+ * distance of a query can be found without comparing against every entry.
+ * Each node keeps its children in a sibling list ordered by insertion;
+ * the triangle inequality prunes every child whose edge distance lies
+ * outside [d - radius, d + radius].
+ *
+ * Values are opaque integers chosen by the caller (typically an index
+ * into a parallel list of photos).
+ *
+ * @see PerceptualHash
+ */
+class BKTree {
+public:
+    /**
+     * @brief Inserts a hash with an associated value.
+     * @param hash 64-bit hash key.
+     * @param value Caller-defined payload returned by find().
+     */
+    void insert(quint64 hash, int value);
+
+    /**
+     * @brief Finds all entries within a Hamming radius of a hash.
+     * @param hash Query hash.
+     * @param radius Maximum Hamming distance (inclusive).
+     * @return Values of all matching entries (including exact matches).
+     */
+    QList<int> find(quint64 hash, int radius) const;
+
+    /**
+     * @brief Removes all entries.
+     */
+    void clear() { m_nodes.clear(); }
+
+    /**
+     * @brief Returns the number of indexed entries.
+     * @return Entry count.
+     */
+    int size() const { return m_nodes.size(); }
+
+    /**
+     * @brief Checks whether the tree is empty.
+     * @return True if no entries are indexed.
+     */
+    bool isEmpty() const { return m_nodes.isEmpty(); }
+
+private:
+    /**
+     * @brief Single tree node stored in a flat list.
+     */
+    struct Node {
+        quint64 hash;         ///< Indexed hash.
+        int value;            ///< Caller payload.
+        int distance;         ///< Distance to the parent node (edge label).
+        int firstChild = -1;  ///< Index of the first child, -1 if leaf.
+        int nextSibling = -1; ///< Index of the next sibling, -1 if last.
+    };
+
+    QList<Node> m_nodes; ///< Flat node storage, index 0 is the root.
+};
@@ -0,0 +1,172 @@
+#include "ContentHash.h"
+#include <QFile>
+#include <QtEndian>
+#include <cstring>
+
+// xxHash64 prime constants
+static const quint64 PRIME1 = 11400714785074694791ULL;
+static const quint64 PRIME2 = 14029467366897019727ULL;
+static const quint64 PRIME3 = 1609587929392839161ULL;
+static const quint64 PRIME4 = 9650029242287828579ULL;
+static const quint64 PRIME5 = 2870177450012600261ULL;
+
+static const qint64 READ_CHUNK_SIZE = 4 * 1024 * 1024; // Fallback sequential read size
+
+static inline quint64 rotl(quint64 value, int bits)
+{
+    return (value << bits) | (value >> (64 - bits));
+}
+
+static inline quint64 round64(quint64 acc, quint64 input)
+{
+    acc += input * PRIME2;
+    acc = rotl(acc, 31);
+    return acc * PRIME1;
+}
+
+static inline quint64 mergeRound(quint64 acc, quint64 value)
+{
+    acc ^= round64(0, value);
+    return acc * PRIME1 + PRIME4;
+}
+
+// Constructor - initialize accumulators from seed
+ContentHash::ContentHash(quint64 seed)
+    : m_seed(seed),
+      m_totalLength(0),
+      m_bufferSize(0)
+{
+    m_acc[0] = seed + PRIME1 + PRIME2;
+    m_acc[1] = seed + PRIME2;
+    m_acc[2] = seed;
+    m_acc[3] = seed - PRIME1;
+}
+
+// Process one 32-byte stripe
+void ContentHash::processStripe(const uchar* stripe)
+{
+    for (int i = 0; i < 4; ++i)
+        m_acc[i] = round64(m_acc[i], qFromLittleEndian<quint64>(stripe + i * 8));
+}
+
+// Feed data, buffering an incomplete tail stripe
+void ContentHash::addData(const char* data, qint64 length)
+{
+    const uchar* p = reinterpret_cast<const uchar*>(data);
+    m_totalLength += quint64(length);
+
+	// Complete a pending stripe first
+    if (m_bufferSize > 0)
+    {
+        const int needed = qMin<qint64>(32 - m_bufferSize, length);
+        memcpy(m_buffer + m_bufferSize, p, needed);
+        m_bufferSize += needed;
+        p += needed;
+        length -= needed;
+
+		if (m_bufferSize < 32) // Still incomplete
+            return;
+
+        processStripe(m_buffer);
+        m_bufferSize = 0;
+    }
+
+	// Bulk stripes straight from input
+    while (length >= 32)
+    {
+        processStripe(p);
+        p += 32;
+        length -= 32;
+    }
+
+	// Keep the rest for later
+    memcpy(m_buffer, p, size_t(length));
+    m_bufferSize = int(length);
+}
+
+// Finalize a copy of the state
+quint64 ContentHash::result() const
+{
+    quint64 h;
+
+    if (m_totalLength >= 32)
+    {
+        h = rotl(m_acc[0], 1) + rotl(m_acc[1], 7) + rotl(m_acc[2], 12) + rotl(m_acc[3], 18);
+        for (int i = 0; i < 4; ++i)
+            h = mergeRound(h, m_acc[i]);
+    }
+	else // Short input never filled a stripe
+    {
+        h = m_seed + PRIME5;
+    }
+
+    h += m_totalLength;
+
+	// Remaining buffered bytes
+    const uchar* p = m_buffer;
+    int remaining = m_bufferSize;
+
+    while (remaining >= 8)
+    {
+        h ^= round64(0, qFromLittleEndian<quint64>(p));
+        h = rotl(h, 27) * PRIME1 + PRIME4;
+        p += 8;
+        remaining -= 8;
+    }
+
+    if (remaining >= 4)
+    {
+        h ^= quint64(qFromLittleEndian<quint32>(p)) * PRIME1;
+        h = rotl(h, 23) * PRIME2 + PRIME3;
+        p += 4;
+        remaining -= 4;
+    }
+
+    while (remaining > 0)
+    {
+        h ^= (*p) * PRIME5;
+        h = rotl(h, 11) * PRIME1;
+        ++p;
+        --remaining;
+    }
+
+	// Final avalanche
+    h ^= h >> 33;
+    h *= PRIME2;
+    h ^= h >> 29;
+    h *= PRIME3;
+    h ^= h >> 32;
+    return h;
+}
+
+// Hash whole file, memory-mapped if possible
+quint64 ContentHash::fromFile(const QString& filePath)
+{
+    QFile file(filePath);
+	if (!file.open(QIODevice::ReadOnly)) // Cannot read file
+        return 0;
+
+    ContentHash hash;
+    const qint64 size = file.size();
+
+    if (size > 0)
+    {
+        if (uchar* mapped = file.map(0, size))
+        {
+            hash.addData(reinterpret_cast<const char*>(mapped), size);
+            file.unmap(mapped);
+        }
+		else // Mapping not supported (e.g. some network shares), read sequentially
+        {
+            QByteArray chunk(READ_CHUNK_SIZE, Qt::Uninitialized);
+            qint64 read;
+            while ((read = file.read(chunk.data(), chunk.size())) > 0)
+                hash.addData(chunk.constData(), read);
+
+			if (read < 0) // Read error
+                return 0;
+        }
+    }
+
+    return hash.result();
+}
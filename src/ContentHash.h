@@ -0,0 +1,67 @@
+#pragma once
+#include <QtGlobal>
+#include <QString>
+
+/**
+ * @class ContentHash
+ * @brief Fast non-cryptographic 64-bit content fingerprint (XXH64).
+ *
+ * @details
+ * Incremental implementation of the xxHash64 algorithm. Data can be fed
+ * in arbitrary chunks with addData(); result() returns the same value as
+ * hashing the concatenated input in one call. Used to detect byte-identical
+ * photo files imported under different paths.
+ *
+ * Usage mirrors QCryptographicHash:
+ * @code
+ * ContentHash hash;
+ * hash.addData(buffer, length);
+ * quint64 fingerprint = hash.result();
+ * @endcode
+ */
+class ContentHash {
+public:
+    /**
+     * @brief Creates an empty hash state.
+     * @param seed Optional seed, 0 by default.
+     */
+    explicit ContentHash(quint64 seed = 0);
+
+    /**
+     * @brief Feeds a block of data into the hash.
+     * @param data Pointer to the data.
+     * @param length Number of bytes.
+     */
+    void addData(const char* data, qint64 length);
+
+    /**
+     * @brief Returns the hash of all data added so far.
+     * @return 64-bit fingerprint.
+     *
+     * @details Does not modify the state, more data can still be added.
+     */
+    quint64 result() const;
+
+    /**
+     * @brief Computes the fingerprint of a whole file.
+     * @param filePath Path to the file.
+     * @return 64-bit fingerprint, or 0 if the file cannot be read.
+     *
+     * @details The file is memory-mapped when possible, otherwise it is
+     * read sequentially in large chunks.
+     */
+    static quint64 fromFile(const QString& filePath);
+
+private:
+    /**
+     * @brief Consumes one 32-byte stripe into the four accumulators.
+     * @param stripe Pointer to 32 bytes of input.
+     */
+    void processStripe(const uchar* stripe);
+
+    quint64 m_seed;          ///< Seed used for initialization.
+    quint64 m_acc[4];        ///< Stripe accumulators.
+    quint64 m_totalLength;   ///< Total number of bytes added.
+    uchar m_buffer[32];      ///< Pending bytes of an incomplete stripe.
+    int m_bufferSize;        ///< Number of valid bytes in m_buffer.
+};
@@ -439,22 +439,3 @@ void CropDialog::applyCrop()
    
     accept();
 }
-
-QPixmap CropDialog::applyCropToPixmap(const QPixmap& source, const QRectF& normalizedCrop)
-{
-    if (source.isNull() || normalizedCrop.isEmpty())
-        return QPixmap();
-
-    // Konvertova normalizovan hodnoty na absoltne pixely
-    QRect cropRect(
-        qRound(normalizedCrop.x() * source.width()),
-        qRound(normalizedCrop.y() * source.height()),
-        qRound(normalizedCrop.width() * source.width()),
-        qRound(normalizedCrop.height() * source.height())
-    );
-
-    // Intersection pre istotu
-    cropRect = cropRect.intersected(source.rect());
-
-    return source.copy(cropRect);
-}
\ No newline at end of file
@@ -15,7 +15,6 @@ class CropDialog : public QDialog
 public:
 	explicit CropDialog(const QPixmap& source, const QSize& originalSize, QWidget* parent = nullptr);
 	QRectF normalizedCropRect() const { return m_normalizedCropRect; }
-	static QPixmap applyCropToPixmap(const QPixmap& source, const QRectF& normalizedCrop);
 
 private slots:
 	void applyCrop();
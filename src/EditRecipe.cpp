@@ -0,0 +1,116 @@
+#include "EditRecipe.h"
+#include <QJsonArray>
+
+static const QRectF WHOLE_IMAGE(0, 0, 1, 1);
+
+// Adjustment names in the serialized recipe
+static const struct {
+    const char* name;
+    int ColorAdjustments::* value;
+} ADJUSTMENT_FIELDS[] = {
+    { "brightness", &ColorAdjustments::brightness },
+    { "contrast", &ColorAdjustments::contrast },
+    { "saturation", &ColorAdjustments::saturation },
+    { "temperature", &ColorAdjustments::temperature },
+    { "red", &ColorAdjustments::red },
+    { "green", &ColorAdjustments::green },
+    { "blue", &ColorAdjustments::blue },
+    { "filter", &ColorAdjustments::filter }
+};
+
+bool EditRecipe::isIdentity() const
+{
+	// Position and opacity do nothing without a watermark
+    return rotation == 0 && !hasCrop() && adjustments.isIdentity() && watermarkPath.isEmpty();
+}
+
+bool EditRecipe::hasCrop() const
+{
+    return crop.isValid() && crop != WHOLE_IMAGE;
+}
+
+void EditRecipe::rotate(int degrees)
+{
+    const int steps = ((degrees / 90) % 4 + 4) % 4; // Clockwise quarter turns
+    for (int i = 0; i < steps; ++i)
+    {
+        rotation = (rotation + 90) % 360;
+
+		// A normalized point (x, y) moves to (1 - y, x)
+        if (hasCrop())
+            crop = QRectF(1 - crop.bottom(), crop.x(), crop.height(), crop.width());
+    }
+}
+
+void EditRecipe::cropTo(const QRectF& normalized)
+{
+    const QRectF base = hasCrop() ? crop : WHOLE_IMAGE;
+    crop = QRectF(base.x() + normalized.x() * base.width(),
+        base.y() + normalized.y() * base.height(),
+        normalized.width() * base.width(),
+        normalized.height() * base.height()).intersected(WHOLE_IMAGE);
+
+	if (!hasCrop()) // Whole image or nothing left, store as uncropped
+        crop = QRectF();
+}
+
+QJsonObject EditRecipe::toJson() const
+{
+    QJsonObject json;
+    if (rotation != 0)
+        json["rotation"] = rotation;
+    if (hasCrop())
+        json["crop"] = QJsonArray{ crop.x(), crop.y(), crop.width(), crop.height() };
+
+    QJsonObject colors;
+    for (const auto& field : ADJUSTMENT_FIELDS)
+    {
+		if (adjustments.*field.value != 0) // Sliders at their defaults are left out
+            colors[field.name] = adjustments.*field.value;
+    }
+    if (!colors.isEmpty())
+        json["adjustments"] = colors;
+
+    if (!watermarkPath.isEmpty())
+    {
+        json["watermark"] = QJsonObject{
+            {"path", watermarkPath},
+            {"position", watermarkPosition},
+            {"opacity", watermarkOpacity}
+        };
+    }
+    return json;
+}
+
+EditRecipe EditRecipe::fromJson(const QJsonObject& json)
+{
+    EditRecipe recipe;
+
+    const int rotation = json["rotation"].toInt();
+	recipe.rotation = ((rotation - rotation % 90) % 360 + 360) % 360; // Quarter turns only
+
+    const QJsonArray crop = json["crop"].toArray();
+    if (crop.size() == 4)
+    {
+        recipe.crop = QRectF(crop[0].toDouble(), crop[1].toDouble(), crop[2].toDouble(), crop[3].toDouble()).intersected(WHOLE_IMAGE);
+        if (!recipe.hasCrop())
+            recipe.crop = QRectF();
+    }
+
+    const QJsonObject colors = json["adjustments"].toObject();
+    for (const auto& field : ADJUSTMENT_FIELDS)
+        recipe.adjustments.*field.value = colors[field.name].toInt();
+
+    const QJsonObject watermark = json["watermark"].toObject();
+    recipe.watermarkPath = watermark["path"].toString();
+    recipe.watermarkPosition = qBound(0, watermark["position"].toInt(DEFAULT_WATERMARK_POSITION), 4);
+    recipe.watermarkOpacity = qBound(0, watermark["opacity"].toInt(DEFAULT_WATERMARK_OPACITY), 100);
+    return recipe;
+}
+
+bool EditRecipe::operator==(const EditRecipe& other) const
+{
+    return rotation == other.rotation && crop == other.crop && adjustments == other.adjustments
+        && watermarkPath == other.watermarkPath && watermarkPosition == other.watermarkPosition
+        && watermarkOpacity == other.watermarkOpacity;
+}
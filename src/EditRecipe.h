@@ -0,0 +1,80 @@
+#pragma once
+#include <QString>
+#include <QRectF>
+#include <QJsonObject>
+#include "PointTransform.h"
+
+/**
+ * @struct EditRecipe
+ * @brief Non-destructive description of a photo edit.
+ *
+ * @details
+ * Instead of keeping edited pixels, a photo stores the steps that produce
+ * them: rotation, crop, colour adjustments with the filter preset and a
+ * reference to the watermark image. The recipe is persisted with the
+ * photo metadata (PhotoData::edit) and rendered by ImagePipeline only
+ * when pixels are needed, at whatever resolution is needed.
+ *
+ * All values are resolution independent, so the same recipe renders a
+ * thumbnail, the editor preview and the full-resolution export.
+ *
+ * Steps are applied in this order: rotation, crop, colour adjustments,
+ * watermark.
+ *
+ * @see ImagePipeline
+ */
+struct EditRecipe {
+    static const int DEFAULT_WATERMARK_POSITION = 3;  ///< Bottom right.
+    static const int DEFAULT_WATERMARK_OPACITY = 70;  ///< Percent.
+
+    int rotation = 0;               ///< Clockwise rotation in degrees: 0, 90, 180 or 270.
+    QRectF crop;                    ///< Crop in normalized coordinates of the rotated image, null = uncropped.
+    ColorAdjustments adjustments;   ///< Slider values and filter preset.
+    QString watermarkPath;          ///< Watermark image file, empty = no watermark.
+    int watermarkPosition = DEFAULT_WATERMARK_POSITION; ///< 0 top left, 1 top right, 2 bottom left, 3 bottom right, 4 center.
+    int watermarkOpacity = DEFAULT_WATERMARK_OPACITY;   ///< Watermark opacity 0-100.
+
+    /**
+     * @brief Checks whether the recipe leaves the photo unchanged.
+     * @return True if no step would modify pixels.
+     */
+    bool isIdentity() const;
+
+    /**
+     * @brief Checks whether the recipe crops the image.
+     * @return True for a crop smaller than the whole image.
+     */
+    bool hasCrop() const;
+
+    /**
+     * @brief Rotates the result by a further multiple of 90 degrees.
+     * @param degrees Clockwise angle, negative for counter-clockwise.
+     *
+     * @details The crop rectangle is rotated along, so the same part of
+     * the photo stays selected.
+     */
+    void rotate(int degrees);
+
+    /**
+     * @brief Crops the current result further.
+     * @param normalized Crop in normalized coordinates of the image the
+     *        recipe currently produces.
+     */
+    void cropTo(const QRectF& normalized);
+
+    /**
+     * @brief Serializes the recipe, default values are left out.
+     * @return QJsonObject with the non-default steps.
+     */
+    QJsonObject toJson() const;
+
+    /**
+     * @brief Reads a recipe written by toJson().
+     * @param json The JSON object; missing values keep their defaults.
+     * @return Recipe with rotation and crop validated.
+     */
+    static EditRecipe fromJson(const QJsonObject& json);
+
+    bool operator==(const EditRecipe& other) const;
+    bool operator!=(const EditRecipe& other) const { return !(*this == other); }
+};
@@ -0,0 +1,47 @@
+#include "ImageLoader.h"
+#include "ImagePipeline.h"
+#include <QImageReader>
+#include <QPointer>
+#include <QThread>
+#include <algorithm>
+
+ImageLoader::ImageLoader(QObject* parent)
+    : QObject(parent)
+{
+}
+
+void ImageLoader::load(const QString& filePath, int previewSize)
+{
+    const int generation = ++m_generation;
+
+	// Results go through a relay on this thread, which outlives the loader if it is deleted first
+    QObject* relay = new QObject();
+    QPointer<ImageLoader> loader(this);
+    auto deliver = [relay, loader, generation](auto emitResult) {
+        QMetaObject::invokeMethod(relay, [loader, generation, emitResult]() {
+            if (loader && loader->m_generation == generation) // Not deleted or superseded meanwhile
+                emitResult(loader.data());
+            }, Qt::QueuedConnection);
+    };
+
+    QThread* thread = QThread::create([filePath, previewSize, deliver]() {
+        QImageReader reader(filePath);
+        const QSize size = reader.size();
+        const bool scaledDecode = previewSize > 0 && reader.supportsOption(QImageIOHandler::ScaledSize)
+            && size.isValid() && std::max(size.width(), size.height()) > previewSize;
+
+        if (scaledDecode)
+        {
+            const QImage preview = ImagePipeline::loadImage(filePath, previewSize);
+            deliver([preview](ImageLoader* target) { emit target->previewLoaded(preview); });
+        }
+
+        const QImage image = ImagePipeline::loadImage(filePath);
+        deliver([image](ImageLoader* target) { emit target->imageLoaded(image); });
+    });
+
+	// Posted after the results, so the relay handles them first
+    connect(thread, &QThread::finished, relay, &QObject::deleteLater);
+    connect(thread, &QThread::finished, thread, &QObject::deleteLater);
+    thread->start();
+}
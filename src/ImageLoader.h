@@ -0,0 +1,52 @@
+#pragma once
+#include <QObject>
+#include <QImage>
+#include <QString>
+
+/**
+ * @class ImageLoader
+ * @brief Decodes an image file in the background, a quick preview first.
+ *
+ * @details
+ * load() returns at once. A worker thread first decodes the file scaled
+ * down to the preview size, which decoders like JPEG do at a fraction of
+ * the cost of a full decode, then decodes it at full resolution. Formats
+ * that cannot decode scaled (or files no larger than the preview) skip the
+ * preview stage; their full decode is the only one.
+ *
+ * Decoding cannot be interrupted. Deleting the loader or calling load()
+ * again does not wait for a running decode, its results are discarded.
+ */
+class ImageLoader : public QObject {
+    Q_OBJECT
+
+public:
+    /**
+     * @brief Creates an idle loader.
+     * @param parent Optional parent object.
+     */
+    explicit ImageLoader(QObject* parent = nullptr);
+
+    /**
+     * @brief Starts decoding a file, superseding an earlier load().
+     * @param filePath Image file.
+     * @param previewSize Bounding square of the preview decode, 0 for none.
+     */
+    void load(const QString& filePath, int previewSize);
+
+signals:
+    /**
+     * @brief Emitted on the owning thread when the reduced-scale decode is done.
+     * @param preview Image scaled to fit the preview size.
+     */
+    void previewLoaded(const QImage& preview);
+
+    /**
+     * @brief Emitted on the owning thread when the full decode is done.
+     * @param image Full-resolution image, null if the file cannot be read.
+     */
+    void imageLoaded(const QImage& image);
+
+private:
+    int m_generation = 0; ///< Identifies the latest load(), only used on the owning thread.
+};
@@ -0,0 +1,265 @@
+#include "ImagePipeline.h"
+#include "PixelKernels.h"
+#include <QImageReader>
+#include <QVarLengthArray>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+// Kernels work on straight (not premultiplied) 32-bit pixels
+static QImage toStraight32(const QImage& image)
+{
+    if (image.format() == QImage::Format_RGB32 || image.format() == QImage::Format_ARGB32)
+        return image;
+    return image.convertToFormat(image.hasAlphaChannel() ? QImage::Format_ARGB32 : QImage::Format_RGB32);
+}
+
+// Writes a region of the rotated image, shifted by the crop offset, from its source.
+// Same mapping as QImage::transformed() for multiples of 90 degrees.
+static void transformRegion(const QImage& source, QImage& target, const QRect& region, int rotation, const QPoint& offset)
+{
+    const int lastX = source.width() - 1;
+    const int lastY = source.height() - 1;
+
+    if (rotation == 0 || rotation == 180)
+    {
+        for (int y = region.top(); y <= region.bottom(); ++y)
+        {
+            const int sourceY = rotation == 0 ? y + offset.y() : lastY - (y + offset.y());
+            const QRgb* src = reinterpret_cast<const QRgb*>(source.constScanLine(sourceY));
+            QRgb* dst = reinterpret_cast<QRgb*>(target.scanLine(y));
+
+            if (rotation == 0)
+                std::memcpy(dst + region.left(), src + region.left() + offset.x(), size_t(region.width()) * sizeof(QRgb));
+            else
+                for (int x = region.left(); x <= region.right(); ++x)
+                    dst[x] = src[lastX - (x + offset.x())];
+        }
+        return;
+    }
+
+	// A target column is a source row, walk the region column by column so both stay in cache
+    QVarLengthArray<QRgb*, 64> rows;
+    for (int y = region.top(); y <= region.bottom(); ++y)
+        rows.append(reinterpret_cast<QRgb*>(target.scanLine(y)));
+
+    for (int x = region.left(); x <= region.right(); ++x)
+    {
+        const int rotatedX = x + offset.x();
+        const QRgb* src = reinterpret_cast<const QRgb*>(source.constScanLine(rotation == 90 ? lastY - rotatedX : rotatedX));
+        for (int i = 0; i < rows.size(); ++i)
+        {
+            const int rotatedY = region.top() + i + offset.y();
+            rows[i][x] = src[rotation == 90 ? rotatedY : lastX - rotatedY];
+        }
+    }
+}
+
+// Pixel rectangle a recipe keeps of the rotated image
+static QRect geometryRect(const QSize& size, int rotation, const QRectF& crop)
+{
+    const QSize rotatedSize = rotation % 180 == 0 ? size : size.transposed();
+    return crop.isNull() ? QRect(QPoint(0, 0), rotatedSize) : ImagePipeline::cropRect(rotatedSize, crop);
+}
+
+// Blends the part of a straight ARGB32 watermark that falls into the region
+static void blendWatermark(QImage& image, const QImage& watermark, const QPoint& position, int opacity, const QRect& region)
+{
+    const QRect target = QRect(position, watermark.size()).intersected(region).intersected(image.rect());
+    for (int y = target.top(); y <= target.bottom(); ++y)
+    {
+        QRgb* dst = reinterpret_cast<QRgb*>(image.scanLine(y)) + target.left();
+        const QRgb* src = reinterpret_cast<const QRgb*>(watermark.constScanLine(y - position.y())) + (target.left() - position.x());
+        PixelKernels::blend(dst, src, target.width(), opacity);
+    }
+}
+
+
+// -------------------------
+//   Rendering
+// -------------------------
+
+QImage ImagePipeline::render(const QImage& original, const EditRecipe& recipe, const QImage& watermark,
+    const TileRenderer::ProgressFunction& progress)
+{
+    return renderRegion(original, recipe, QRect(QPoint(0, 0), outputSize(original.size(), recipe)), watermark, progress);
+}
+
+QImage ImagePipeline::renderRegion(const QImage& original, const EditRecipe& recipe, const QRect& region,
+    const QImage& watermark, const TileRenderer::ProgressFunction& progress)
+{
+    if (original.isNull())
+        return QImage();
+
+    const QImage source = toStraight32(original);
+    const int rotation = recipe.rotation;
+    const QRect crop = geometryRect(source.size(), rotation, recipe.hasCrop() ? recipe.crop : QRectF());
+    const QRect area = region.intersected(QRect(QPoint(0, 0), crop.size()));
+    if (area.isEmpty())
+        return QImage();
+
+	// Without geometry changes the tiles work on a copy of the source in place
+    const bool geometry = rotation != 0 || area.size() != source.size();
+    QImage image = geometry ? QImage(area.size(), source.format()) : source;
+    const QPoint offset = crop.topLeft() + area.topLeft();
+
+	// Watermark is laid out on the whole result, the region only shows part of it
+    const PointTransform pointTransform(recipe.adjustments);
+    const QImage scaledWm = recipe.watermarkPath.isEmpty() ? QImage()
+        : scaledWatermark(watermark.isNull() ? QImage(recipe.watermarkPath) : watermark, crop.width());
+    const QPoint wmPosition = watermarkPosition(recipe.watermarkPosition, crop.size(), scaledWm.size()) - area.topLeft();
+    const int wmOpacity = qRound(recipe.watermarkOpacity * 2.55); // Recipe stores 0-100, kernel takes 0-255
+
+	// Every tile runs all steps while its pixels are in cache
+    TileRenderer renderer;
+    const bool completed = renderer.run(image, [&](QImage& target, const QRect& tile) {
+        if (geometry)
+            transformRegion(source, target, tile, rotation, offset);
+
+        if (!pointTransform.isIdentity())
+        {
+            for (int y = tile.top(); y <= tile.bottom(); ++y)
+                pointTransform.applyToPixels(reinterpret_cast<QRgb*>(target.scanLine(y)) + tile.left(), tile.width());
+        }
+
+        if (!scaledWm.isNull())
+            blendWatermark(target, scaledWm, wmPosition, wmOpacity, tile);
+        }, progress);
+
+    return completed ? image : QImage();
+}
+
+QImage ImagePipeline::renderFile(const QString& filePath, const EditRecipe& recipe, int maxSize,
+    const TileRenderer::ProgressFunction& progress)
+{
+	// The crop keeps only part of the decoded image, decode enough for that part to fill maxSize
+    int decodeSize = maxSize;
+    if (maxSize > 0 && recipe.hasCrop())
+        decodeSize = int(std::ceil(maxSize / std::min(recipe.crop.width(), recipe.crop.height())));
+
+    const QImage original = loadImage(filePath, decodeSize);
+    if (original.isNull() || recipe.isIdentity())
+        return original;
+
+    const QImage edited = render(original, recipe, QImage(), progress);
+    if (maxSize > 0 && (edited.width() > maxSize || edited.height() > maxSize))
+        return edited.scaled(maxSize, maxSize, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+    return edited;
+}
+
+QImage ImagePipeline::adjust(const QImage& image, const ColorAdjustments& adjustments,
+    const TileRenderer::ProgressFunction& progress)
+{
+    QImage result = toStraight32(image);
+    const PointTransform pointTransform(adjustments);
+    if (result.isNull() || pointTransform.isIdentity())
+        return result;
+
+    TileRenderer renderer;
+    const bool completed = renderer.run(result, [&](QImage& target, const QRect& tile) {
+        for (int y = tile.top(); y <= tile.bottom(); ++y)
+            pointTransform.applyToPixels(reinterpret_cast<QRgb*>(target.scanLine(y)) + tile.left(), tile.width());
+        }, progress);
+
+    return completed ? result : QImage();
+}
+
+QImage ImagePipeline::transform(const QImage& image, int rotation, const QRectF& crop,
+    const TileRenderer::ProgressFunction& progress)
+{
+    const QImage source = toStraight32(image);
+    const QRect rect = geometryRect(source.size(), rotation, crop);
+    if (source.isNull() || (rotation == 0 && rect.size() == source.size()))
+        return source;
+
+    QImage result(rect.size(), source.format());
+    TileRenderer renderer;
+    const bool completed = renderer.run(result, [&](QImage& target, const QRect& tile) {
+        transformRegion(source, target, tile, rotation, rect.topLeft());
+        }, progress);
+
+    return completed ? result : QImage();
+}
+
+QImage ImagePipeline::applyWatermark(const QImage& image, const QImage& scaledWatermark, int position, int opacity)
+{
+    if (scaledWatermark.isNull())
+        return image;
+
+	// Only the watermark area is written, no tiles needed
+    QImage result = image;
+    const QPoint topLeft = watermarkPosition(position, result.size(), scaledWatermark.size());
+    blendWatermark(result, scaledWatermark, topLeft, qRound(opacity * 2.55), result.rect());
+    return result;
+}
+
+QImage ImagePipeline::loadImage(const QString& filePath, int maxSize)
+{
+    QImageReader reader(filePath);
+    const QSize size = reader.size();
+
+	// Decoders like JPEG scale down while decoding, far cheaper than decoding fully
+    if (maxSize > 0 && size.isValid() && (size.width() > maxSize || size.height() > maxSize))
+        reader.setScaledSize(size.scaled(maxSize, maxSize, Qt::KeepAspectRatio));
+
+    return reader.read();
+}
+
+
+// -------------------------
+//   Geometry
+// -------------------------
+
+QSize ImagePipeline::outputSize(const QSize& originalSize, const EditRecipe& recipe)
+{
+    const QSize rotatedSize = recipe.rotation % 180 == 0 ? originalSize : originalSize.transposed();
+    return recipe.hasCrop() ? cropRect(rotatedSize, recipe.crop).size() : rotatedSize;
+}
+
+QRect ImagePipeline::cropRect(const QSize& size, const QRectF& normalizedCrop)
+{
+    const QRect rect(
+        qRound(normalizedCrop.x() * size.width()),
+        qRound(normalizedCrop.y() * size.height()),
+        std::max(1, qRound(normalizedCrop.width() * size.width())),
+        std::max(1, qRound(normalizedCrop.height() * size.height())));
+    return rect.intersected(QRect(QPoint(0, 0), size));
+}
+
+
+// -------------------------
+//   Watermark
+// -------------------------
+
+QImage ImagePipeline::scaledWatermark(const QImage& watermark, int imageWidth)
+{
+    if (watermark.isNull() || imageWidth < 4)
+        return QImage();
+
+	// Scale watermark to 1/4 of image width
+    const int wmWidth = imageWidth / 4;
+    return watermark.scaled(wmWidth, wmWidth, Qt::KeepAspectRatio, Qt::SmoothTransformation)
+        .convertToFormat(QImage::Format_ARGB32); // Straight alpha for the blend kernel
+}
+
+QPoint ImagePipeline::watermarkPosition(int position, const QSize& imageSize, const QSize& watermarkSize)
+{
+	// Margin grows with the image, so every resolution shows the same layout
+    const int margin = qRound(WATERMARK_MARGIN * std::max(imageSize.width(), imageSize.height()) / double(REFERENCE_SIZE));
+    const int right = imageSize.width() - watermarkSize.width() - margin;
+    const int bottom = imageSize.height() - watermarkSize.height() - margin;
+
+    switch (position)
+    {
+	case 0: // Top Left
+        return QPoint(margin, margin);
+	case 1: // Top Right
+        return QPoint(right, margin);
+	case 2: // Bottom Left
+        return QPoint(margin, bottom);
+	case 4: // Center
+        return QPoint((imageSize.width() - watermarkSize.width()) / 2, (imageSize.height() - watermarkSize.height()) / 2);
+	default: // Bottom Right
+        return QPoint(right, bottom);
+    }
+}
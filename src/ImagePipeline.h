@@ -0,0 +1,147 @@
+#pragma once
+#include <QImage>
+#include <QString>
+#include "EditRecipe.h"
+#include "TileRenderer.h"
+
+/**
+ * @class ImagePipeline
+ * @brief Renders the pixels of an EditRecipe.
+ *
+ * @details
+ * Rendering runs tile by tile on a thread pool (see TileRenderer): every
+ * band of the output is read from the original through the rotation and
+ * crop, then colour-adjusted and watermarked while it is in cache.
+ *
+ * The same recipe renders at any resolution. The watermark is scaled to a
+ * quarter of the image width and its margin to the image size, so a
+ * thumbnail, the editor preview and the export look alike.
+ *
+ * render() runs all steps fused, tile by tile. The single steps are
+ * available as well (adjust(), transform(), applyWatermark()), so that
+ * PipelineCache can keep intermediate results. The colour adjustments are
+ * point operations and commute with rotation and crop, which lets them run
+ * first there.
+ *
+ * Uses no widgets, all functions are thread-safe. Built with its helpers
+ * as the ImagePipeline static library, so tools and tests can link it
+ * without the dialogs.
+ */
+class ImagePipeline {
+public:
+    static const int WATERMARK_MARGIN = 20;   ///< Watermark distance from the edges for a REFERENCE_SIZE image.
+    static const int REFERENCE_SIZE = 1024;   ///< Long side WATERMARK_MARGIN is given for (the editor preview).
+
+    /**
+     * @brief Applies a recipe to an image.
+     * @param original Unedited image.
+     * @param recipe Edit steps.
+     * @param watermark Watermark image; loaded from the recipe path if null.
+     * @param progress Optional progress callback, see TileRenderer::run().
+     * @return Edited 32-bit image, null if the render was canceled.
+     */
+    static QImage render(const QImage& original, const EditRecipe& recipe, const QImage& watermark = QImage(),
+        const TileRenderer::ProgressFunction& progress = TileRenderer::ProgressFunction());
+
+    /**
+     * @brief Applies a recipe to an image, computing only part of the result.
+     * @param original Unedited image.
+     * @param recipe Edit steps.
+     * @param region Pixel rectangle of the result to compute, see outputSize().
+     * @param watermark Watermark image; loaded from the recipe path if null.
+     * @param progress Optional progress callback, see TileRenderer::run().
+     * @return The region of render(), null if it is empty or the render was canceled.
+     *
+     * @details Used for zoomed views: only the visible pixels are read from
+     * the original and processed.
+     */
+    static QImage renderRegion(const QImage& original, const EditRecipe& recipe, const QRect& region,
+        const QImage& watermark = QImage(),
+        const TileRenderer::ProgressFunction& progress = TileRenderer::ProgressFunction());
+
+    /**
+     * @brief Decodes a photo file and applies a recipe.
+     * @param filePath Photo file.
+     * @param recipe Edit steps.
+     * @param maxSize Bounding square of the result, 0 for full resolution.
+     * @param progress Optional progress callback of the render, see TileRenderer::run().
+     * @return Edited image, null if the file cannot be read or the render was canceled.
+     *
+     * @details With a size limit the decoder scales down while decoding,
+     * enough for the cropped part to still fill @p maxSize.
+     */
+    static QImage renderFile(const QString& filePath, const EditRecipe& recipe, int maxSize = 0,
+        const TileRenderer::ProgressFunction& progress = TileRenderer::ProgressFunction());
+
+    /**
+     * @brief Applies only the colour adjustments.
+     * @param image Image to adjust.
+     * @param adjustments Slider values and filter preset.
+     * @param progress Optional progress callback, see TileRenderer::run().
+     * @return Adjusted 32-bit image, null if the render was canceled.
+     */
+    static QImage adjust(const QImage& image, const ColorAdjustments& adjustments,
+        const TileRenderer::ProgressFunction& progress = TileRenderer::ProgressFunction());
+
+    /**
+     * @brief Applies only the rotation and crop.
+     * @param image Image to transform.
+     * @param rotation Clockwise rotation, see EditRecipe::rotation.
+     * @param crop Normalized crop of the rotated image, null for none.
+     * @param progress Optional progress callback, see TileRenderer::run().
+     * @return Transformed 32-bit image, null if the render was canceled.
+     */
+    static QImage transform(const QImage& image, int rotation, const QRectF& crop,
+        const TileRenderer::ProgressFunction& progress = TileRenderer::ProgressFunction());
+
+    /**
+     * @brief Blends a watermark over a copy of the image.
+     * @param image Straight 32-bit image, e.g. a result of transform().
+     * @param scaledWatermark Watermark from scaledWatermark() for this image width.
+     * @param position Corner or center, see EditRecipe::watermarkPosition.
+     * @param opacity Opacity 0-100.
+     * @return Image with the watermark; only its area is touched.
+     */
+    static QImage applyWatermark(const QImage& image, const QImage& scaledWatermark, int position, int opacity);
+
+    /**
+     * @brief Decodes an image file, optionally scaled down while decoding.
+     * @param filePath Image file.
+     * @param maxSize Bounding square of the result, 0 for full resolution.
+     * @return Decoded image, null on failure.
+     */
+    static QImage loadImage(const QString& filePath, int maxSize = 0);
+
+    /**
+     * @brief Returns the size a recipe produces.
+     * @param originalSize Size of the unedited image.
+     * @param recipe Edit steps.
+     * @return Size after rotation and crop.
+     */
+    static QSize outputSize(const QSize& originalSize, const EditRecipe& recipe);
+
+    /**
+     * @brief Converts a normalized crop to pixels.
+     * @param size Size of the image being cropped.
+     * @param normalizedCrop Crop in 0-1 coordinates.
+     * @return Pixel rectangle inside the image, at least 1x1.
+     */
+    static QRect cropRect(const QSize& size, const QRectF& normalizedCrop);
+
+    /**
+     * @brief Scales a watermark to a quarter of the image width.
+     * @param watermark Watermark image.
+     * @param imageWidth Width of the image it is drawn on.
+     * @return Straight ARGB32 watermark, null if there is none.
+     */
+    static QImage scaledWatermark(const QImage& watermark, int imageWidth);
+
+    /**
+     * @brief Computes where the watermark is drawn.
+     * @param position Corner or center, see EditRecipe::watermarkPosition.
+     * @param imageSize Size of the image it is drawn on.
+     * @param watermarkSize Size of the scaled watermark.
+     * @return Top-left corner of the watermark.
+     */
+    static QPoint watermarkPosition(int position, const QSize& imageSize, const QSize& watermarkSize);
+};
@@ -0,0 +1,446 @@
+#include "JournalMetadataStore.h"
+#include "PhotoMetadata.h"
+#include "ContentHash.h"
+#include "MetadataSnapshot.h"
+#include <QDir>
+#include <QFileInfo>
+#include <QSet>
+#include <QThread>
+#include <QtEndian>
+#include <QDebug>
+
+// Record header: body size (4 bytes) + XXH64 of the body (8 bytes)
+static const int HEADER_SIZE = 12;
+
+// Upper bound for a single record, larger sizes mean a corrupt header
+static const quint32 MAX_RECORD_SIZE = 64 * 1024 * 1024;
+
+// Read buffer for replaying files
+static const qint64 READ_CHUNK = 1024 * 1024;
+
+
+// -------------------------
+//   Record format
+// -------------------------
+
+QByteArray JournalMetadataStore::encodeRecord(Operation operation, const QString& key, const QByteArray& payload)
+{
+    const QByteArray keyBytes = key.toUtf8();
+
+	// Body: operation, key length, key, payload
+    QByteArray body;
+    body.reserve(1 + 4 + keyBytes.size() + payload.size());
+    body.append(char(operation));
+    const quint32 keyLength = qToLittleEndian(quint32(keyBytes.size()));
+    body.append(reinterpret_cast<const char*>(&keyLength), 4);
+    body.append(keyBytes);
+    body.append(payload);
+
+    ContentHash hash;
+    hash.addData(body.constData(), body.size());
+    const quint32 size = qToLittleEndian(quint32(body.size()));
+    const quint64 checksum = qToLittleEndian(hash.result());
+
+    QByteArray record;
+    record.reserve(HEADER_SIZE + body.size());
+    record.append(reinterpret_cast<const char*>(&size), 4);
+    record.append(reinterpret_cast<const char*>(&checksum), 8);
+    record.append(body);
+    return record;
+}
+
+qint64 JournalMetadataStore::replay(const QString& filePath, const RecordHandler& handler)
+{
+    QFile file(filePath);
+	if (!file.open(QIODevice::ReadOnly)) // Missing file has no records
+        return 0;
+
+    QByteArray buffer;
+    qint64 bufferStart = 0; // File offset of buffer[0]
+    qint64 position = 0;    // Offset of the next record inside buffer
+
+	// Refill when the next header or body is not complete
+    auto ensure = [&](qint64 needed) {
+        while (buffer.size() - position < needed)
+        {
+            const QByteArray chunk = file.read(qMax(READ_CHUNK, needed));
+            if (chunk.isEmpty())
+                return false;
+
+            buffer = buffer.mid(position) + chunk;
+            bufferStart += position;
+            position = 0;
+        }
+        return true;
+    };
+
+    while (true)
+    {
+        if (!ensure(HEADER_SIZE))
+            break;
+
+        const quint32 size = qFromLittleEndian<quint32>(buffer.constData() + position);
+        const quint64 checksum = qFromLittleEndian<quint64>(buffer.constData() + position + 4);
+		if (size < 5 || size > MAX_RECORD_SIZE || !ensure(HEADER_SIZE + size)) // Torn or corrupt header
+            break;
+
+        const char* body = buffer.constData() + position + HEADER_SIZE;
+        ContentHash hash;
+        hash.addData(body, size);
+		if (hash.result() != checksum) // Torn write
+            break;
+
+        const quint32 keyLength = qFromLittleEndian<quint32>(body + 1);
+		if (5 + qint64(keyLength) > size) // Inconsistent record
+            break;
+
+        const QString key = QString::fromUtf8(body + 5, keyLength);
+        const QByteArray payload(body + 5 + keyLength, size - 5 - keyLength);
+        handler(Operation(quint8(body[0])), key, payload);
+
+        position += HEADER_SIZE + size;
+    }
+
+    return bufferStart + position;
+}
+
+
+// -------------------------
+//   Open / close / load
+// -------------------------
+
+JournalMetadataStore::~JournalMetadataStore()
+{
+    close();
+}
+
+bool JournalMetadataStore::open(const QString& filePath)
+{
+    close();
+
+    const QFileInfo info(filePath);
+    m_snapshotBase = info.absolutePath() + "/" + info.completeBaseName();
+    m_rotatedPath = info.absoluteFilePath() + ".1";
+
+	// Newest generation wins, older ones are leftovers of a mapped snapshot
+    const QDir dir = info.absoluteDir();
+    const QStringList snapshots = dir.entryList({ info.completeBaseName() + ".*.snapshot" }, QDir::Files);
+    m_generation = 0;
+    for (const QString& name : snapshots)
+        m_generation = qMax(m_generation, name.section('.', -2, -2).toInt());
+
+    for (const QString& name : snapshots)
+    {
+        if (name.section('.', -2, -2).toInt() != m_generation)
+            dir.remove(name);
+    }
+
+	// Cut off a record torn by a crash, new records must follow valid data
+    const qint64 validLength = replay(filePath, [](Operation, const QString&, const QByteArray&) {});
+    m_journal.setFileName(filePath);
+    if (!m_journal.open(QIODevice::ReadWrite))
+    {
+        qWarning() << "Cannot open metadata journal" << filePath << m_journal.errorString();
+        return false;
+    }
+
+    if (m_journal.size() > validLength)
+        m_journal.resize(validLength);
+    m_journal.seek(validLength);
+
+	if (QFile::exists(m_rotatedPath)) // Compaction was interrupted, finish it
+        compact();
+
+    return true;
+}
+
+void JournalMetadataStore::close()
+{
+    if (m_journal.isOpen())
+    {
+		if (m_inTransaction) // Keep edits of an unfinished group
+            commit();
+        m_journal.close();
+    }
+
+    waitForCompaction();
+}
+
+QList<PhotoData> JournalMetadataStore::loadAll(QStringList& keys)
+{
+    return loadPrefix(QString(), keys);
+}
+
+// Replay everything, payloads stay encoded
+QHash<QString, QByteArray> JournalMetadataStore::readRecords()
+{
+	waitForCompaction(); // Snapshot must not change while it is read
+
+    QHash<QString, QByteArray> records;
+    const RecordHandler apply = [&](Operation operation, const QString& key, const QByteArray& payload) {
+        if (operation == Put)
+            records.insert(key, payload);
+        else
+            records.remove(key);
+    };
+
+	// Oldest to newest, later records win
+    readSnapshot(snapshotPath(m_generation), records);
+    replay(m_rotatedPath, apply);
+    replay(m_journal.fileName(), apply);
+    return records;
+}
+
+// Decode only the records below the prefix
+QList<PhotoData> JournalMetadataStore::loadPrefix(const QString& prefix, QStringList& keys)
+{
+    const QHash<QString, QByteArray> records = readRecords();
+
+    QList<PhotoData> result;
+    keys.clear();
+    result.reserve(records.size());
+    keys.reserve(records.size());
+
+    for (auto it = records.cbegin(); it != records.cend(); ++it)
+    {
+		if (!it.key().startsWith(prefix)) // Key scan, the payload is not decoded
+            continue;
+
+        PhotoData data = decode(it.value());
+        data.filePath = it.key();
+        keys.append(it.key());
+        result.append(data);
+    }
+    return result;
+}
+
+// Decode one record at a time
+void JournalMetadataStore::forEachRecord(const RecordVisitor& visit)
+{
+    const QHash<QString, QByteArray> records = readRecords();
+    for (auto it = records.cbegin(); it != records.cend(); ++it)
+    {
+        PhotoData data = decode(it.value());
+        data.filePath = it.key();
+        visit(it.key(), data);
+    }
+}
+
+QStringList JournalMetadataStore::loadKeys()
+{
+    return readRecords().keys();
+}
+
+// Map the snapshot, decode only what changed since it was written
+QList<PhotoData> JournalMetadataStore::loadWithSnapshot(std::shared_ptr<const MetadataSnapshot>& snapshot,
+    QStringList& keys, QStringList& removedKeys)
+{
+	waitForCompaction(); // Generation must not change while it is mapped
+
+    snapshot.reset();
+    if (m_generation > 0)
+    {
+        auto mapped = std::make_shared<MetadataSnapshot>();
+        if (mapped->open(snapshotPath(m_generation)))
+            snapshot = mapped;
+        else
+            qWarning() << "Cannot map metadata snapshot" << snapshotPath(m_generation);
+    }
+
+	// Without a usable snapshot everything has to be loaded
+    if (!snapshot)
+    {
+        removedKeys.clear();
+        return loadAll(keys);
+    }
+
+    QHash<QString, QByteArray> changed;
+    QSet<QString> removed;
+    const RecordHandler apply = [&](Operation operation, const QString& key, const QByteArray& payload) {
+        if (operation == Put)
+        {
+            changed.insert(key, payload);
+            removed.remove(key);
+        }
+        else
+        {
+            changed.remove(key);
+            removed.insert(key);
+        }
+    };
+
+    replay(m_rotatedPath, apply);
+    replay(m_journal.fileName(), apply);
+
+    QList<PhotoData> result;
+    keys.clear();
+    result.reserve(changed.size());
+    keys.reserve(changed.size());
+
+    for (auto it = changed.cbegin(); it != changed.cend(); ++it)
+    {
+        PhotoData data = decode(it.value());
+        data.filePath = it.key();
+        keys.append(it.key());
+        result.append(data);
+    }
+
+    removedKeys = QStringList(removed.cbegin(), removed.cend());
+    return result;
+}
+
+bool JournalMetadataStore::isEmpty() const
+{
+    return m_generation == 0
+        && QFileInfo(m_rotatedPath).size() == 0
+        && m_journal.size() == 0;
+}
+
+
+// -------------------------
+//   Writing
+// -------------------------
+
+bool JournalMetadataStore::put(const QString& key, const PhotoData& data)
+{
+    return append(encodeRecord(Put, key, encode(data)));
+}
+
+bool JournalMetadataStore::remove(const QString& key)
+{
+    return append(encodeRecord(Remove, key, {}));
+}
+
+bool JournalMetadataStore::append(const QByteArray& record)
+{
+    if (!m_journal.isOpen())
+        return false;
+
+	if (m_inTransaction) // Written together on commit
+    {
+        m_pending.append(record);
+        return true;
+    }
+
+    const bool written = m_journal.write(record) == record.size()
+		&& m_journal.flush(); // Hand the record to the OS right away
+
+	if (m_journal.size() > COMPACT_THRESHOLD) // Keep replay time bounded
+        compact();
+
+    return written;
+}
+
+bool JournalMetadataStore::beginTransaction()
+{
+    m_inTransaction = true;
+    return isOpen();
+}
+
+bool JournalMetadataStore::commit()
+{
+    m_inTransaction = false;
+    const QByteArray records = m_pending;
+    m_pending.clear();
+
+    return records.isEmpty() || append(records);
+}
+
+bool JournalMetadataStore::rollback()
+{
+    m_inTransaction = false;
+    m_pending.clear();
+    return true;
+}
+
+
+// -------------------------
+//   Compaction
+// -------------------------
+
+void JournalMetadataStore::compact()
+{
+	if (m_compaction && !m_compaction->isFinished()) // One compaction at a time
+        return;
+
+	waitForCompaction(); // Pick up the generation of a finished run
+
+	// Rotate the live journal unless an older rotated journal still waits
+    if (!QFile::exists(m_rotatedPath))
+    {
+        const QString journalPath = m_journal.fileName();
+        m_journal.close();
+
+        if (!QFile::rename(journalPath, m_rotatedPath))
+            qWarning() << "Cannot rotate metadata journal" << journalPath;
+
+        m_journal.setFileName(journalPath);
+        if (!m_journal.open(QIODevice::ReadWrite | QIODevice::Append))
+            return;
+    }
+
+    const QString currentPath = snapshotPath(m_generation);
+    const QString rotatedPath = m_rotatedPath;
+    m_compactedGeneration = m_generation + 1;
+    const QString targetPath = snapshotPath(m_compactedGeneration);
+
+    m_compaction = QThread::create([currentPath, rotatedPath, targetPath]() {
+        compactFiles(currentPath, rotatedPath, targetPath);
+    });
+	m_compaction->start(QThread::LowPriority); // Never compete with the UI
+}
+
+void JournalMetadataStore::waitForCompaction()
+{
+    if (!m_compaction)
+        return;
+
+    m_compaction->wait();
+    delete m_compaction;
+    m_compaction = nullptr;
+
+	if (QFile::exists(snapshotPath(m_compactedGeneration))) // New generation is complete
+        m_generation = m_compactedGeneration;
+}
+
+QString JournalMetadataStore::snapshotPath(int generation) const
+{
+    return m_snapshotBase + "." + QString::number(generation) + ".snapshot";
+}
+
+void JournalMetadataStore::readSnapshot(const QString& filePath, QHash<QString, QByteArray>& records)
+{
+    MetadataSnapshot snapshot;
+	if (!snapshot.open(filePath)) // Missing file has no records
+        return;
+
+    records.reserve(records.size() + snapshot.count());
+    for (int i = 0; i < snapshot.count(); ++i)
+        records.insert(snapshot.key(i), snapshot.payload(i));
+}
+
+bool JournalMetadataStore::compactFiles(const QString& snapshotPath, const QString& rotatedPath, const QString& targetPath)
+{
+	// Latest encoded record per key
+    QHash<QString, QByteArray> records;
+    readSnapshot(snapshotPath, records);
+    replay(rotatedPath, [&](Operation operation, const QString& key, const QByteArray& payload) {
+        if (operation == Put)
+            records.insert(key, payload);
+        else
+            records.remove(key);
+    });
+
+	// Written under a new name, readers may still map the current generation
+    if (!MetadataSnapshot::write(targetPath, records))
+    {
+        qWarning() << "Cannot write metadata snapshot" << targetPath;
+        return false;
+    }
+
+	// Records are in the snapshot now, replaying them again would be harmless
+    const bool merged = QFile::remove(rotatedPath);
+
+	QFile::remove(snapshotPath); // Fails while mapped on some platforms, open() retries
+    return merged;
+}
@@ -0,0 +1,142 @@
+#pragma once
+#include <QFile>
+#include <QHash>
+#include <functional>
+#include "MetadataStore.h"
+
+class QThread;
+
+/**
+ * @class JournalMetadataStore
+ * @brief Metadata store based on an append-only journal and a snapshot.
+ *
+ * @details
+ * Every put() or remove() appends one small checksummed record to the
+ * journal file and flushes it, so the cost of an edit does not depend on
+ * the catalog size and a crash loses at most the record being written.
+ * Loading maps the snapshot and replays only the journal; a torn record
+ * at the end of the journal is detected by its checksum and cut off.
+ *
+ * When the journal grows past COMPACT_THRESHOLD it is rotated and a
+ * background thread merges the snapshot with the rotated journal into a
+ * new snapshot, while new edits go to a fresh journal. Replaying a
+ * record twice is harmless, so every crash point leaves a loadable state.
+ *
+ * Snapshots are MetadataSnapshot files numbered by generation. A new
+ * generation is written next to the old one instead of replacing it, so
+ * a snapshot that is still mapped by a reader is never overwritten.
+ *
+ * Files next to the journal path "<name>.journal":
+ * - "<name>.<generation>.snapshot"  compacted records
+ * - "<name>.journal.1"              journal being compacted
+ *
+ * @see MetadataStore, PhotoMetadataManager
+ */
+class JournalMetadataStore : public MetadataStore {
+public:
+    /// Journal size in bytes that triggers a background compaction.
+    static constexpr qint64 COMPACT_THRESHOLD = 4 * 1024 * 1024;
+
+    JournalMetadataStore() = default;
+
+    /**
+     * @brief Closes the journal and waits for a running compaction.
+     */
+    ~JournalMetadataStore() override;
+
+    bool open(const QString& filePath) override;
+    void close() override;
+    bool isOpen() const override { return m_journal.isOpen(); }
+    QList<PhotoData> loadAll(QStringList& keys) override;
+    QList<PhotoData> loadPrefix(const QString& prefix, QStringList& keys) override;
+    void forEachRecord(const RecordVisitor& visit) override;
+    QStringList loadKeys() override;
+    QList<PhotoData> loadWithSnapshot(std::shared_ptr<const MetadataSnapshot>& snapshot,
+        QStringList& keys, QStringList& removedKeys) override;
+    bool isEmpty() const override;
+    bool put(const QString& key, const PhotoData& data) override;
+    bool remove(const QString& key) override;
+    bool beginTransaction() override;
+    bool commit() override;
+    bool rollback() override;
+
+    /**
+     * @brief Starts compacting the journal into the snapshot in the background.
+     *
+     * @details Does nothing if a compaction is already running.
+     */
+    void compact();
+
+    /**
+     * @brief Blocks until a running compaction has finished.
+     */
+    void waitForCompaction();
+
+private:
+    /**
+     * @brief Kind of a journal record.
+     */
+    enum Operation : quint8 {
+        Put = 1,    ///< Payload holds MetadataStore::encode() of the record.
+        Remove = 2  ///< No payload.
+    };
+
+    /// Receives each valid record while a file is replayed.
+    using RecordHandler = std::function<void(Operation, const QString&, const QByteArray&)>;
+
+    /**
+     * @brief Serializes one record (size, checksum, operation, key, payload).
+     */
+    static QByteArray encodeRecord(Operation operation, const QString& key, const QByteArray& payload);
+
+    /**
+     * @brief Reads all valid records of a file.
+     * @param filePath File to read, a missing file has no records.
+     * @param handler Called for every record in order.
+     * @return Length of the valid prefix of the file in bytes.
+     */
+    static qint64 replay(const QString& filePath, const RecordHandler& handler);
+
+    /**
+     * @brief Merges a snapshot and a rotated journal into a new snapshot.
+     * @param snapshotPath Current snapshot, may be missing.
+     * @param rotatedPath Rotated journal, removed once merged.
+     * @param targetPath New snapshot generation.
+     *
+     * @details Runs on the compaction thread and never touches the live
+     * journal. The current snapshot is removed afterwards if possible.
+     */
+    static bool compactFiles(const QString& snapshotPath, const QString& rotatedPath, const QString& targetPath);
+
+    /**
+     * @brief Reads all encoded records of a snapshot file.
+     * @param filePath Snapshot file, a missing file has no records.
+     * @param records Receives key -> encoded payload.
+     */
+    static void readSnapshot(const QString& filePath, QHash<QString, QByteArray>& records);
+
+    /**
+     * @brief Reads the current encoded record of every photo.
+     * @return Key -> encoded payload, after snapshot and journals are replayed.
+     */
+    QHash<QString, QByteArray> readRecords();
+
+    /**
+     * @brief Returns the file name of a snapshot generation.
+     */
+    QString snapshotPath(int generation) const;
+
+    /**
+     * @brief Writes a record, or buffers it while a transaction is open.
+     */
+    bool append(const QByteArray& record);
+
+    QString m_snapshotBase;          ///< Snapshot path without generation and suffix.
+    int m_generation = 0;            ///< Latest complete snapshot, 0 if there is none.
+    int m_compactedGeneration = 0;   ///< Generation written by the running compaction.
+    QString m_rotatedPath;           ///< Journal waiting for / under compaction.
+    QFile m_journal;                 ///< Live journal, opened for appending.
+    QByteArray m_pending;            ///< Records of the open transaction.
+    bool m_inTransaction = false;    ///< True between beginTransaction() and commit().
+    QThread* m_compaction = nullptr; ///< Background compaction, if started.
+};
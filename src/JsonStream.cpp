@@ -0,0 +1,534 @@
+#include "JsonStream.h"
+#include <QIODevice>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QLocale>
+#include <cmath>
+
+// Bytes read from or passed to the device at once
+static const int CHUNK_SIZE = 64 * 1024;
+
+
+// -------------------------
+//   JsonStreamReader
+// -------------------------
+
+JsonStreamReader::JsonStreamReader(QIODevice* device)
+    : m_device(device)
+{
+}
+
+bool JsonStreamReader::refill()
+{
+    m_consumed += m_buffer.size();
+    m_buffer = m_device->read(CHUNK_SIZE);
+    m_pos = 0;
+    return !m_buffer.isEmpty();
+}
+
+// Next byte without consuming it, -1 at the end of input
+int JsonStreamReader::peek()
+{
+    if (m_pos >= m_buffer.size() && !refill())
+        return -1;
+    return uchar(m_buffer[m_pos]);
+}
+
+int JsonStreamReader::get()
+{
+    const int c = peek();
+    if (c >= 0)
+        ++m_pos;
+    return c;
+}
+
+void JsonStreamReader::skipWhitespace()
+{
+    for (int c = peek(); c == ' ' || c == '\t' || c == '\n' || c == '\r'; c = peek())
+        ++m_pos;
+}
+
+JsonStreamReader::Token JsonStreamReader::fail(const QString& message)
+{
+    m_error = QString("%1 at offset %2").arg(message).arg(m_consumed + m_pos);
+    m_state = Done;
+    return m_token = Invalid;
+}
+
+JsonStreamReader::Token JsonStreamReader::next()
+{
+    for (;;)
+    {
+        skipWhitespace();
+        const int c = peek();
+
+        switch (m_state)
+        {
+        case ExpectValue:
+            return m_token = parseValue();
+
+        case ExpectValueOrEnd:
+			if (c == ']') // Empty array
+            {
+                ++m_pos;
+                return m_token = closeContainer(']');
+            }
+            m_state = ExpectValue;
+            continue;
+
+        case ExpectKeyOrEnd:
+			if (c == '}') // Empty object
+            {
+                ++m_pos;
+                return m_token = closeContainer('}');
+            }
+            m_state = ExpectKey;
+            continue;
+
+        case ExpectKey:
+            if (c != '"')
+                return fail("Expected object key");
+            ++m_pos;
+            if (parseString() == Invalid)
+                return Invalid;
+
+            skipWhitespace();
+            if (get() != ':')
+                return fail("Expected ':'");
+            m_state = ExpectValue;
+            return m_token = Key;
+
+        case ExpectCommaOrEnd:
+			if (m_stack.isEmpty()) // Top-level value is complete, only whitespace may follow
+            {
+                if (c >= 0)
+                    return fail("Unexpected data after document");
+                m_state = Done;
+                return m_token = EndDocument;
+            }
+
+            if (c == ',')
+            {
+                ++m_pos;
+                m_state = m_stack.last() == '{' ? ExpectKey : ExpectValue;
+                continue;
+            }
+            if (c == (m_stack.last() == '{' ? '}' : ']'))
+            {
+                ++m_pos;
+                return m_token = closeContainer(char(c));
+            }
+            return fail("Expected ',' or end of container");
+
+        case Done:
+            return m_token;
+        }
+    }
+}
+
+JsonStreamReader::Token JsonStreamReader::closeContainer(char bracket)
+{
+    m_stack.removeLast();
+    m_state = ExpectCommaOrEnd;
+    return bracket == '}' ? EndObject : EndArray;
+}
+
+JsonStreamReader::Token JsonStreamReader::parseValue()
+{
+    const int c = get();
+    switch (c)
+    {
+    case '{':
+        m_stack.append('{');
+        m_state = ExpectKeyOrEnd;
+        return StartObject;
+
+    case '[':
+        m_stack.append('[');
+        m_state = ExpectValueOrEnd;
+        return StartArray;
+
+    case '"':
+        if (parseString() == Invalid)
+            return Invalid;
+        m_state = ExpectCommaOrEnd;
+        return String;
+
+    case 't': return parseLiteral("rue", Bool, true);
+    case 'f': return parseLiteral("alse", Bool, false);
+    case 'n': return parseLiteral("ull", Null, false);
+
+    case -1:
+        return fail("Unexpected end of input");
+
+    default:
+        if (c == '-' || (c >= '0' && c <= '9'))
+            return parseNumber(char(c));
+        return fail("Unexpected character");
+    }
+}
+
+JsonStreamReader::Token JsonStreamReader::parseLiteral(const char* rest, Token token, bool value)
+{
+    for (const char* p = rest; *p; ++p)
+    {
+        if (get() != *p)
+            return fail("Invalid literal");
+    }
+
+    m_boolean = value;
+    m_state = ExpectCommaOrEnd;
+    return token;
+}
+
+JsonStreamReader::Token JsonStreamReader::parseNumber(char first)
+{
+    QByteArray digits(1, first);
+    for (int c = peek(); (c >= '0' && c <= '9') || c == '.' || c == 'e' || c == 'E' || c == '+' || c == '-'; c = peek())
+    {
+        digits.append(char(c));
+        ++m_pos;
+    }
+
+    bool ok = false;
+    m_number = digits.toDouble(&ok);
+    if (!ok)
+        return fail("Invalid number");
+
+	// Integers stay exact beyond the 53 bits of a double
+    m_integer = digits.toLongLong(&m_isInteger);
+    m_state = ExpectCommaOrEnd;
+    return Number;
+}
+
+// Decode a string after its opening quote into m_text
+JsonStreamReader::Token JsonStreamReader::parseString()
+{
+    QByteArray bytes;
+    for (;;)
+    {
+        if (m_pos >= m_buffer.size() && !refill())
+            return fail("Unterminated string");
+
+		// Copy runs of plain characters at once
+        const char* data = m_buffer.constData();
+        const int start = m_pos;
+        while (m_pos < m_buffer.size() && data[m_pos] != '"' && data[m_pos] != '\\' && uchar(data[m_pos]) >= 0x20)
+            ++m_pos;
+        bytes.append(data + start, m_pos - start);
+
+        if (m_pos == m_buffer.size())
+            continue;
+
+        const char c = data[m_pos++];
+        if (c == '"')
+            break;
+        if (c != '\\')
+            return fail("Control character in string");
+
+        const int escape = get();
+        switch (escape)
+        {
+        case '"':  bytes.append('"'); break;
+        case '\\': bytes.append('\\'); break;
+        case '/':  bytes.append('/'); break;
+        case 'b':  bytes.append('\b'); break;
+        case 'f':  bytes.append('\f'); break;
+        case 'n':  bytes.append('\n'); break;
+        case 'r':  bytes.append('\r'); break;
+        case 't':  bytes.append('\t'); break;
+
+        case 'u': {
+            auto readHex = [this](char32_t& unit) {
+                unit = 0;
+                for (int i = 0; i < 4; ++i)
+                {
+                    const int h = get();
+                    const int digit = (h >= '0' && h <= '9') ? h - '0'
+                        : (h >= 'a' && h <= 'f') ? h - 'a' + 10
+                        : (h >= 'A' && h <= 'F') ? h - 'A' + 10 : -1;
+                    if (digit < 0)
+                        return false;
+                    unit = unit * 16 + char32_t(digit);
+                }
+                return true;
+            };
+
+            char32_t code = 0;
+            if (!readHex(code))
+                return fail("Invalid \\u escape");
+
+			if (code >= 0xD800 && code < 0xDC00) // High surrogate, the low one follows as another escape
+            {
+                char32_t low = 0;
+                if (get() != '\\' || get() != 'u' || !readHex(low) || low < 0xDC00 || low >= 0xE000)
+                    return fail("Invalid surrogate pair");
+                code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+            }
+			else if (code >= 0xDC00 && code < 0xE000) // Lone low surrogate
+                code = 0xFFFD;
+
+            bytes.append(QString::fromUcs4(&code, 1).toUtf8());
+            break;
+        }
+
+        default:
+            return fail("Invalid escape");
+        }
+    }
+
+    m_text = QString::fromUtf8(bytes);
+    return String;
+}
+
+QJsonValue JsonStreamReader::readValue()
+{
+    switch (m_token)
+    {
+    case StartObject: {
+        QJsonObject object;
+        while (next() == Key)
+        {
+            const QString name = m_text;
+            next();
+            const QJsonValue value = readValue();
+            if (value.isUndefined())
+                return QJsonValue(QJsonValue::Undefined);
+            object.insert(name, value);
+        }
+        if (m_token != EndObject)
+            return QJsonValue(QJsonValue::Undefined);
+        return object;
+    }
+
+    case StartArray: {
+        QJsonArray array;
+        while (next() != EndArray)
+        {
+            const QJsonValue value = readValue();
+            if (value.isUndefined())
+                return QJsonValue(QJsonValue::Undefined);
+            array.append(value);
+        }
+        return array;
+    }
+
+    case String: return m_text;
+    case Number: return m_isInteger ? QJsonValue(m_integer) : QJsonValue(m_number);
+    case Bool:   return m_boolean;
+    case Null:   return QJsonValue(QJsonValue::Null);
+    default:     return QJsonValue(QJsonValue::Undefined);
+    }
+}
+
+void JsonStreamReader::skipValue()
+{
+    if (m_token != StartObject && m_token != StartArray)
+        return;
+
+	// Only the nesting depth is tracked, keys and values are dropped
+    for (int depth = 1; depth > 0; )
+    {
+        switch (next())
+        {
+        case StartObject:
+        case StartArray:
+            ++depth;
+            break;
+        case EndObject:
+        case EndArray:
+            --depth;
+            break;
+        case Invalid:
+        case EndDocument:
+            return;
+        default:
+            break;
+        }
+    }
+}
+
+
+// -------------------------
+//   JsonStreamWriter
+// -------------------------
+
+JsonStreamWriter::JsonStreamWriter(QIODevice* device, QJsonDocument::JsonFormat format)
+    : m_device(device),
+      m_compact(format == QJsonDocument::Compact)
+{
+    m_buffer.reserve(CHUNK_SIZE + 1024);
+}
+
+void JsonStreamWriter::flushIfFull()
+{
+    if (m_buffer.size() < CHUNK_SIZE)
+        return;
+
+    if (m_device->write(m_buffer) != m_buffer.size())
+        m_error = true;
+    m_buffer.clear();
+}
+
+bool JsonStreamWriter::finish()
+{
+    if (!m_buffer.isEmpty() && m_device->write(m_buffer) != m_buffer.size())
+        m_error = true;
+    m_buffer.clear();
+    return !m_error;
+}
+
+// Comma, line break and indentation before the next element
+void JsonStreamWriter::separate()
+{
+	if (m_afterKey) // Value of a member stays on the key's line
+    {
+        m_afterKey = false;
+        return;
+    }
+    if (m_levels.isEmpty())
+        return;
+
+    Level& level = m_levels.last();
+    if (!level.empty)
+        m_buffer.append(',');
+    level.empty = false;
+
+    if (!m_compact)
+    {
+        m_buffer.append('\n');
+        m_buffer.append(QByteArray(m_levels.size() * 4, ' '));
+    }
+}
+
+void JsonStreamWriter::beginObject()
+{
+    separate();
+    m_buffer.append('{');
+    m_levels.append({ true, true });
+}
+
+void JsonStreamWriter::beginArray()
+{
+    separate();
+    m_buffer.append('[');
+    m_levels.append({ false, true });
+}
+
+void JsonStreamWriter::endObject()
+{
+    close('}');
+}
+
+void JsonStreamWriter::endArray()
+{
+    close(']');
+}
+
+void JsonStreamWriter::close(char bracket)
+{
+    m_levels.removeLast();
+	if (!m_compact) // Closing bracket on its own line, also for empty containers (as QJsonDocument)
+    {
+        m_buffer.append('\n');
+        m_buffer.append(QByteArray(m_levels.size() * 4, ' '));
+    }
+    m_buffer.append(bracket);
+
+	if (!m_compact && m_levels.isEmpty()) // Document ends with a newline, as QJsonDocument::Indented
+        m_buffer.append('\n');
+    flushIfFull();
+}
+
+void JsonStreamWriter::writeKey(const QString& key)
+{
+    separate();
+    writeString(key);
+    m_buffer.append(m_compact ? ":" : ": ");
+    m_afterKey = true;
+}
+
+void JsonStreamWriter::writeValue(const QJsonValue& value)
+{
+    switch (value.type())
+    {
+    case QJsonValue::Object: {
+        const QJsonObject object = value.toObject();
+        beginObject();
+        for (auto it = object.constBegin(); it != object.constEnd(); ++it)
+        {
+            writeKey(it.key());
+            writeValue(it.value());
+        }
+        endObject();
+        return;
+    }
+
+    case QJsonValue::Array: {
+        beginArray();
+        for (const QJsonValue& element : value.toArray())
+            writeValue(element);
+        endArray();
+        return;
+    }
+
+    case QJsonValue::String:
+        separate();
+        writeString(value.toString());
+        break;
+
+    case QJsonValue::Double: {
+        separate();
+        const double number = value.toDouble();
+        const qint64 integer = value.toInteger();
+		if (!std::isfinite(number)) // Not representable in JSON
+            m_buffer.append("null");
+		else if (integer != 0 || number == 0) // Whole numbers keep all 64 bits
+            m_buffer.append(QByteArray::number(integer));
+        else
+            m_buffer.append(QByteArray::number(number, 'g', QLocale::FloatingPointShortest));
+        break;
+    }
+
+    case QJsonValue::Bool:
+        separate();
+        m_buffer.append(value.toBool() ? "true" : "false");
+        break;
+
+    default:
+        separate();
+        m_buffer.append("null");
+        break;
+    }
+    flushIfFull();
+}
+
+void JsonStreamWriter::writeString(const QString& text)
+{
+    static const char HEX[] = "0123456789abcdef";
+
+    m_buffer.append('"');
+    for (const char c : text.toUtf8())
+    {
+        switch (c)
+        {
+        case '"':  m_buffer.append("\\\""); break;
+        case '\\': m_buffer.append("\\\\"); break;
+        case '\b': m_buffer.append("\\b"); break;
+        case '\f': m_buffer.append("\\f"); break;
+        case '\n': m_buffer.append("\\n"); break;
+        case '\r': m_buffer.append("\\r"); break;
+        case '\t': m_buffer.append("\\t"); break;
+        default:
+			if (uchar(c) < 0x20) // Other control characters
+            {
+                m_buffer.append("\\u00");
+                m_buffer.append(HEX[uchar(c) >> 4]);
+                m_buffer.append(HEX[uchar(c) & 15]);
+            }
+            else
+                m_buffer.append(c);
+        }
+    }
+    m_buffer.append('"');
+}
@@ -0,0 +1,218 @@
+#pragma once
+#include <QByteArray>
+#include <QJsonDocument>
+#include <QJsonValue>
+#include <QList>
+#include <QString>
+
+class QIODevice;
+
+/**
+ * @class JsonStreamReader
+ * @brief Event-based JSON parser reading a device in fixed-size chunks.
+ *
+ * @details
+ * Instead of building a QJsonDocument of the whole input, next() returns
+ * one token at a time (start/end of containers, keys and scalar values).
+ * Only the current chunk and the current token are held in memory, so
+ * catalogs of any size are parsed with bounded memory. Small sub-trees,
+ * like a single photo entry, can be materialized with readValue().
+ *
+ * @code
+ * JsonStreamReader reader(&file);
+ * if (reader.next() == JsonStreamReader::StartObject)
+ *     while (reader.next() == JsonStreamReader::Key) { ... }
+ * @endcode
+ *
+ * @see JsonStreamWriter
+ */
+class JsonStreamReader {
+public:
+    /**
+     * @brief Kind of the current token.
+     */
+    enum Token {
+        Invalid,      ///< Syntax or read error, see errorString().
+        StartObject,  ///< '{'
+        EndObject,    ///< '}'
+        StartArray,   ///< '['
+        EndArray,     ///< ']'
+        Key,          ///< Object member name, see text().
+        String,       ///< String value, see text().
+        Number,       ///< Number value, see number().
+        Bool,         ///< true or false, see boolean().
+        Null,         ///< null
+        EndDocument   ///< Whole input consumed.
+    };
+
+    /**
+     * @brief Creates a reader for an open device.
+     * @param device Device positioned at the start of the document.
+     */
+    explicit JsonStreamReader(QIODevice* device);
+
+    /**
+     * @brief Reads the next token.
+     * @return Token kind, Invalid on error and EndDocument at the end.
+     */
+    Token next();
+
+    /**
+     * @brief Returns the token read by the last next().
+     * @return Current token kind.
+     */
+    Token token() const { return m_token; }
+
+    /**
+     * @brief Returns the text of a Key or String token.
+     * @return Decoded string.
+     */
+    const QString& text() const { return m_text; }
+
+    /**
+     * @brief Returns the value of a Number token.
+     * @return Number as double.
+     */
+    double number() const { return m_number; }
+
+    /**
+     * @brief Returns the value of a Bool token.
+     * @return True for true.
+     */
+    bool boolean() const { return m_boolean; }
+
+    /**
+     * @brief Materializes the value starting at the current token.
+     * @return Value; Undefined if the current token does not start a value
+     *         or the input is malformed.
+     *
+     * @details Afterwards the current token is the last one of the value.
+     * Integers that fit into 64 bits are kept exact, as by QJsonDocument.
+     */
+    QJsonValue readValue();
+
+    /**
+     * @brief Skips the value starting at the current token.
+     *
+     * @details Containers are skipped token by token without building them.
+     */
+    void skipValue();
+
+    /**
+     * @brief Checks whether reading stopped on an error.
+     * @return True after an Invalid token.
+     */
+    bool hasError() const { return m_token == Invalid; }
+
+    /**
+     * @brief Returns a description of the error.
+     * @return Message with the byte offset, empty without error.
+     */
+    const QString& errorString() const { return m_error; }
+
+private:
+    /**
+     * @brief Parser position between tokens.
+     */
+    enum State {
+        ExpectValue,        ///< Value (document start, after ':' or ',' in arrays).
+        ExpectValueOrEnd,   ///< After '['.
+        ExpectKey,          ///< After ',' in objects.
+        ExpectKeyOrEnd,     ///< After '{'.
+        ExpectCommaOrEnd,   ///< After a complete value.
+        Done                ///< End of document or error.
+    };
+
+    int peek();
+    int get();
+    bool refill();
+    void skipWhitespace();
+
+    Token parseValue();
+    Token parseString();
+    Token parseNumber(char first);
+    Token parseLiteral(const char* rest, Token token, bool value);
+    Token closeContainer(char bracket);
+    Token fail(const QString& message);
+
+    QIODevice* m_device;     ///< Input, not owned.
+    QByteArray m_buffer;     ///< Current chunk.
+    int m_pos = 0;           ///< Read position in m_buffer.
+    qint64 m_consumed = 0;   ///< Bytes of earlier chunks, for error offsets.
+    QList<char> m_stack;     ///< Open containers, '{' or '['.
+    State m_state = ExpectValue;
+
+    Token m_token = Invalid;
+    QString m_text;
+    double m_number = 0;
+    qint64 m_integer = 0;    ///< Exact value of integral numbers.
+    bool m_isInteger = false;
+    bool m_boolean = false;
+    QString m_error;
+};
+
+/**
+ * @class JsonStreamWriter
+ * @brief Incremental JSON writer with indented or compact output.
+ *
+ * @details
+ * Containers are opened and closed explicitly and values are written as
+ * they come, so a catalog is exported without building a QJsonArray of
+ * all entries. Output is buffered in small chunks and passed to the
+ * device as the buffer fills.
+ *
+ * @see JsonStreamReader
+ */
+class JsonStreamWriter {
+public:
+    /**
+     * @brief Creates a writer for an open device.
+     * @param device Output device.
+     * @param format Indented (4 spaces, as QJsonDocument) or Compact.
+     */
+    explicit JsonStreamWriter(QIODevice* device, QJsonDocument::JsonFormat format = QJsonDocument::Indented);
+
+    void beginObject();
+    void endObject();
+    void beginArray();
+    void endArray();
+
+    /**
+     * @brief Writes an object member name, the next value belongs to it.
+     * @param key Member name.
+     */
+    void writeKey(const QString& key);
+
+    /**
+     * @brief Writes a complete value, containers included.
+     * @param value Value to write; Undefined is written as null.
+     */
+    void writeValue(const QJsonValue& value);
+
+    /**
+     * @brief Passes the remaining output to the device.
+     * @return True if all output was written.
+     */
+    bool finish();
+
+private:
+    /**
+     * @brief Open container.
+     */
+    struct Level {
+        bool object;  ///< True for '{', false for '['.
+        bool empty;   ///< True until the first element.
+    };
+
+    void separate();
+    void close(char bracket);
+    void writeString(const QString& text);
+    void flushIfFull();
+
+    QIODevice* m_device;     ///< Output, not owned.
+    bool m_compact;
+    QByteArray m_buffer;     ///< Output not yet passed to the device.
+    QList<Level> m_levels;   ///< Open containers.
+    bool m_afterKey = false; ///< Next value follows a key on the same line.
+    bool m_error = false;    ///< A device write failed.
+};
@@ -0,0 +1,321 @@
+#include "MetadataPersistence.h"
+#include "ShardedMetadataStore.h"
+#include <QThread>
+#include <QTimer>
+#include <QMutexLocker>
+
+// Constructor - worker thread owns the store from now on
+MetadataPersistence::MetadataPersistence(std::unique_ptr<MetadataStore> store)
+    : m_store(std::move(store)),
+      m_thread(new QThread())
+{
+    m_timer = new QTimer(this);
+    m_timer->setSingleShot(true);
+    m_timer->setInterval(COALESCE_MS);
+    connect(m_timer, &QTimer::timeout, this, [this]() {
+        {
+            QMutexLocker locker(&m_mutex);
+			if (m_holdCount > 0) // Bulk edit in progress, release() reschedules
+            {
+                m_scheduled = false;
+                return;
+            }
+        }
+        writePending();
+        });
+
+	moveToThread(m_thread); // Timer is a child and moves along
+    m_thread->setObjectName("MetadataPersistence");
+    m_thread->start(QThread::LowPriority);
+}
+
+MetadataPersistence::~MetadataPersistence()
+{
+    shutdown();
+}
+
+void MetadataPersistence::shutdown()
+{
+	if (!m_thread) // Already stopped
+        return;
+
+	QThread* caller = QThread::currentThread(); // Object must not outlive its thread
+    runOnWorker([this, caller]() {
+        writePending();
+        m_timer->stop();
+        m_store->close();
+        moveToThread(caller);
+    });
+
+    m_thread->quit();
+    m_thread->wait();
+    delete m_thread;
+    m_thread = nullptr;
+}
+
+// Execute on the worker thread, directly if already there
+template <typename Function>
+void MetadataPersistence::runOnWorker(Function function)
+{
+    if (!m_thread)
+        return;
+
+    if (QThread::currentThread() == m_thread)
+        function();
+    else
+        QMetaObject::invokeMethod(this, function, Qt::BlockingQueuedConnection);
+}
+
+
+// -------------------------
+//   Store access
+// -------------------------
+
+bool MetadataPersistence::open(const QString& filePath)
+{
+    bool opened = false;
+    runOnWorker([&]() { opened = m_store->open(filePath); });
+    return opened;
+}
+
+QList<PhotoData> MetadataPersistence::loadAll(QStringList& keys)
+{
+    QList<PhotoData> records;
+    runOnWorker([&]() {
+		if (!isHeld()) // A held batch stays one transaction, it is merged below instead
+            writePending();
+        records = m_store->loadAll(keys);
+		applyPending(nullptr, records, keys, nullptr); // Loaded state must include recorded edits
+    });
+    return records;
+}
+
+void MetadataPersistence::forEachRecord(const MetadataStore::RecordVisitor& visit)
+{
+    runOnWorker([&]() {
+        if (!isHeld())
+            writePending();
+
+        QHash<QString, std::optional<PhotoData>> pending;
+        {
+            QMutexLocker locker(&m_mutex);
+            pending = m_pending;
+        }
+
+		// Stored states replaced by pending ones are visited from the batch
+        m_store->forEachRecord([&](const QString& key, const PhotoData& data) {
+            if (!pending.contains(key))
+                visit(key, data);
+        });
+
+        for (auto it = pending.cbegin(); it != pending.cend(); ++it)
+        {
+            if (it.value())
+                visit(it.key(), *it.value());
+        }
+    });
+}
+
+QStringList MetadataPersistence::loadKeys()
+{
+    QStringList keys;
+    runOnWorker([&]() {
+        if (!isHeld())
+            writePending();
+        const QStringList stored = m_store->loadKeys();
+
+        QMutexLocker locker(&m_mutex);
+        for (const QString& key : stored)
+        {
+			if (!m_pending.contains(key)) // Pending keys are added below, unless removed
+                keys.append(key);
+        }
+        for (auto it = m_pending.cbegin(); it != m_pending.cend(); ++it)
+        {
+            if (it.value())
+                keys.append(it.key());
+        }
+    });
+    return keys;
+}
+
+QList<PhotoData> MetadataPersistence::loadRoot(const QString& root, std::shared_ptr<const MetadataSnapshot>& snapshot,
+    QStringList& keys, QStringList& removedKeys)
+{
+    QList<PhotoData> records;
+    runOnWorker([&]() {
+        if (!isHeld())
+            writePending();
+        records = m_store->loadRoot(root, snapshot, keys, removedKeys);
+		applyPending(&root, records, keys, &removedKeys); // Loaded state must include recorded edits
+    });
+    return records;
+}
+
+QStringList MetadataPersistence::roots()
+{
+    QStringList result;
+    runOnWorker([&]() { result = m_store->roots(); });
+    return result;
+}
+
+bool MetadataPersistence::addRoot(const QString& root)
+{
+    bool added = false;
+	// Pending records stay queued, put() and remove() route them to the new owner when written
+    runOnWorker([&]() { added = m_store->addRoot(root); });
+    return added;
+}
+
+bool MetadataPersistence::isEmpty()
+{
+    bool empty = true;
+    runOnWorker([&]() {
+        QMutexLocker locker(&m_mutex);
+        empty = m_pending.isEmpty() && m_store->isEmpty();
+    });
+    return empty;
+}
+
+bool MetadataPersistence::flush()
+{
+    bool written = true;
+    runOnWorker([&]() { written = writePending(); });
+    return written;
+}
+
+
+// -------------------------
+//   Change tracking
+// -------------------------
+
+void MetadataPersistence::markDirty(const QString& key, const PhotoData& data)
+{
+    QMutexLocker locker(&m_mutex);
+	m_pending.insert(key, data); // Replaces an older unsaved state
+
+	if (!m_scheduled && m_holdCount == 0) // First change of a burst
+    {
+        m_scheduled = true;
+        QMetaObject::invokeMethod(this, &MetadataPersistence::scheduleWrite, Qt::QueuedConnection);
+    }
+}
+
+void MetadataPersistence::markRemoved(const QString& key)
+{
+    QMutexLocker locker(&m_mutex);
+    m_pending.insert(key, std::nullopt);
+
+    if (!m_scheduled && m_holdCount == 0)
+    {
+        m_scheduled = true;
+        QMetaObject::invokeMethod(this, &MetadataPersistence::scheduleWrite, Qt::QueuedConnection);
+    }
+}
+
+void MetadataPersistence::hold()
+{
+    QMutexLocker locker(&m_mutex);
+    ++m_holdCount;
+}
+
+void MetadataPersistence::release()
+{
+    QMutexLocker locker(&m_mutex);
+	if (m_holdCount == 0 || --m_holdCount > 0) // Still held by an outer caller
+        return;
+
+	if (!m_pending.isEmpty() && !m_scheduled) // Write what was collected during the hold
+    {
+        m_scheduled = true;
+        QMetaObject::invokeMethod(this, &MetadataPersistence::scheduleWrite, Qt::QueuedConnection);
+    }
+}
+
+void MetadataPersistence::scheduleWrite()
+{
+	m_timer->start(); // Further edits within the window join this write
+}
+
+bool MetadataPersistence::writePending()
+{
+    QHash<QString, std::optional<PhotoData>> batch;
+    {
+        QMutexLocker locker(&m_mutex);
+		batch.swap(m_pending); // GUI thread can keep recording while we write
+        m_scheduled = false;
+    }
+
+    if (batch.isEmpty())
+        return true;
+
+    bool written = m_store->beginTransaction();
+    for (auto it = batch.cbegin(); written && it != batch.cend(); ++it)
+    {
+        if (it.value())
+            written = m_store->put(it.key(), *it.value());
+        else
+            written = m_store->remove(it.key());
+    }
+
+    if (written)
+        written = m_store->commit();
+    if (written)
+        return true;
+
+	m_store->rollback(); // Nothing of the batch is stored
+    QMutexLocker locker(&m_mutex);
+    for (auto it = batch.cbegin(); it != batch.cend(); ++it)
+    {
+		if (!m_pending.contains(it.key())) // Recorded meanwhile, the newer state wins
+            m_pending.insert(it.key(), it.value());
+    }
+    return false;
+}
+
+bool MetadataPersistence::isHeld()
+{
+    QMutexLocker locker(&m_mutex);
+    return m_holdCount > 0;
+}
+
+void MetadataPersistence::applyPending(const QString* root, QList<PhotoData>& records, QStringList& keys,
+    QStringList* removedKeys)
+{
+    QHash<QString, std::optional<PhotoData>> pending;
+    {
+        QMutexLocker locker(&m_mutex);
+        pending = m_pending;
+    }
+
+    if (pending.isEmpty())
+        return;
+
+	for (int i = keys.size() - 1; i >= 0; --i) // Stored states replaced by pending ones
+    {
+        if (pending.contains(keys[i]))
+        {
+            keys.removeAt(i);
+            records.removeAt(i);
+        }
+    }
+
+    const QStringList roots = m_store->roots();
+    for (auto it = pending.cbegin(); it != pending.cend(); ++it)
+    {
+		if (root && ShardedMetadataStore::ownerRoot(roots, it.key()) != *root) // Belongs to another root
+            continue;
+
+        if (it.value())
+        {
+            keys.append(it.key());
+            records.append(*it.value());
+            if (removedKeys)
+                removedKeys->removeAll(it.key());
+        }
+        else if (removedKeys && !removedKeys->contains(it.key()))
+        {
+			removedKeys->append(it.key()); // Masks the snapshot entry
+        }
+    }
+}
@@ -0,0 +1,204 @@
+#pragma once
+#include <QObject>
+#include <QHash>
+#include <QMutex>
+#include <memory>
+#include <optional>
+#include "MetadataStore.h"
+#include "PhotoMetadata.h"
+
+class QThread;
+class QTimer;
+
+/**
+ * @class MetadataPersistence
+ * @brief Writes metadata changes to a MetadataStore on a background thread.
+ *
+ * @details
+ * The GUI thread only records which photos changed (markDirty(),
+ * markRemoved()). Changes arriving within COALESCE_MS of each other are
+ * collected, repeated edits of one photo collapse into its latest state,
+ * and the whole batch is written in a single store transaction on the
+ * worker thread. flush() blocks until everything recorded so far is
+ * stored and is meant for shutdown and explicit saves.
+ *
+ * The store is opened, used and closed only on the worker thread, which
+ * is required by QtSql connections.
+ *
+ * @see MetadataStore, PhotoMetadataManager
+ */
+class MetadataPersistence : public QObject {
+    Q_OBJECT
+
+public:
+    /// Time in milliseconds during which edits are collected into one write.
+    static const int COALESCE_MS = 250;
+
+    /**
+     * @brief Starts the worker thread.
+     * @param store Store to write to, owned by this object.
+     */
+    explicit MetadataPersistence(std::unique_ptr<MetadataStore> store);
+
+    /**
+     * @brief Flushes pending changes and stops the worker thread.
+     */
+    ~MetadataPersistence() override;
+
+    // --- Store access (blocking, executed on the worker thread) ---
+
+    /**
+     * @brief Opens the store.
+     * @param filePath Path to the store file.
+     * @return True if the store is ready.
+     */
+    bool open(const QString& filePath);
+
+    /**
+     * @brief Reads all records, including pending changes.
+     * @param keys Receives the absolute photo path of each record.
+     * @return Stored records in the same order as keys.
+     */
+    QList<PhotoData> loadAll(QStringList& keys);
+
+    /**
+     * @brief Visits all records one at a time, including pending changes.
+     * @param visit Called on the worker thread for every record while the caller waits.
+     *
+     * @see MetadataStore::forEachRecord()
+     */
+    void forEachRecord(const MetadataStore::RecordVisitor& visit);
+
+    /**
+     * @brief Reads the paths of all records, including pending changes.
+     * @return Absolute photo paths.
+     *
+     * @see MetadataStore::loadKeys()
+     */
+    QStringList loadKeys();
+
+    /**
+     * @brief Loads one root of the store, including pending changes.
+     * @param root Root returned by roots().
+     * @param snapshot Receives the mapped snapshot, null if there is none.
+     * @param keys Receives the paths of records newer than the snapshot.
+     * @param removedKeys Receives the paths deleted after the snapshot.
+     * @return Records newer than the snapshot in the same order as keys.
+     *
+     * @see MetadataStore::loadRoot()
+     */
+    QList<PhotoData> loadRoot(const QString& root, std::shared_ptr<const MetadataSnapshot>& snapshot,
+        QStringList& keys, QStringList& removedKeys);
+
+    /**
+     * @brief Returns the roots the store is split into.
+     * @return Root folders, "" included.
+     *
+     * @see MetadataStore::roots()
+     */
+    QStringList roots();
+
+    /**
+     * @brief Gives a folder its own part of the store.
+     * @param root Absolute folder path.
+     * @return True if the folder is a root afterwards.
+     *
+     * @see MetadataStore::addRoot()
+     */
+    bool addRoot(const QString& root);
+
+    /**
+     * @brief Checks whether the store holds no records.
+     * @return True for a new store.
+     */
+    bool isEmpty();
+
+    /**
+     * @brief Writes all pending changes and waits until they are stored.
+     * @return True if the store accepted the changes.
+     *
+     * @details Changes of a failed write stay pending and are retried by
+     * the next write, flush() returns false until one succeeds.
+     */
+    bool flush();
+
+    /**
+     * @brief Flushes and closes the store, then stops the worker thread.
+     *
+     * @details Called by the destructor, may be called earlier to shut
+     * down while the application object still exists.
+     */
+    void shutdown();
+
+    // --- Change tracking (GUI thread, non-blocking) ---
+
+    /**
+     * @brief Records the new state of a photo.
+     * @param key Absolute path to the photo file.
+     * @param data Metadata to store.
+     */
+    void markDirty(const QString& key, const PhotoData& data);
+
+    /**
+     * @brief Records that a photo's metadata was deleted.
+     * @param key Absolute path to the photo file.
+     */
+    void markRemoved(const QString& key);
+
+    /**
+     * @brief Holds back writes until release() (e.g. during bulk edits).
+     */
+    void hold();
+
+    /**
+     * @brief Ends a hold() and schedules the collected changes.
+     */
+    void release();
+
+private slots:
+    /**
+     * @brief Starts the coalescing timer (worker thread).
+     */
+    void scheduleWrite();
+
+    /**
+     * @brief Writes all pending changes in one transaction (worker thread).
+     * @return True on success; on failure the batch is rolled back and
+     *         queued again behind changes recorded meanwhile.
+     */
+    bool writePending();
+
+private:
+    /**
+     * @brief Checks whether writes are held back by hold().
+     */
+    bool isHeld();
+
+    /**
+     * @brief Merges pending changes into loaded records (worker thread).
+     * @param root Root the records were loaded for, nullptr for the whole store.
+     * @param records Loaded records, updated in place.
+     * @param keys Paths parallel to @p records, updated in place.
+     * @param removedKeys Paths deleted after the snapshot, nullptr if not loaded.
+     *
+     * @details Loads within a hold() do not write the collected batch,
+     * which must stay one transaction; its states are merged instead.
+     */
+    void applyPending(const QString* root, QList<PhotoData>& records, QStringList& keys,
+        QStringList* removedKeys);
+
+    /**
+     * @brief Runs a function on the worker thread and waits for it.
+     */
+    template <typename Function>
+    void runOnWorker(Function function);
+
+    std::unique_ptr<MetadataStore> m_store;  ///< Store, used only on the worker thread.
+    QThread* m_thread = nullptr;             ///< Worker thread.
+    QTimer* m_timer = nullptr;               ///< Coalescing timer living on the worker thread.
+
+    QMutex m_mutex;                          ///< Guards the members below.
+    QHash<QString, std::optional<PhotoData>> m_pending; ///< Latest state per changed photo, nullopt = removed.
+    bool m_scheduled = false;                ///< True if a write is already scheduled.
+    int m_holdCount = 0;                     ///< Nesting level of hold().
+};
@@ -0,0 +1,182 @@
+#include "MetadataSnapshot.h"
+#include "MetadataStore.h"
+#include "PhotoMetadata.h"
+#include <QSaveFile>
+#include <QtEndian>
+#include <algorithm>
+#include <cstring>
+
+// File identification
+static const char MAGIC[8] = { 'T', 'S', 'S', 'M', 'E', 'T', 'A', '1' };
+static const quint32 VERSION = 1;
+static const int HEADER_SIZE = 8 + 4 + 4 + 8;
+
+MetadataSnapshot::~MetadataSnapshot()
+{
+    if (m_data)
+        m_file.unmap(const_cast<uchar*>(m_data));
+}
+
+// Map the file and validate the header and record bounds, payloads are not touched
+bool MetadataSnapshot::open(const QString& filePath)
+{
+    m_file.setFileName(filePath);
+    if (!m_file.open(QIODevice::ReadOnly) || m_file.size() < HEADER_SIZE)
+        return false;
+
+    m_size = m_file.size();
+    uchar* data = m_file.map(0, m_size);
+	if (!data) // Mapping not supported
+        return false;
+
+    const quint32 version = qFromLittleEndian<quint32>(data + 8);
+    const quint32 count = qFromLittleEndian<quint32>(data + 12);
+    const quint64 indexOffset = qFromLittleEndian<quint64>(data + 16);
+
+	// Reject foreign files and truncated snapshots
+    if (std::memcmp(data, MAGIC, 8) != 0 || version != VERSION || indexOffset < quint64(HEADER_SIZE)
+        || indexOffset > quint64(m_size) || indexOffset + quint64(count) * 8 != quint64(m_size)
+        || !recordsInBounds(data, count, indexOffset))
+    {
+        m_file.unmap(data);
+        return false;
+    }
+
+    m_data = data;
+    m_count = count;
+    m_index = data + indexOffset;
+    return true;
+}
+
+// Every record must lie between the header and the offset table, lookups rely on it
+bool MetadataSnapshot::recordsInBounds(const uchar* data, quint32 count, quint64 indexOffset)
+{
+    const uchar* index = data + indexOffset;
+    for (quint32 i = 0; i < count; ++i)
+    {
+        const quint64 offset = qFromLittleEndian<quint64>(index + quint64(i) * 8);
+        if (offset < quint64(HEADER_SIZE) || offset > indexOffset || indexOffset - offset < 8)
+            return false;
+
+        const quint64 keyLength = qFromLittleEndian<quint32>(data + offset);
+		if (keyLength > indexOffset - offset - 8) // Key and payload length field
+            return false;
+
+        const quint64 payloadLength = qFromLittleEndian<quint32>(data + offset + 4 + keyLength);
+        if (payloadLength > indexOffset - offset - 8 - keyLength)
+            return false;
+    }
+    return true;
+}
+
+const uchar* MetadataSnapshot::record(int index) const
+{
+    return m_data + qFromLittleEndian<quint64>(m_index + quint64(index) * 8);
+}
+
+QString MetadataSnapshot::key(int index) const
+{
+    const uchar* rec = record(index);
+    const quint32 keyLength = qFromLittleEndian<quint32>(rec);
+    return QString::fromUtf8(reinterpret_cast<const char*>(rec + 4), keyLength);
+}
+
+QByteArray MetadataSnapshot::payload(int index) const
+{
+    const uchar* rec = record(index);
+    const quint32 keyLength = qFromLittleEndian<quint32>(rec);
+    const uchar* payloadStart = rec + 4 + keyLength;
+    const quint32 payloadLength = qFromLittleEndian<quint32>(payloadStart);
+
+	// Copy, the mapping may go away before the caller is done
+    return QByteArray(reinterpret_cast<const char*>(payloadStart + 4), payloadLength);
+}
+
+PhotoData MetadataSnapshot::entry(int index) const
+{
+    PhotoData data = MetadataStore::decode(payload(index));
+    data.filePath = key(index);
+    return data;
+}
+
+// Binary search over the sorted offset table, comparing raw UTF-8 bytes
+int MetadataSnapshot::find(const QString& key) const
+{
+    if (!m_data)
+        return -1;
+
+    const QByteArray wanted = key.toUtf8();
+    int low = 0;
+    int high = int(m_count) - 1;
+
+    while (low <= high)
+    {
+        const int middle = low + (high - low) / 2;
+        const uchar* rec = record(middle);
+        const quint32 keyLength = qFromLittleEndian<quint32>(rec);
+
+        const int common = int(qMin<qint64>(keyLength, wanted.size()));
+        int order = std::memcmp(rec + 4, wanted.constData(), common);
+        if (order == 0)
+            order = keyLength < quint32(wanted.size()) ? -1 : (keyLength > quint32(wanted.size()) ? 1 : 0);
+
+        if (order == 0)
+            return middle;
+        if (order < 0)
+            low = middle + 1;
+        else
+            high = middle - 1;
+    }
+    return -1;
+}
+
+// Records in key order followed by the offset table
+bool MetadataSnapshot::write(const QString& filePath, const QHash<QString, QByteArray>& records)
+{
+    QList<QPair<QByteArray, QByteArray>> sorted;
+    sorted.reserve(records.size());
+    for (auto it = records.cbegin(); it != records.cend(); ++it)
+        sorted.append(qMakePair(it.key().toUtf8(), it.value()));
+
+	// Byte order of UTF-8 keys, the same order find() relies on
+    std::sort(sorted.begin(), sorted.end(),
+        [](const QPair<QByteArray, QByteArray>& a, const QPair<QByteArray, QByteArray>& b) { return a.first < b.first; });
+
+    QSaveFile file(filePath);
+    if (!file.open(QIODevice::WriteOnly))
+        return false;
+
+    auto writeValue = [&file](auto value) {
+        const auto little = qToLittleEndian(value);
+        file.write(reinterpret_cast<const char*>(&little), sizeof(little));
+    };
+
+	// Header, index offset is known once all records are laid out
+    quint64 indexOffset = HEADER_SIZE;
+    for (const auto& record : std::as_const(sorted))
+        indexOffset += 4 + record.first.size() + 4 + record.second.size();
+
+    file.write(MAGIC, 8);
+    writeValue(VERSION);
+    writeValue(quint32(sorted.size()));
+    writeValue(indexOffset);
+
+    QList<quint64> offsets;
+    offsets.reserve(sorted.size());
+    quint64 offset = HEADER_SIZE;
+
+    for (const auto& record : std::as_const(sorted))
+    {
+        offsets.append(offset);
+        writeValue(quint32(record.first.size()));
+        file.write(record.first);
+        writeValue(quint32(record.second.size()));
+        file.write(record.second);
+        offset += 4 + record.first.size() + 4 + record.second.size();
+    }
+
+    for (quint64 recordOffset : std::as_const(offsets))
+        writeValue(recordOffset);
+
+    return file.commit();
+}
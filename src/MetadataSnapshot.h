@@ -0,0 +1,113 @@
+#pragma once
+#include <QFile>
+#include <QHash>
+#include <QString>
+#include <QByteArray>
+
+struct PhotoData;
+
+/**
+ * @class MetadataSnapshot
+ * @brief Read-only, memory-mapped binary catalog of photo metadata.
+ *
+ * @details
+ * The file is mapped into memory and queried in place: opening it
+ * validates the header and checks that every record (its length fields
+ * included) lies inside the record area, without decoding any payload.
+ * A corrupt or truncated file is rejected, so lookups never read outside
+ * the mapping. Keys are located by binary search over a sorted offset table
+ * and PhotoData is decoded only for entries that are actually requested.
+ *
+ * File layout (little endian):
+ * @code
+ * header   "TSSMETA1", quint32 version, quint32 count, quint64 indexOffset
+ * records  { quint32 keyLength, UTF-8 key, quint32 payloadLength, payload }...
+ * index    quint64 record offset, count entries sorted by UTF-8 key bytes
+ * @endcode
+ * The payload is MetadataStore::encode() of the entry.
+ *
+ * @see JournalMetadataStore, PhotoMetadataManager
+ */
+class MetadataSnapshot {
+public:
+    MetadataSnapshot() = default;
+    ~MetadataSnapshot();
+
+    Q_DISABLE_COPY(MetadataSnapshot)
+
+    /**
+     * @brief Maps a snapshot file.
+     * @param filePath Snapshot file.
+     * @return True if the file is a valid snapshot.
+     */
+    bool open(const QString& filePath);
+
+    /**
+     * @brief Checks whether a snapshot is mapped.
+     * @return True after a successful open().
+     */
+    bool isValid() const { return m_data != nullptr; }
+
+    /**
+     * @brief Returns the number of entries.
+     * @return Entry count, 0 if invalid.
+     */
+    int count() const { return int(m_count); }
+
+    /**
+     * @brief Finds an entry by key.
+     * @param key Absolute photo path.
+     * @return Entry index, or -1 if not present.
+     */
+    int find(const QString& key) const;
+
+    /**
+     * @brief Returns the key of an entry.
+     * @param index Entry index (0 <= index < count()).
+     * @return Absolute photo path.
+     */
+    QString key(int index) const;
+
+    /**
+     * @brief Returns the encoded payload of an entry without decoding it.
+     * @param index Entry index.
+     * @return MetadataStore::encode() bytes.
+     */
+    QByteArray payload(int index) const;
+
+    /**
+     * @brief Decodes an entry.
+     * @param index Entry index.
+     * @return PhotoData with filePath set to the key.
+     */
+    PhotoData entry(int index) const;
+
+    /**
+     * @brief Writes a snapshot file.
+     * @param filePath Target file, replaced atomically.
+     * @param records Key -> encoded payload of every entry.
+     * @return True on success.
+     */
+    static bool write(const QString& filePath, const QHash<QString, QByteArray>& records);
+
+private:
+    /**
+     * @brief Returns a pointer to the record of an entry.
+     */
+    const uchar* record(int index) const;
+
+    /**
+     * @brief Checks the offset and lengths of every record against the record area.
+     * @param data Start of the mapping.
+     * @param count Number of entries.
+     * @param indexOffset Start of the offset table, end of the record area.
+     * @return True if no record extends past the record area.
+     */
+    static bool recordsInBounds(const uchar* data, quint32 count, quint64 indexOffset);
+
+    QFile m_file;                  ///< Mapped file.
+    const uchar* m_data = nullptr; ///< Start of the mapping.
+    qint64 m_size = 0;             ///< Size of the mapping.
+    quint32 m_count = 0;           ///< Number of entries.
+    const uchar* m_index = nullptr; ///< Start of the offset table.
+};
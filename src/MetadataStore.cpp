@@ -0,0 +1,72 @@
+#include "MetadataStore.h"
+#include "PhotoMetadata.h"
+#include "MetadataSnapshot.h"
+#include <QCborValue>
+#include <QCborMap>
+
+// Records share the JSON field names, stored in binary form
+QByteArray MetadataStore::encode(const PhotoData& data)
+{
+    return QCborValue::fromJsonValue(data.toJson()).toCbor();
+}
+
+PhotoData MetadataStore::decode(const QByteArray& bytes)
+{
+    return PhotoData::fromJson(QCborValue::fromCbor(bytes).toMap().toJsonObject());
+}
+
+// Backends without a range query decode everything and filter
+QList<PhotoData> MetadataStore::loadPrefix(const QString& prefix, QStringList& keys)
+{
+    QStringList allKeys;
+    const QList<PhotoData> records = loadAll(allKeys);
+
+    QList<PhotoData> result;
+    keys.clear();
+    for (int i = 0; i < records.size(); ++i)
+    {
+        if (!allKeys[i].startsWith(prefix))
+            continue;
+        keys.append(allKeys[i]);
+        result.append(records[i]);
+    }
+    return result;
+}
+
+// Backends without a cursor decode everything at once
+void MetadataStore::forEachRecord(const RecordVisitor& visit)
+{
+    QStringList keys;
+    const QList<PhotoData> records = loadAll(keys);
+    for (int i = 0; i < records.size(); ++i)
+        visit(keys[i], records[i]);
+}
+
+QStringList MetadataStore::loadKeys()
+{
+    QStringList keys;
+    loadAll(keys);
+    return keys;
+}
+
+// Backends without a snapshot load everything eagerly
+QList<PhotoData> MetadataStore::loadWithSnapshot(std::shared_ptr<const MetadataSnapshot>& snapshot,
+    QStringList& keys, QStringList& removedKeys)
+{
+    snapshot.reset();
+    removedKeys.clear();
+    return loadAll(keys);
+}
+
+// Unsharded stores are a single root
+QList<PhotoData> MetadataStore::loadRoot(const QString& root, std::shared_ptr<const MetadataSnapshot>& snapshot,
+    QStringList& keys, QStringList& removedKeys)
+{
+    if (root.isEmpty())
+        return loadWithSnapshot(snapshot, keys, removedKeys);
+
+    snapshot.reset();
+    keys.clear();
+    removedKeys.clear();
+    return {};
+}
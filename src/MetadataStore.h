@@ -0,0 +1,185 @@
+#pragma once
+#include <QString>
+#include <QStringList>
+#include <QByteArray>
+#include <QList>
+#include <memory>
+#include <functional>
+
+struct PhotoData;
+class MetadataSnapshot;
+
+/**
+ * @class MetadataStore
+ * @brief Interface of persistent per-photo metadata storage.
+ *
+ * @details
+ * PhotoMetadataManager keeps the catalog in memory and reports every
+ * change to a store as a put() or remove() of a single record, keyed by
+ * the absolute photo path. Stores decide how records reach the disk:
+ * - SqliteMetadataStore: rows in a local SQLite database
+ * - JournalMetadataStore: append-only journal plus compacted snapshot
+ * - ShardedMetadataStore: one store of either kind per imported folder
+ *
+ * The backend is selected with the "metadata/backend" setting.
+ *
+ * @see PhotoMetadataManager
+ */
+class MetadataStore {
+public:
+    /// Receives one record with the absolute photo path it belongs to.
+    using RecordVisitor = std::function<void(const QString& key, const PhotoData& data)>;
+
+    virtual ~MetadataStore() = default;
+
+    /**
+     * @brief Opens (and creates if needed) the store.
+     * @param filePath Path to the main store file.
+     * @return True if the store is ready for use.
+     */
+    virtual bool open(const QString& filePath) = 0;
+
+    /**
+     * @brief Closes the store, writing anything still pending.
+     */
+    virtual void close() = 0;
+
+    /**
+     * @brief Checks whether the store is open.
+     * @return True if open() succeeded.
+     */
+    virtual bool isOpen() const = 0;
+
+    /**
+     * @brief Reads all stored records.
+     * @param keys Receives the absolute photo path of each record.
+     * @return Records in the same order as keys.
+     */
+    virtual QList<PhotoData> loadAll(QStringList& keys) = 0;
+
+    /**
+     * @brief Reads the records whose path starts with a prefix.
+     * @param prefix Path prefix, e.g. a folder ending with '/'.
+     * @param keys Receives the absolute photo path of each record.
+     * @return Matching records in the same order as keys.
+     *
+     * @details The default implementation filters loadAll(); backends
+     * override it to decode only the matching records.
+     */
+    virtual QList<PhotoData> loadPrefix(const QString& prefix, QStringList& keys);
+
+    /**
+     * @brief Visits all stored records one at a time.
+     * @param visit Called for every record, which is not kept afterwards.
+     *
+     * @details The default implementation visits the result of loadAll();
+     * backends override it to decode one record at a time.
+     */
+    virtual void forEachRecord(const RecordVisitor& visit);
+
+    /**
+     * @brief Reads the paths of all stored records without decoding them.
+     * @return Absolute photo paths.
+     *
+     * @details The default implementation returns the keys of loadAll().
+     */
+    virtual QStringList loadKeys();
+
+    /**
+     * @brief Loads the store for lazy access through a mapped snapshot.
+     * @param snapshot Receives the compacted records, stays null if the
+     *        backend has no snapshot.
+     * @param keys Receives the paths of records changed after the snapshot.
+     * @param removedKeys Receives the paths deleted after the snapshot.
+     * @return Records changed after the snapshot, in the same order as keys.
+     *
+     * @details The default implementation has no snapshot and returns
+     * all records, like loadAll().
+     */
+    virtual QList<PhotoData> loadWithSnapshot(std::shared_ptr<const MetadataSnapshot>& snapshot,
+        QStringList& keys, QStringList& removedKeys);
+
+    /**
+     * @brief Returns the folders the store is split into.
+     * @return Root folders; "" stands for all photos outside the other roots.
+     *
+     * @details Unsharded stores consist of the single root "".
+     */
+    virtual QStringList roots() const { return { QString() }; }
+
+    /**
+     * @brief Gives a folder its own part of the store.
+     * @param root Absolute folder path.
+     * @return True if the folder is a root afterwards.
+     *
+     * @details Unsharded stores ignore the call and return false.
+     */
+    virtual bool addRoot(const QString& root) { Q_UNUSED(root); return false; }
+
+    /**
+     * @brief Loads the part of the store holding one root, like loadWithSnapshot().
+     * @param root Root returned by roots().
+     * @param snapshot Receives the compacted records of the root, may stay null.
+     * @param keys Receives the paths of records changed after the snapshot.
+     * @param removedKeys Receives the paths deleted after the snapshot.
+     * @return Records changed after the snapshot, in the same order as keys.
+     *
+     * @details The default implementation loads the whole store for ""
+     * and nothing for other roots.
+     */
+    virtual QList<PhotoData> loadRoot(const QString& root, std::shared_ptr<const MetadataSnapshot>& snapshot,
+        QStringList& keys, QStringList& removedKeys);
+
+    /**
+     * @brief Checks whether nothing was ever stored.
+     * @return True for a new, empty store.
+     */
+    virtual bool isEmpty() const = 0;
+
+    /**
+     * @brief Inserts or replaces the record of one photo.
+     * @param key Absolute path to the photo file.
+     * @param data Metadata to store.
+     * @return True on success.
+     */
+    virtual bool put(const QString& key, const PhotoData& data) = 0;
+
+    /**
+     * @brief Deletes the record of one photo.
+     * @param key Absolute path to the photo file.
+     * @return True on success.
+     */
+    virtual bool remove(const QString& key) = 0;
+
+    /**
+     * @brief Starts a transaction grouping following updates.
+     * @return True on success.
+     */
+    virtual bool beginTransaction() = 0;
+
+    /**
+     * @brief Commits the current transaction.
+     * @return True on success.
+     */
+    virtual bool commit() = 0;
+
+    /**
+     * @brief Discards the current transaction.
+     * @return True on success.
+     */
+    virtual bool rollback() = 0;
+
+    /**
+     * @brief Encodes a record as compact CBOR.
+     * @param data Metadata to encode.
+     * @return CBOR encoding of PhotoData::toJson().
+     */
+    static QByteArray encode(const PhotoData& data);
+
+    /**
+     * @brief Decodes a record written by encode().
+     * @param bytes CBOR bytes.
+     * @return Decoded metadata.
+     */
+    static PhotoData decode(const QByteArray& bytes);
+};
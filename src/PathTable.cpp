@@ -0,0 +1,146 @@
+#include "PathTable.h"
+
+// Hash table starts with this many slots and is kept at most half full
+static const qsizetype INITIAL_SLOTS = 1024;
+
+// Hash of a (directory, file name) pair
+static size_t pathHash(quint32 directoryId, QByteArrayView name)
+{
+    return qHash(name, size_t(directoryId) * 0x9E3779B97F4A7C15ull);
+}
+
+// Split at the last separator, the root directory of "/a.jpg" is ""
+static void splitPath(const QString& path, QString& directory, QString& fileName)
+{
+    const qsizetype separator = path.lastIndexOf('/');
+    directory = path.left(qMax<qsizetype>(separator, 0));
+    fileName = path.mid(separator + 1);
+}
+
+
+// -------------------------
+//   Lookup
+// -------------------------
+
+QByteArrayView PathTable::nameBytes(Handle handle) const
+{
+    const quint32 start = m_nameOffsets[handle - 1];
+    const quint32 end = m_nameOffsets[handle];
+    return QByteArrayView(m_names.constData() + start, end - start);
+}
+
+qsizetype PathTable::findSlot(quint32 directoryId, QByteArrayView name, size_t hash) const
+{
+    const qsizetype mask = m_slots.size() - 1;
+    for (qsizetype slot = qsizetype(hash) & mask;; slot = (slot + 1) & mask) // Linear probing
+    {
+        const Handle handle = m_slots[slot];
+        if (handle == 0)
+            return slot;
+
+        if (m_fileDirectories[handle - 1] == directoryId && nameBytes(handle) == name)
+            return slot;
+    }
+}
+
+PathTable::Handle PathTable::find(const QString& path) const
+{
+    if (m_slots.isEmpty())
+        return 0;
+
+    QString directory, fileName;
+    splitPath(path, directory, fileName);
+
+    const auto dir = m_directoryIds.constFind(directory);
+	if (dir == m_directoryIds.cend()) // Unknown directory, so unknown path
+        return 0;
+
+    const QByteArray name = fileName.toUtf8();
+    return m_slots[findSlot(dir.value(), name, pathHash(dir.value(), name))];
+}
+
+QString PathTable::path(Handle handle) const
+{
+    if (handle == 0 || handle > quint32(size()))
+        return QString();
+
+    return m_directories[m_fileDirectories[handle - 1]] + '/' + fileName(handle);
+}
+
+QString PathTable::fileName(Handle handle) const
+{
+    if (handle == 0 || handle > quint32(size()))
+        return QString();
+
+    return QString::fromUtf8(nameBytes(handle));
+}
+
+QString PathTable::directory(Handle handle) const
+{
+    if (handle == 0 || handle > quint32(size()))
+        return QString();
+
+    return m_directories[m_fileDirectories[handle - 1]];
+}
+
+
+// -------------------------
+//   Insertion
+// -------------------------
+
+PathTable::Handle PathTable::intern(const QString& path)
+{
+	if (m_slots.isEmpty()) // First path
+        m_slots.fill(0, INITIAL_SLOTS);
+
+    QString directory, fileName;
+    splitPath(path, directory, fileName);
+
+    auto dir = m_directoryIds.constFind(directory);
+	if (dir == m_directoryIds.cend()) // New directory
+    {
+        dir = m_directoryIds.insert(directory, quint32(m_directories.size()));
+        m_directories.append(directory);
+    }
+
+    const QByteArray name = fileName.toUtf8();
+    const size_t hash = pathHash(dir.value(), name);
+    qsizetype slot = findSlot(dir.value(), name, hash);
+	if (m_slots[slot] != 0) // Already interned
+        return m_slots[slot];
+
+    m_names.append(name);
+    m_nameOffsets.append(quint32(m_names.size()));
+    m_fileDirectories.append(dir.value());
+
+    const Handle handle = Handle(size());
+    m_slots[slot] = handle;
+
+	if (qsizetype(size()) * 2 > m_slots.size()) // Keep probe sequences short
+        grow();
+
+    return handle;
+}
+
+void PathTable::grow()
+{
+    QList<Handle> slots(m_slots.size() * 2, 0);
+    m_slots.swap(slots);
+
+    for (Handle handle = 1; handle <= Handle(size()); ++handle)
+    {
+        const QByteArrayView name = nameBytes(handle);
+        const quint32 directoryId = m_fileDirectories[handle - 1];
+        m_slots[findSlot(directoryId, name, pathHash(directoryId, name))] = handle;
+    }
+}
+
+void PathTable::clear()
+{
+    m_directories.clear();
+    m_directoryIds.clear();
+    m_names.clear();
+    m_nameOffsets = { 0 };
+    m_fileDirectories.clear();
+    m_slots.clear();
+}
@@ -0,0 +1,102 @@
+#pragma once
+#include <QString>
+#include <QStringList>
+#include <QByteArray>
+#include <QHash>
+#include <QList>
+
+/**
+ * @class PathTable
+ * @brief Interning table for absolute file paths.
+ *
+ * @details
+ * Each path is split into its directory and file name. Directories are
+ * stored once and numbered; file names are kept as UTF-8 in one shared
+ * byte buffer. A path is therefore represented by a 32-bit handle and
+ * costs its file name plus a few bytes of bookkeeping, instead of a full
+ * QString per copy.
+ *
+ * Handles are assigned in order of first use starting at 1, stay valid
+ * for the lifetime of the table and are used as photo ids by
+ * PhotoMetadataManager. Lookups go through an open-addressing hash table
+ * of handles, so no key strings are duplicated.
+ *
+ * Paths must be absolute and use '/' as separator, as returned by
+ * QFileInfo::absoluteFilePath().
+ *
+ * @see PhotoMetadataManager::photoId()
+ */
+class PathTable {
+public:
+    /// Interned path, 0 means no path.
+    using Handle = quint32;
+
+    /**
+     * @brief Returns the handle of a path, adding the path if needed.
+     * @param path Absolute path.
+     * @return Handle of the path (never 0).
+     */
+    Handle intern(const QString& path);
+
+    /**
+     * @brief Returns the handle of a path without adding it.
+     * @param path Absolute path.
+     * @return Handle of the path, or 0 if it was never interned.
+     */
+    Handle find(const QString& path) const;
+
+    /**
+     * @brief Rebuilds the full path of a handle.
+     * @param handle Handle returned by intern().
+     * @return Absolute path, empty for 0 or unknown handles.
+     */
+    QString path(Handle handle) const;
+
+    /**
+     * @brief Returns the file name part of a handle.
+     * @param handle Handle returned by intern().
+     * @return File name without directory.
+     */
+    QString fileName(Handle handle) const;
+
+    /**
+     * @brief Returns the directory part of a handle.
+     * @param handle Handle returned by intern().
+     * @return Directory path without trailing '/'.
+     */
+    QString directory(Handle handle) const;
+
+    /**
+     * @brief Returns the number of interned paths.
+     * @return Highest assigned handle.
+     */
+    int size() const { return int(m_fileDirectories.size()); }
+
+    /**
+     * @brief Removes all paths, handles start at 1 again.
+     */
+    void clear();
+
+private:
+    /**
+     * @brief Finds the slot holding a path or the empty slot where it belongs.
+     */
+    qsizetype findSlot(quint32 directoryId, QByteArrayView name, size_t hash) const;
+
+    /**
+     * @brief Returns the UTF-8 file name of a handle inside m_names.
+     */
+    QByteArrayView nameBytes(Handle handle) const;
+
+    /**
+     * @brief Doubles the hash table and re-inserts all handles.
+     */
+    void grow();
+
+    QStringList m_directories;                 ///< Directory id -> directory path.
+    QHash<QString, quint32> m_directoryIds;    ///< Directory path -> directory id.
+    QByteArray m_names;                        ///< UTF-8 file names, back to back.
+    QList<quint32> m_nameOffsets{ 0 };         ///< Handle -> start of its name in m_names (plus end sentinel).
+    QList<quint32> m_fileDirectories;          ///< Handle - 1 -> directory id.
+    QList<Handle> m_slots;                     ///< Open-addressing table of handles, 0 = empty.
+};
@@ -0,0 +1,52 @@
+#include "PerceptualHash.h"
+#include <QImageReader>
+
+// Constants for hash computation
+static const int HASH_WIDTH = 9;       // 9 columns give 8 horizontal differences
+static const int HASH_HEIGHT = 8;      // 8 rows -> 64 bits
+static const int THUMBNAIL_SIZE = 64;  // Size of the thumbnail decoded from file
+
+namespace PerceptualHash {
+
+	quint64 dHash(const QImage& image)
+	{
+		if (image.isNull()) // Nothing to hash
+			return 0;
+
+		// Reduce to 9x8 grayscale, aspect ratio is intentionally ignored
+		const QImage small = image
+			.scaled(HASH_WIDTH, HASH_HEIGHT, Qt::IgnoreAspectRatio, Qt::SmoothTransformation)
+			.convertToFormat(QImage::Format_Grayscale8);
+
+		quint64 hash = 0;
+		for (int y = 0; y < HASH_HEIGHT; ++y)
+		{
+			const uchar* line = small.constScanLine(y);
+			for (int x = 0; x < HASH_WIDTH - 1; ++x)
+			{
+				hash <<= 1;
+				if (line[x] < line[x + 1]) // Brightness increases to the right
+					hash |= 1;
+			}
+		}
+		return hash;
+	}
+
+	quint64 fromFile(const QString& filePath, bool* ok)
+	{
+		QImageReader reader(filePath);
+		reader.setAutoTransform(true);
+
+		// Let the decoder produce a thumbnail directly (JPEG decodes at 1/8 scale)
+		const QSize fullSize = reader.size();
+		if (fullSize.isValid())
+			reader.setScaledSize(fullSize.scaled(THUMBNAIL_SIZE, THUMBNAIL_SIZE, Qt::KeepAspectRatio)
+				.expandedTo(QSize(HASH_WIDTH, HASH_HEIGHT)));
+
+		const QImage thumbnail = reader.read();
+		if (ok)
+			*ok = !thumbnail.isNull();
+		return dHash(thumbnail);
+	}
+
+}
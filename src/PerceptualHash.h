@@ -0,0 +1,46 @@
+#pragma once
+#include <QtGlobal>
+#include <QImage>
+#include <QString>
+
+/**
+ * @brief Perceptual image hashing used for near-duplicate detection.
+ *
+ * @details
+ * Implements the difference hash (dHash): the image is reduced to a 9x8
+ * grayscale thumbnail and every bit records whether a pixel is brighter
+ * than its right neighbour. Visually similar images (re-exports, resized
+ * copies, burst shots) produce hashes with a small Hamming distance.
+ *
+ * @see BKTree
+ */
+namespace PerceptualHash {
+
+	/**
+	 * @brief Computes the 64-bit difference hash of an image.
+	 * @param image Source image (any size or format).
+	 * @return dHash value, or 0 for a null image.
+	 */
+	quint64 dHash(const QImage& image);
+
+	/**
+	 * @brief Computes the difference hash of an image file.
+	 * @param filePath Path to the image file.
+	 * @param ok Optional, set to false if the file cannot be decoded.
+	 * @return dHash value, or 0 if the file cannot be decoded.
+	 *
+	 * @details Decodes only a small thumbnail (scaled decoding where the
+	 * image format supports it), so it is cheap enough to run during import.
+	 * A flat image also hashes to 0, use @p ok to tell the two apart.
+	 */
+	quint64 fromFile(const QString& filePath, bool* ok = nullptr);
+
+	/**
+	 * @brief Returns the Hamming distance between two hashes.
+	 * @param a First hash.
+	 * @param b Second hash.
+	 * @return Number of differing bits (0-64).
+	 */
+	inline int distance(quint64 a, quint64 b) { return qPopulationCount(a ^ b); }
+
+}
@@ -1,5 +1,6 @@
 #include "Photo.h"
 #include "PhotoMetadata.h"
+#include "ImagePipeline.h"
 #include <QFileInfo>
 #include <QImage>
 
@@ -11,14 +12,11 @@ static const qint64 ONE_MB = 1024 * 1024;
  * Constructor implementation.
  *
  * Loads file info, calculates human-readable size, normalizes path,
- * and retrieves stored metadata. If the path is empty, creates an
- * empty Photo object.
+ * and takes a handle to the stored metadata. If the path is empty,
+ * creates an empty Photo object.
  */
 Photo::Photo(const QString& path)
-    : m_filePath(path),
-      m_rating(0), 
-      m_hasEditedVersion(false), 
-      m_markedForExport(false)
+    : m_markedForExport(false)
 {
     if (path.isEmpty())
         return; // Default-constructed Photo (no file path)
@@ -29,7 +27,7 @@ Photo::Photo(const QString& path)
     const qint64 sizeBytes = info.size();
     m_sizeBytes = sizeBytes;
 
-    m_isGif = QFileInfo(m_filePath).suffix().compare("gif", Qt::CaseInsensitive) == 0;
+    m_isGif = info.suffix().compare("gif", Qt::CaseInsensitive) == 0;
 
 	if (sizeBytes < ONE_KB) 
     { // Bytes
@@ -54,13 +52,8 @@ Photo::Photo(const QString& path)
     if (normalizedPath.isEmpty())
         normalizedPath = info.absoluteFilePath();
 
-    m_filePath = normalizedPath;
-
-    // Load metadata from JSON
-    const PhotoData data = PhotoMetadataManager::instance().getPhotoData(m_filePath);
-    m_tag = data.tag;
-    m_rating = data.rating;
-    m_comment = data.comment;
+    // The manager keeps the only copy of the path and metadata, read on first use
+    m_photoId = PhotoMetadataManager::instance().photoId(normalizedPath);
 }
 
 
@@ -78,37 +71,38 @@ QPixmap Photo::preview() const
 /** Generates a scaled thumbnail while keeping the aspect ratio. */
 void Photo::generatePreview(int size) 
 {
-    QImage img(m_filePath);
+    // Decoded at reduced scale, with the edit applied
+    const QImage img = renderImage(size);
 
 	if (img.isNull()) // Failed to load image
         return;
 
-    // Scale image
-	const QImage scaled = img.scaled(size, size, Qt::KeepAspectRatio, Qt::SmoothTransformation); 
-
     // Store as QPixmap
-	m_preview = QPixmap::fromImage(scaled); 
+	m_preview = QPixmap::fromImage(img); 
+}
+
+/** Renders the edited photo, or decodes the original if not edited. */
+QImage Photo::renderImage(int maxSize, const TileRenderer::ProgressFunction& progress) const
+{
+    return ImagePipeline::renderFile(filePath(), editRecipe(), maxSize, progress);
 }
 
-/** Sets a custom edited version of the photo and marks it for export. */
-void Photo::setEditedPixmap(const QPixmap& pixmap) 
+/** Stores the edit recipe and marks the photo for export. */
+void Photo::setEditRecipe(const EditRecipe& recipe) 
 {
-    m_editedPixmap = pixmap;
+    PhotoMetadataManager::instance().setEditRecipe(filePath(), recipe); // Save to metadata manager
 
-    // Mark that an edited version exists
-	m_hasEditedVersion = !pixmap.isNull();
+	m_preview = QPixmap(); // Thumbnail shows the edit, regenerate on next use
 
-    if (m_hasEditedVersion)
+    if (!recipe.isIdentity())
         m_markedForExport = true;
 }
 
 /** Clears any edited version and resets export flag. */
 void Photo::clearEditedVersion() 
 {
-    m_editedPixmap = QPixmap();
-
     // No edited version
-	m_hasEditedVersion = false; 
+	setEditRecipe(EditRecipe()); 
 
     // Clear export mark
 	m_markedForExport = false; 
@@ -1,8 +1,10 @@
 #pragma once
 #include <QString>
 #include <QPixmap>
+#include <QImage>
 #include <QDateTime>
 #include "PhotoMetadata.h"
+#include "TileRenderer.h"
 
 /**
  * @class Photo
@@ -13,6 +15,13 @@
  * its path, tag, rating, comment, file size, modification date, and preview image.
  * It also supports lazy-loaded preview generation and edited versions of the photo.
  *
+ * Edits are non-destructive: only their EditRecipe is stored with the
+ * metadata, edited pixels are rendered on demand at the size needed.
+ *
+ * Tags, rating, comment and perceptual hash are not copied into the photo;
+ * they are read from PhotoMetadataManager through the photo id, so copies
+ * of a Photo never disagree with the stored metadata.
+ *
  * This class is intended for use in photo management applications where
  * displaying, editing, tagging, and rating images is required.
  *
@@ -40,25 +49,40 @@ public:
      * @return Full path to the photo file.
      *
      * @details
-     * This is the path used to locate the photo on disk.
+     * This is the path used to locate the photo on disk. The path itself
+     * is interned by PhotoMetadataManager, the photo only keeps its id.
      */
-    QString filePath() const { return m_filePath; }
+    QString filePath() const { return PhotoMetadataManager::instance().filePath(m_photoId); }
 
     /**
-     * @brief Returns the user-defined tag for the photo.
-     * @return Tag string.
+     * @brief Returns the user-defined tags for display and editing.
+     * @return Tags joined with ", " (e.g., "Vacation, Family").
      *
      * @details
      * Tags are used to categorize photos (e.g., "Vacation", "Family").
      * This does not modify the underlying file.
      */
-    QString tag() const { return m_tag; }
+    QString tag() const { return tags().join(", "); }
+
+    /**
+     * @brief Returns the user-defined tags.
+     * @return List of tags.
+     */
+    QStringList tags() const { return PhotoMetadataManager::instance().photoData(m_photoId).tags; }
+
+    /**
+     * @brief Returns the id of the photo in the metadata tag index.
+     * @return Photo id.
+     *
+     * @see PhotoMetadataManager::queryTags()
+     */
+    quint32 photoId() const { return m_photoId; }
 
     /**
      * @brief Returns the photo rating.
      * @return Integer rating from 0 (unrated) to 5 (highest rating).
      */
-    int rating() const { return m_rating; }
+    int rating() const { return PhotoMetadataManager::instance().photoData(m_photoId).rating; }
 
     /**
      * @brief Returns the user comment for the photo.
@@ -67,7 +91,7 @@ public:
      * @details
      * This can include any description or note about the photo.
      */
-    QString comment() const { return m_comment; }
+    QString comment() const { return PhotoMetadataManager::instance().photoData(m_photoId).comment; }
 
     /**
      * @brief Returns the human-readable file size.
@@ -93,7 +117,7 @@ public:
      * @brief Sets the photo file path.
      * @param path Absolute or relative file path.
      */
-    void setFilePath(const QString& path) { m_filePath = path; }
+    void setFilePath(const QString& path) { m_photoId = PhotoMetadataManager::instance().photoId(path); }
 
     /**
      * @brief Sets the formatted file size string.
@@ -110,15 +134,20 @@ public:
     // --- Metadata-modifying setters ---
 
     /**
-     * @brief Sets the photo tag and updates metadata storage.
-     * @param tag User-defined category label.
+     * @brief Sets the photo tags from user input and updates metadata storage.
+     * @param tag Comma-separated category labels.
      *
-     * @see tag(), PhotoMetadataManager
+     * @see tag(), PhotoData::parseTags(), PhotoMetadataManager
      */
-    void setTag(const QString& tag)
+    void setTag(const QString& tag) { setTags(PhotoData::parseTags(tag)); }
+
+    /**
+     * @brief Sets the photo tags and updates metadata storage.
+     * @param tags User-defined category labels.
+     */
+    void setTags(const QStringList& tags)
     {
-        m_tag = tag;
-        PhotoMetadataManager::instance().setTag(m_filePath, tag); // Save to metadata manager
+        PhotoMetadataManager::instance().setTags(filePath(), tags); // Save to metadata manager
     }
 
     /**
@@ -127,8 +156,7 @@ public:
      */
     void setRating(int rating)
     {
-        m_rating = rating;
-        PhotoMetadataManager::instance().setRating(m_filePath, rating); // Save to metadata manager
+        PhotoMetadataManager::instance().setRating(filePath(), rating); // Save to metadata manager
     }
 
     /**
@@ -137,8 +165,7 @@ public:
      */
     void setComment(const QString& comment) 
     {
-        m_comment = comment;
-        PhotoMetadataManager::instance().setComment(m_filePath, comment); // Save to metadata manager
+        PhotoMetadataManager::instance().setComment(filePath(), comment); // Save to metadata manager
     }
 
     // --- Image preview handling ---
@@ -159,29 +186,40 @@ public:
      *
      * @details
      * The thumbnail is cached internally and can be retrieved using preview().
+     * It shows the edited version if there is one.
      * This function does not modify the original image file.
      */
     void generatePreview(int size = 75);
 
     /**
-     * @brief Sets a custom edited version of the photo.
-     * @param pixmap Edited image.
+     * @brief Returns the non-destructive edit of the photo.
+     * @return Recipe from metadata storage, identity if not edited.
+     */
+    EditRecipe editRecipe() const { return PhotoMetadataManager::instance().photoData(m_photoId).edit; }
+
+    /**
+     * @brief Stores the edit of the photo and marks it for export.
+     * @param recipe Edit steps; an identity recipe removes the edit.
      *
-     * @note Use hasEditedVersion() to check if an edited version exists.
+     * @note Only the recipe is kept, use renderImage() for the pixels.
      */
-    void setEditedPixmap(const QPixmap& pixmap);
+    void setEditRecipe(const EditRecipe& recipe);
 
     /**
-     * @brief Returns the edited photo if available.
-     * @return Edited QPixmap.
+     * @brief Decodes the photo and renders its edit.
+     * @param maxSize Bounding square of the result, 0 for full resolution.
+     * @param progress Optional progress callback, returning false cancels the render.
+     * @return Edited image, or the original if not edited; null if canceled.
+     *
+     * @see ImagePipeline::renderFile()
      */
-    QPixmap editedPixmap() const { return m_editedPixmap; }
+    QImage renderImage(int maxSize = 0, const TileRenderer::ProgressFunction& progress = TileRenderer::ProgressFunction()) const;
 
     /**
      * @brief Checks whether an edited version exists.
-     * @return True if edited version is available, false otherwise.
+     * @return True if the photo has a non-identity edit recipe.
      */
-    bool hasEditedVersion() const { return m_hasEditedVersion; }
+    bool hasEditedVersion() const { return !editRecipe().isIdentity(); }
 
     /**
      * @brief Clears the edited version of the photo.
@@ -202,13 +240,15 @@ public:
 
     /**
      * @brief Returns the photo to display.
+     * @param maxSize Bounding square of the displayed image.
      * @return Edited photo if available, otherwise original.
      *
      * @details
      * Helper method to decide which image version should be shown
-     * in the UI.
+     * in the UI. Decoded and rendered at the display size, which is
+     * much cheaper than a full-resolution render.
      */
-    QPixmap getDisplayPixmap() const { return m_hasEditedVersion ? m_editedPixmap : QPixmap(m_filePath); }
+    QPixmap getDisplayPixmap(int maxSize) const { return QPixmap::fromImage(renderImage(maxSize)); }
 
     /**
      * @brief Sets whether the photo is a GIF image.
@@ -216,17 +256,51 @@ public:
 	 */
     bool isGif() const { return m_isGif; }
 
+    /**
+     * @brief Returns the 64-bit perceptual hash (dHash) of the photo.
+     * @return Hash value, or 0 if it has not been computed yet (see hasPerceptualHash()).
+     *
+     * @see PerceptualHash
+     */
+    quint64 perceptualHash() const { return PhotoMetadataManager::instance().photoData(m_photoId).perceptualHash; }
+
+    /**
+     * @brief Checks whether the perceptual hash has been computed.
+     * @return True if perceptualHash() is valid, 0 included.
+     */
+    bool hasPerceptualHash() const { return PhotoMetadataManager::instance().photoData(m_photoId).hasPerceptualHash; }
+
+    /**
+     * @brief Sets the perceptual hash and caches it in metadata storage.
+     * @param hash dHash computed from the photo thumbnail.
+     */
+    void setPerceptualHash(quint64 hash)
+    {
+        PhotoMetadataManager::instance().setPerceptualHash(filePath(), hash); // Cache in metadata manager
+    }
+
+    /**
+     * @brief Returns the content fingerprint of the photo file.
+     * @return XXH64 hash of the file bytes, or 0 if not computed or stale.
+     *
+     * @details Only computed for files whose size collides with another
+     * photo, see PhotoTableModel::exactDuplicateGroups(). The cached hash
+     * is valid only while the file size and modification time match.
+     */
+    quint64 contentHash() const
+    {
+        const PhotoData data = PhotoMetadataManager::instance().photoData(m_photoId);
+        if (data.contentHashSize != m_sizeBytes || data.contentHashModified != m_dateTime.toMSecsSinceEpoch())
+            return 0;
+        return data.contentHash;
+    }
+
 private:
-    QString m_filePath;         ///< Absolute path to the photo.
-    QString m_tag;              ///< Optional tag (label).
-    int m_rating;               ///< Rating from 0 to 5.
-    QString m_comment;          ///< Optional user comment.
+    quint32 m_photoId = 0;      ///< Handle of the path and metadata in PhotoMetadataManager, 0 if no file.
     QString m_size;             ///< File size as formatted string (e.g., "2.4 MB").
-    qint64 m_sizeBytes;         ///< File size in bytes.
+    qint64 m_sizeBytes = 0;     ///< File size in bytes.
     QDateTime m_dateTime;       ///< Last modification date/time.
     mutable QPixmap m_preview;  ///< Cached thumbnail (mutable for lazy loading).
-    QPixmap m_editedPixmap;     ///< Edited version of the photo.
-    bool m_hasEditedVersion;    ///< True if edited version exists.
     bool m_markedForExport;     ///< True if marked for export.
 
     bool m_isGif = false;
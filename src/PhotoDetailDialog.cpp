@@ -6,6 +6,8 @@
 #include <QSlider>
 #include <QPixmap>
 #include <QPushButton>
+#include <QScreen>
+#include <algorithm>
 
 // Helper function to calculate scale factor to fit a pixmap into a viewport
 static double fitScale(const QSize& viewportSize, const QPixmap& pixmap) 
@@ -65,8 +67,11 @@ void PhotoDetailDialog::setPhoto(const Photo& photo)
 {
     currentPhoto = photo;
 
-    // Load either edited pixmap or original photo file
-    originalPixmap = photo.hasEditedVersion() ? photo.editedPixmap() : QPixmap(photo.filePath());
+    // Load the photo with its edit rendered at the largest size the dialog shows (fullscreen),
+    // a full-resolution render of a large photo would block the GUI thread
+    const QScreen* displayScreen = screen();
+    const QSize screenSize = displayScreen ? displayScreen->size() : QSize(1920, 1080);
+    originalPixmap = photo.getDisplayPixmap(std::max(screenSize.width(), screenSize.height()));
 }
 
 // Show event to set initial zoom
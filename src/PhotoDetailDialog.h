@@ -81,7 +81,7 @@ private:
     QScrollArea* scrollArea;  ///< Scroll area for large images.
     QSlider* zoomSlider;      ///< Slider controlling zoom level.
     QPushButton* fullscreenBtn; ///< Button to toggle fullscreen mode.
-    QPixmap originalPixmap;   ///< Original photo pixmap for scaling.
+    QPixmap originalPixmap;   ///< Photo rendered at screen size, scaled for zooming.
     Photo currentPhoto;       ///< Photo currently displayed.
     bool isFullscreen;        ///< Tracks fullscreen state of the dialog.
 };
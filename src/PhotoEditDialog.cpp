@@ -12,11 +12,16 @@
 #include <QMouseEvent>
 #include <QFileDialog>
 #include <QComboBox>
-#include <QPainter>
-#include <QProgressDialog>
 #include <QApplication>
 #include <QScrollArea>
+#include <QWheelEvent>
+#include <QImageReader>
+#include <algorithm>
+#include <cmath>
 #include "CropDialog.h"
+#include "ImagePipeline.h"
+#include "PreviewRenderer.h"
+#include "ImageLoader.h"
 
 
 // --- Constants ---
@@ -25,11 +30,12 @@ namespace {
 	constexpr int MIN_ADJUSTMENT = -100;
 	constexpr int MAX_ADJUSTMENT = 100;
 	constexpr int DEFAULT_ADJUSTMENT = 0;
-	constexpr int TIMER_DELAY_MS = 50; // Delay for debouncing updates
-	constexpr int DEFAULT_WATERMARK_OPACITY = 70;
-	constexpr int DEFAULT_WATERMARK_POSITION = 3; // Bottom Right
-	constexpr int WATERMARK_MARGIN = 20; // Margin from edges
-	constexpr int PROGRESS_THRESHOLD_PIXELS = 1000000; // 1 megapixel
+	constexpr int TIMER_DELAY_MS = 16; // Changes within one display frame share a preview render
+	constexpr int DEFAULT_WATERMARK_OPACITY = EditRecipe::DEFAULT_WATERMARK_OPACITY;
+	constexpr int DEFAULT_WATERMARK_POSITION = EditRecipe::DEFAULT_WATERMARK_POSITION; // Bottom Right
+	constexpr int REFINE_DELAY_MS = 250; // Idle time before a preview is refined from the original
+	constexpr double ZOOM_STEP = 1.25; // Zoom factor per wheel step
+	constexpr double REFINE_SCALE = 2.0; // Unzoomed refinement source, relative to the display resolution
 }
 
 // --- Constructor ----
@@ -37,7 +43,6 @@ namespace {
 PhotoEditorDialog::PhotoEditorDialog(Photo* photo, QWidget* parent)
 	: QDialog(parent),
 	m_photoPtr(photo),
-	m_originalPhoto(*photo),
 	m_showingOriginal(false),
 	m_rotation(0),
 	m_brightness(0),
@@ -54,27 +59,22 @@ PhotoEditorDialog::PhotoEditorDialog(Photo* photo, QWidget* parent)
 	setWindowTitle("Photo Editor");
 	resize(900, 700);
 
-	// load edited or original pixmap
-	m_originalPixmap = photo->hasEditedVersion()
-		? photo->editedPixmap()
-		: QPixmap(photo->filePath());
+	// Edits are stored as a recipe, always start from the original; only its header is read here
+	m_originalSize = QImageReader(photo->filePath()).size();
 
-	m_editedPixmap = m_originalPixmap;
+	// Previews render on a worker thread, the newest request wins
+	m_previewRenderer = new PreviewRenderer(this);
+	connect(m_previewRenderer, &PreviewRenderer::rendered, this, &PhotoEditorDialog::showPreview);
 
 	buildUI(); // Setup UI components
 	connectSignals(); // Connect signals and slots
+	setRecipe(photo->editRecipe()); // Continue a previous edit
 
-	// Schedule update after the constructor finishes to ensure correct label dimensions.
-	QTimer::singleShot(0, this, [this]() {
-		updatePreview();
-		});
-
-	m_previewPixmap = m_originalPixmap.scaled(
-		1024, 1024,
-		Qt::KeepAspectRatio,
-		Qt::FastTransformation
-	);
-
+	// Dialog opens at once: a reduced-scale decode shows the photo, the full decode follows in the background
+	m_imageLoader = new ImageLoader(this);
+	connect(m_imageLoader, &ImageLoader::previewLoaded, this, &PhotoEditorDialog::setPreviewImage);
+	connect(m_imageLoader, &ImageLoader::imageLoaded, this, &PhotoEditorDialog::setOriginalImage);
+	m_imageLoader->load(photo->filePath(), qRound(std::max(width(), height()) * devicePixelRatioF()));
 }
 
 
@@ -145,6 +145,7 @@ void PhotoEditorDialog::createPreviewArea(QVBoxLayout* layout)
 	previewLabel->setAlignment(Qt::AlignCenter);
 	previewLabel->setMinimumSize(400, 400);
 	previewLabel->setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Expanding);
+	previewLabel->installEventFilter(this); // Wheel zooms the preview
 	previewLabel->setStyleSheet(
 		"QLabel {"
 		"   background-color: rgba(0, 0, 0, 15);"
@@ -324,6 +325,12 @@ void PhotoEditorDialog::createAdjustmentSlider(const QString& label, QSlider*& s
 
 bool PhotoEditorDialog::eventFilter(QObject* obj, QEvent* event)
 {
+	if (obj == previewLabel && event->type() == QEvent::Wheel) {
+		QWheelEvent* wheel = static_cast<QWheelEvent*>(event);
+		zoomPreview(wheel->angleDelta().y() / QWheelEvent::DefaultDeltasPerStep, wheel->position());
+		return true;
+	}
+
 	if (event->type() == QEvent::Wheel) {
 		if (qobject_cast<QSlider*>(obj) ||
 			qobject_cast<QSpinBox*>(obj) ||
@@ -341,44 +348,38 @@ bool PhotoEditorDialog::eventFilter(QObject* obj, QEvent* event)
 
 void PhotoEditorDialog::connectSignals()
 {
-	// Update timer for debouncing
+	// Update timer coalesces changes, see schedulePreview()
 	updateTimer = new QTimer(this);
 	updateTimer->setSingleShot(true);
-	updateTimer->setInterval(TIMER_DELAY_MS); // 50 ms delay
-	connect(updateTimer, &QTimer::timeout, this, &PhotoEditorDialog::updatePreview); // if no changes in 50ms, update preview
+	updateTimer->setInterval(TIMER_DELAY_MS);
+	connect(updateTimer, &QTimer::timeout, this, &PhotoEditorDialog::updatePreview);
+
+	// Refinement waits until input has been idle for a moment
+	refineTimer = new QTimer(this);
+	refineTimer->setSingleShot(true);
+	refineTimer->setInterval(REFINE_DELAY_MS);
+	connect(refineTimer, &QTimer::timeout, this, &PhotoEditorDialog::refinePreview);
 
 	// Basic tools
 	connect(rotateLeftBtn, &QPushButton::clicked, this, &PhotoEditorDialog::rotateLeft);
 	connect(rotateRightBtn, &QPushButton::clicked, this, &PhotoEditorDialog::rotateRight);
 	connect(cropBtn, &QPushButton::clicked, this, [this]() {
-		if (m_previewPixmap.isNull())
+		if (m_previewImage.isNull() || !m_originalSize.isValid()) // Nothing decoded yet
 			return;
 
-		QImage img = m_previewPixmap.toImage(); // zaname zo klovanej preview
+		// Crop on the preview as it currently looks, crops are normalized so the full decode is not needed
+		const EditRecipe current = recipe();
+		QPixmap processedPixmap = QPixmap::fromImage(ImagePipeline::render(m_previewImage, current, m_watermarkImage));
 
-		// --- Aplikujeme vetky pravy, ktor sa aktulne zobrazuj ---
-		applyRotation(img);
-		applyBrightness(img);
-		applyContrast(img);
-		applySaturation(img);
-		applyTemperature(img);
-		applyRGB(img);
-		applyActiveFilter(img);
-		applyWatermark(img);
-		QPixmap processedPixmap = QPixmap::fromImage(img);
-
-		CropDialog dlg(processedPixmap, m_editedPixmap.size(), this);
+		CropDialog dlg(processedPixmap, ImagePipeline::outputSize(m_originalSize, current), this);
 		if (dlg.exec() == QDialog::Accepted) 
 		{
-			QRectF normalizedCrop = dlg.normalizedCropRect();
-			m_editedPixmap = CropDialog::applyCropToPixmap(m_editedPixmap, normalizedCrop);
-			
-			m_previewPixmap = m_editedPixmap.scaled(
-				1024, 1024,
-				Qt::KeepAspectRatio,
-				Qt::FastTransformation
-			);
-			updatePreview();
+			// New crop is relative to the already cropped image
+			EditRecipe cropped = current;
+			cropped.cropTo(dlg.normalizedCropRect());
+			m_crop = cropped.crop;
+			m_view = QRectF(); // Zoom refers to the previous result
+			schedulePreview();
 		}
 		// Uncheck the button after crop operation
 		cropBtn->setChecked(false);
@@ -402,11 +403,11 @@ void PhotoEditorDialog::connectSignals()
 	connect(watermarkBtn, &QPushButton::clicked, this, &PhotoEditorDialog::addWatermark);
 	connect(watermarkPositionCombo, QOverload<int>::of(&QComboBox::currentIndexChanged), this, [this](int index) {
 		m_watermarkPosition = index;
-		updateTimer->start();
+		schedulePreview();
 		});
 	connect(watermarkOpacitySlider, &QSlider::valueChanged, this, [this](int value) {
 		m_watermarkOpacity = value;
-		updateTimer->start();
+		schedulePreview();
 		});
 
 	connectSliderWithSpinbox(temperatureSlider, temperatureValue, m_temperature);
@@ -418,15 +419,27 @@ void PhotoEditorDialog::connectSignals()
 
 void PhotoEditorDialog::connectSliderWithSpinbox(QSlider* slider, QSpinBox* spinbox, int& value)
 {
-	// Synchronize slider and spinbox, update value and start timer on change
+	// Synchronize slider and spinbox, update value and schedule a preview on change
 	connect(slider, &QSlider::valueChanged, spinbox, &QSpinBox::setValue);
 	connect(spinbox, QOverload<int>::of(&QSpinBox::valueChanged), slider, &QSlider::setValue);
 	connect(slider, &QSlider::valueChanged, this, [this, &value](int newValue) {
 		value = newValue;
-		updateTimer->start();
+		schedulePreview();
 		});
 }
 
+void PhotoEditorDialog::schedulePreview()
+{
+	// Not restarted while running, so a slider drag still updates the preview every frame
+	if (!updateTimer->isActive())
+		updateTimer->start();
+}
+
+QSize PhotoEditorDialog::displaySize() const
+{
+	return previewLabel->size() * previewLabel->devicePixelRatioF();
+}
+
 
 // --- Mouse Events for showing Original/Edited version of picture ---
 
@@ -436,15 +449,17 @@ void PhotoEditorDialog::mousePressEvent(QMouseEvent* event)
 	QPoint posInLabel = previewLabel->mapFromGlobal(event->globalPos());
 
 	// Kliknutie je vo vntri labelu
-	if (previewLabel->rect().contains(posInLabel))
+	if (previewLabel->rect().contains(posInLabel) && !m_previewImage.isNull())
 	{
-		previewLabel->setPixmap(
-			m_originalPixmap.scaled(
-				previewLabel->size(),
+		QPixmap original = QPixmap::fromImage(
+			m_previewImage.scaled(
+				displaySize(),
 				Qt::KeepAspectRatio,
 				Qt::SmoothTransformation
 			)
 		);
+		original.setDevicePixelRatio(previewLabel->devicePixelRatioF());
+		previewLabel->setPixmap(original);
 		m_showingOriginal = true;
 
 
@@ -462,9 +477,10 @@ void PhotoEditorDialog::mouseReleaseEvent(QMouseEvent* event)
 	if (m_showingOriginal)
 	{
 		m_showingOriginal = false;
-		QApplication::setOverrideCursor(Qt::WaitCursor);
-		updatePreview();
-		QApplication::restoreOverrideCursor();
+		if (m_renderedPreview.isNull())
+			updatePreview();
+		else
+			previewLabel->setPixmap(m_renderedPreview); // Edits did not change meanwhile
 		event->accept();
 		return;
 	}
@@ -478,234 +494,224 @@ void PhotoEditorDialog::mouseReleaseEvent(QMouseEvent* event)
 
 void PhotoEditorDialog::updatePreview()
 {
-	QImage image = m_previewPixmap.toImage();
-
-	// Apply all adjustments in sequence
-	applyRotation(image);
-	applyBrightness(image);
-	applyContrast(image);
-	applySaturation(image);
-	applyTemperature(image);
-	applyRGB(image);
-	applyActiveFilter(image);
-	applyWatermark(image);
-
-	QPixmap finalPreview = QPixmap::fromImage(image);
+	updateTimer->stop(); // Request covers every pending change
+	ensureProxy();
+	if (m_previewImage.isNull()) // Still decoding, the loader updates the preview
+		return;
 
-	// klovanie na vekos labelu (aby to v UI vyzeralo dobre)
-	previewLabel->setPixmap(finalPreview.scaled(previewLabel->size(),
-		Qt::KeepAspectRatio,
-		Qt::SmoothTransformation));
+	// Geometry, fused colour adjustments, watermark and scaling to the label run on the worker
+	m_previewRenderer->request(m_previewImage, recipe(), m_watermarkImage, displaySize(), m_view);
+	refineTimer->start();
 }
 
+void PhotoEditorDialog::refinePreview()
+{
+	if (m_originalImage.isNull()) // Full decode still running, setOriginalImage() refines
+		return;
 
-// --- Rotation Implementation ---
+	// Zoomed views show native pixels, only the visible region of the original is rendered
+	if (!m_view.isNull())
+	{
+		m_previewRenderer->request(m_originalImage, recipe(), m_watermarkImage, displaySize(), m_view, PreviewRenderer::Refined);
+		return;
+	}
 
-void PhotoEditorDialog::applyRotation(QImage& image)
-{
-	if (m_rotation == 0)
+	// Whole photo on screen, a smooth proxy at twice the display resolution looks the same as the original
+	const QSize display = displaySize();
+	const QRectF crop = m_crop.isNull() ? QRectF(0, 0, 1, 1) : m_crop;
+	const int longSide = int(std::ceil(REFINE_SCALE * std::max(display.width(), display.height()) / std::min(crop.width(), crop.height())));
+
+	const QSize original = m_originalImage.size();
+	if (longSide >= std::max(original.width(), original.height()))
+	{
+		if (m_previewImage.size() == original) // Proxy of a small original is the original, nothing to refine
+			return;
+		m_previewRenderer->request(m_originalImage, recipe(), m_watermarkImage, display, m_view, PreviewRenderer::Refined);
 		return;
+	}
 
-	QTransform transform;
-	transform.rotate(m_rotation); // Rotate by the specified angle
-	image = image.transformed(transform, Qt::SmoothTransformation);
+	if (std::max(m_refineImage.width(), m_refineImage.height()) < longSide) // Scaled once, reused until the crop needs more
+		m_refineImage = m_originalImage.scaled(longSide, longSide, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+	m_previewRenderer->request(m_refineImage, recipe(), m_watermarkImage, display, m_view, PreviewRenderer::Refined);
 }
 
-void PhotoEditorDialog::rotateLeft()
+void PhotoEditorDialog::setPreviewImage(const QImage& preview)
 {
-	m_rotation = (m_rotation + 90 + 360) % 360;
+	if (m_originalImage.isNull()) // Full decode may have overtaken it
+		m_previewImage = preview;
 	updatePreview();
 }
 
-void PhotoEditorDialog::rotateRight()
+void PhotoEditorDialog::setOriginalImage(const QImage& image)
 {
-	m_rotation = (m_rotation - 90) % 360;
+	m_originalImage = image;
+	m_refineImage = QImage(); // Scaled from the previous original
+	if (!m_originalSize.isValid()) // Header did not tell
+		m_originalSize = image.size();
+
+	// Proxy gets more detail if the crop needs it, then the idle refinement follows
 	updatePreview();
 }
 
-
-
-// --- Adjustment Implementations ---
-
-void PhotoEditorDialog::applyContrast(QImage& image)
+void PhotoEditorDialog::showPreview(const QImage& image)
 {
-	if (m_contrast == 0)
-		return; // No change
-
-	double factor = (259 * (m_contrast + 255)) / (255.0 * (259 - m_contrast)); // Contrast factor calculation, photoshop formula
-
-	for (int y = 0; y < image.height(); y++)
-	{
-		QRgb* line = reinterpret_cast<QRgb*>(image.scanLine(y)); // Get pointer to the start of the line
-		for (int x = 0; x < image.width(); x++)
-		{
-			QColor pixelColor = QColor::fromRgb(line[x]); // Get pixel color
-
-			// Apply contrast formula
-			int r = std::clamp(int(factor * (pixelColor.red() - 128) + 128), 0, 255);
-			int g = std::clamp(int(factor * (pixelColor.green() - 128) + 128), 0, 255);
-			int b = std::clamp(int(factor * (pixelColor.blue() - 128) + 128), 0, 255);
-
-			line[x] = qRgb(r, g, b); // Set new pixel color
-		}
-	}
+	m_renderedPreview = QPixmap::fromImage(image);
+	m_renderedPreview.setDevicePixelRatio(previewLabel->devicePixelRatioF()); // Rendered in device pixels
+	if (!m_showingOriginal) // Keep the original visible while the mouse is held
+		previewLabel->setPixmap(m_renderedPreview);
 }
 
-void PhotoEditorDialog::applyBrightness(QImage& image)
+void PhotoEditorDialog::ensureProxy()
 {
-	if (m_brightness == 0) return; // No change
+	if (m_originalImage.isNull()) // Until the full decode arrives, the reduced-scale decode is the proxy
+		return;
 
-	for (int y = 0; y < image.height(); y++)
-	{
-		QRgb* line = reinterpret_cast<QRgb*>(image.scanLine(y)); // Get pointer to the start of the line
-		for (int x = 0; x < image.width(); x++)
-		{
-			QColor pixelColor = QColor::fromRgb(line[x]); // Get pixel color
+	// Enough pixels for the cropped part to fill the label, never more than the original has
+	const QSize display = displaySize();
+	const QRectF crop = m_crop.isNull() ? QRectF(0, 0, 1, 1) : m_crop;
+	const int longSide = int(std::ceil(std::max(display.width(), display.height()) / std::min(crop.width(), crop.height())));
 
-			// Adjust brightness
-			int r = std::clamp(pixelColor.red() + m_brightness, 0, 255);
-			int g = std::clamp(pixelColor.green() + m_brightness, 0, 255);
-			int b = std::clamp(pixelColor.blue() + m_brightness, 0, 255);
+	const QSize original = m_originalImage.size();
+	const bool full = longSide >= std::max(original.width(), original.height());
+	const QSize proxySize = full ? original : original.scaled(longSide, longSide, Qt::KeepAspectRatio);
+	if (!m_previewImage.isNull() && m_previewImage.width() >= proxySize.width())
+		return; // Current proxy has enough detail
 
-			line[x] = qRgb(r, g, b);
-		}
-	}
+	// Nearest neighbour keeps this fast for large originals, refinePreview() restores the quality
+	m_previewImage = full ? m_originalImage : m_originalImage.scaled(proxySize, Qt::IgnoreAspectRatio, Qt::FastTransformation);
 }
 
-void PhotoEditorDialog::applySaturation(QImage& image)
+void PhotoEditorDialog::zoomPreview(int steps, const QPointF& position)
 {
-	if (m_saturation == 0) // No change
+	if (steps == 0 || m_renderedPreview.isNull())
 		return;
 
-	double factor = 1.0 + (m_saturation / 100.0); // -100 --> 0.0, 0 --> 1.0, 100 --> 2.0
+	// Rendered preview is centered in the label
+	QRectF shown(QPointF(0, 0), m_renderedPreview.deviceIndependentSize());
+	shown.moveCenter(QRectF(previewLabel->rect()).center());
+	if (!shown.contains(position))
+		return;
 
-	for (int y = 0; y < image.height(); ++y)
-	{
-		for (int x = 0; x < image.width(); ++x)
-		{
-			QColor color = image.pixelColor(x, y); // Get pixel color
+	// Point under the cursor stays in place
+	const QRectF view = m_view.isNull() ? QRectF(0, 0, 1, 1) : m_view;
+	const QPointF anchor((position.x() - shown.left()) / shown.width(), (position.y() - shown.top()) / shown.height());
+	const QPointF point(view.left() + anchor.x() * view.width(), view.top() + anchor.y() * view.height());
 
-			float h, s, l;
-			color.getHslF(&h, &s, &l); // Get HSL components
+	const double zoom = qBound(1.0, std::pow(ZOOM_STEP, steps) / view.width(), maxZoom());
+	const double extent = 1.0 / zoom;
+	QRectF zoomed(point.x() - anchor.x() * extent, point.y() - anchor.y() * extent, extent, extent);
+	zoomed.moveTo(qBound(0.0, zoomed.left(), 1.0 - extent), qBound(0.0, zoomed.top(), 1.0 - extent));
 
-			// Adjust saturation and clamp to [0, 1]
-			s = std::clamp(s * factor, 0.0, 1.0);
+	// Proxy pixels show at once, the refined render of the region at native resolution follows
+	m_view = zoom > 1.0 ? zoomed : QRectF();
+	updatePreview();
+}
 
-			color.setHslF(h, s, l);
-			image.setPixelColor(x, y, color); // Set new pixel color
-		}
-	}
+double PhotoEditorDialog::maxZoom() const
+{
+	// Until one original pixel fills one device pixel
+	const QSizeF output = ImagePipeline::outputSize(m_originalSize, recipe());
+	const QSize display = displaySize();
+	return std::max({ 1.0, output.width() / display.width(), output.height() / display.height() });
 }
 
 
-// --- Actions ---
+// --- Rotation Implementation ---
 
-void PhotoEditorDialog::applyChanges()
+void PhotoEditorDialog::rotateLeft()
 {
-	QImage img = m_editedPixmap.toImage();
-
-	// Check if we need to show progress
-	bool showProgress = (img.width() * img.height() > PROGRESS_THRESHOLD_PIXELS);
-	QScopedPointer<QProgressDialog> progress; // Use QScopedPointer for auto cleanup
-
-	if (showProgress) {
-		progress.reset(new QProgressDialog("Applying changes...", "Cancel", 0, 8, this));
-		progress->setWindowModality(Qt::WindowModal);
-		progress->setMinimumDuration(0);
-		progress->setValue(0);
-		progress->show();
-		QCoreApplication::processEvents();
-	}
+	EditRecipe rotated = recipe();
+	rotated.rotate(90);
+	m_rotation = rotated.rotation;
+	m_crop = rotated.crop; // Crop turns along with the image
+	m_view = QRectF();
+	schedulePreview();
+}
 
-	// Helper lambda to update progress and check for cancellation
-	auto updateProgress = [&](int step) {
-		if (progress) {
-			progress->setValue(step);
-			if (progress->wasCanceled()) {
-				return false;
-			}
-			QCoreApplication::processEvents(); // Keep UI responsive
-		}
-		return true;
-		};
+void PhotoEditorDialog::rotateRight()
+{
+	EditRecipe rotated = recipe();
+	rotated.rotate(-90);
+	m_rotation = rotated.rotation;
+	m_crop = rotated.crop;
+	m_view = QRectF();
+	schedulePreview();
+}
 
-	// Apply each operation with progress update
-	if (!updateProgress(1)) return;
-	applyRotation(img);
 
-	if (!updateProgress(2)) return;
-	applyBrightness(img);
 
-	if (!updateProgress(3)) return;
-	applyContrast(img);
+// --- Adjustment Implementations ---
 
-	if (!updateProgress(4)) return;
-	applySaturation(img);
+ColorAdjustments PhotoEditorDialog::adjustments() const
+{
+	ColorAdjustments values;
+	values.brightness = m_brightness;
+	values.contrast = m_contrast;
+	values.saturation = m_saturation;
+	values.temperature = m_temperature;
+	values.red = m_red;
+	values.green = m_green;
+	values.blue = m_blue;
+	values.filter = m_activeFilter;
+	return values;
+}
 
-	if (!updateProgress(5)) return;
-	applyTemperature(img);
+EditRecipe PhotoEditorDialog::recipe() const
+{
+	EditRecipe recipe;
+	recipe.rotation = m_rotation;
+	recipe.crop = m_crop;
+	recipe.adjustments = adjustments();
+	recipe.watermarkPath = m_watermarkPath;
+	recipe.watermarkPosition = m_watermarkPosition;
+	recipe.watermarkOpacity = m_watermarkOpacity;
+	return recipe;
+}
 
-	if (!updateProgress(6)) return;
-	applyRGB(img);
+void PhotoEditorDialog::setRecipe(const EditRecipe& recipe)
+{
+	m_rotation = recipe.rotation;
+	m_crop = recipe.crop;
+	m_watermarkPath = recipe.watermarkPath;
+	m_watermarkImage = recipe.watermarkPath.isEmpty() ? QImage() : QImage(recipe.watermarkPath);
 
-	if (!updateProgress(7)) return;
-	applyActiveFilter(img);
+	// Controls update the values through their signals
+	brightnessSlider->setValue(recipe.adjustments.brightness);
+	contrastSlider->setValue(recipe.adjustments.contrast);
+	saturationSlider->setValue(recipe.adjustments.saturation);
+	temperatureSlider->setValue(recipe.adjustments.temperature);
+	redSlider->setValue(recipe.adjustments.red);
+	greenSlider->setValue(recipe.adjustments.green);
+	blueSlider->setValue(recipe.adjustments.blue);
+	filterCombo->setCurrentIndex(recipe.adjustments.filter);
+	watermarkOpacitySlider->setValue(recipe.watermarkOpacity);
+	watermarkPositionCombo->setCurrentIndex(recipe.watermarkPosition);
+}
 
-	if (!updateProgress(8)) return;
-	applyWatermark(img);
 
-	// If we get here, all operations completed
-	if (progress) {
-		progress->setValue(8);
-	}
+// --- Actions ---
 
-	m_editedPixmap = QPixmap::fromImage(img);
-	m_photoPtr->setEditedPixmap(m_editedPixmap);
+void PhotoEditorDialog::applyChanges()
+{
+	// Only the recipe is stored, pixels are rendered when the photo is shown or exported
+	m_photoPtr->setEditRecipe(recipe());
 
 	accept();
 }
 
 void PhotoEditorDialog::resetChanges()
 {
-	// Reset all values
-	m_rotation = 0;
-	m_brightness = 0;
-	m_contrast = 0;
-	m_saturation = 0;
-	m_activeFilter = 0;
-	m_watermarkPixmap = QPixmap();
-	m_watermarkOpacity = DEFAULT_WATERMARK_OPACITY;
-	m_watermarkPosition = DEFAULT_WATERMARK_POSITION;
-	m_temperature = 0;
-	m_red = 0;
-	m_green = 0;
-	m_blue = 0;
-
-	// Reset UI controls
-	brightnessSlider->setValue(DEFAULT_ADJUSTMENT);
-	contrastSlider->setValue(DEFAULT_ADJUSTMENT);
-	saturationSlider->setValue(DEFAULT_ADJUSTMENT);
-	filterCombo->setCurrentIndex(0);
-	watermarkOpacitySlider->setValue(DEFAULT_WATERMARK_OPACITY);
-	watermarkPositionCombo->setCurrentIndex(DEFAULT_WATERMARK_POSITION);
-	temperatureSlider->setValue(DEFAULT_ADJUSTMENT);
-	redSlider->setValue(DEFAULT_ADJUSTMENT);
-	greenSlider->setValue(DEFAULT_ADJUSTMENT);
-	blueSlider->setValue(DEFAULT_ADJUSTMENT);
-
-	m_previewPixmap = m_originalPixmap.scaled(
-		1024, 1024,
-		Qt::KeepAspectRatio,
-		Qt::FastTransformation
-	);
-	updatePreview();
+	// Reset all values and controls
+	setRecipe(EditRecipe());
+	m_view = QRectF();
+	schedulePreview();
 }
 
 void PhotoEditorDialog::displayScaledPreview()
 {
 
 	// Scale the edited pixmap to fit the preview label while maintaining aspect ratio
-	QPixmap scaled = m_previewPixmap.scaled(previewLabel->size(), Qt::KeepAspectRatio, Qt::SmoothTransformation);
+	QPixmap scaled = QPixmap::fromImage(m_previewImage.scaled(previewLabel->size(), Qt::KeepAspectRatio, Qt::SmoothTransformation));
 	previewLabel->setPixmap(scaled);
 }
 
@@ -715,126 +721,9 @@ void PhotoEditorDialog::displayScaledPreview()
 void PhotoEditorDialog::applyFilter(int filterIndex)
 {
 	m_activeFilter = filterIndex;
-	updatePreview(); // Update preview with new filter
-}
-
-void PhotoEditorDialog::applyActiveFilter(QImage& image)
-{
-	if (m_activeFilter == 0)
-		return; // None
-
-	// Show progress dialog for large images
-	bool showProgress = (image.width() * image.height() > PROGRESS_THRESHOLD_PIXELS); // 1 megapixel
-	QProgressDialog* progress = nullptr;
-
-	if (showProgress) // Create progress dialog if needed
-	{
-		progress = new QProgressDialog("Applying filter...", "Cancel", 0, 100, this);
-		progress->setWindowModality(Qt::WindowModal);
-		progress->setMinimumDuration(0);
-	}
-
-	processImagePixels(image, progress, m_activeFilter);
-
-	if (progress) // Clean up progress dialog
-	{
-		progress->setValue(100);
-		delete progress;
-	}
-}
-
-void PhotoEditorDialog::processImagePixels(QImage& image, QProgressDialog* progress, int filterNumber) // filterNumber: 0 = none, 1 = grayscale, 2 = sepia, 3 = negative, 4 = pastel, 5 = vintage
-{
-	if (image.format() != QImage::Format_RGB32)
-		image = image.convertToFormat(QImage::Format_RGB32);
-
-	int width = image.width();
-	int height = image.height();
-
-	if (progress)
-	{
-		progress->setMaximum(height);
-		progress->show();
-	}
-
-	for (int y = 0; y < height; y++)
-	{
-		QRgb* line = (QRgb*)image.scanLine(y);
-
-		for (int x = 0; x < width; x++)
-		{
-			QRgb pixel = line[x];
-
-			int r = qRed(pixel);
-			int g = qGreen(pixel);
-			int b = qBlue(pixel);
-
-			int nr = r;
-			int ng = g;
-			int nb = b;
-
-			switch (filterNumber)
-			{
-			case 1: // Grayscale
-			{
-				int gray = qGray(pixel);
-				nr = ng = nb = gray;
-				break;
-			}
-			case 2: // Sepia
-			{
-				nr = qMin(255, int(0.393 * r + 0.769 * g + 0.189 * b));
-				ng = qMin(255, int(0.349 * r + 0.686 * g + 0.168 * b));
-				nb = qMin(255, int(0.272 * r + 0.534 * g + 0.131 * b));
-				break;
-			}
-			case 3: // Negative
-			{
-				nr = 255 - r;
-				ng = 255 - g;
-				nb = 255 - b;
-				break;
-			}
-			case 4: // Pastel
-			{
-				nr = qBound(0, int(r * 0.8 + 70), 255);
-				ng = qBound(0, int(g * 0.8 + 60), 255);
-				nb = qBound(0, int(b * 0.9 + 95), 255);
-				break;
-			}
-			case 5: // Vintage
-			{
-				int gray = qGray(pixel);
-				int dr = (r + gray * 2) / 3;
-				int dg = (g + gray * 2) / 3;
-				int db = (b + gray * 2) / 3;
-
-				nr = qBound(0, int(dr * 0.9 + dg * 0.5 + db * 0.2), 255);
-				ng = qBound(0, int(dr * 0.3 + dg * 0.7 + db * 0.2), 255);
-				nb = qBound(0, int(dr * 0.1 + dg * 0.3 + db * 0.6), 255);
-
-				nr = (nr + 255) / 2;
-				ng = (ng + 255) / 2;
-				nb = (nb + 255) / 2;
-				break;
-			}
-			default:
-				// 0 alebo neznmy filter = ni sa nemen
-				break;
-			}
-
-			line[x] = qRgb(nr, ng, nb);
-		}
-
-		if (progress && y % 10 == 0)
-		{
-			progress->setValue(y);
-			QCoreApplication::processEvents();
-		}
-	}
+	schedulePreview(); // Update preview with new filter
 }
 
-
 // --- Watermark ---
 
 void PhotoEditorDialog::addWatermark()
@@ -846,104 +735,8 @@ void PhotoEditorDialog::addWatermark()
 
 	if (!file.isEmpty()) // If a file was selected
 	{
-		m_watermarkPixmap = QPixmap(file);
-		updatePreview(); // Refresh preview to show watermark
-	}
-}
-
-void PhotoEditorDialog::applyWatermark(QImage& image)
-{
-	if (m_watermarkPixmap.isNull()) return; // No watermark to apply
-
-	QPainter painter(&image);
-	painter.setOpacity(m_watermarkOpacity / 100.0); // UI slider gives 0-100, convert to 0.0-1.0
-
-	// Scale watermark to 1/4 of image width
-	int wmWidth = image.width() / 4;
-	QPixmap scaledWm = m_watermarkPixmap.scaled(wmWidth, wmWidth, Qt::KeepAspectRatio, Qt::SmoothTransformation);
-
-
-	painter.drawPixmap(calculateWatermarkPosition(image.size(), scaledWm.size()), scaledWm); // Draw watermark at calculated position
-	painter.end(); // End painting
-}
-
-QPoint PhotoEditorDialog::calculateWatermarkPosition(const QSize& imageSize, const QSize& watermarkSize)
-{
-	int x = 0, y = 0;
-
-	switch (m_watermarkPosition)
-	{
-	case 0: // Top Left
-		x = WATERMARK_MARGIN;
-		y = WATERMARK_MARGIN;
-		break;
-
-	case 1: // Top Right
-		x = imageSize.width() - watermarkSize.width() - WATERMARK_MARGIN;
-		y = WATERMARK_MARGIN;
-		break;
-
-	case 2: // Bottom Left
-		x = WATERMARK_MARGIN;
-		y = imageSize.height() - watermarkSize.height() - WATERMARK_MARGIN;
-		break;
-
-	case 3: // Bottom Right
-		x = imageSize.width() - watermarkSize.width() - WATERMARK_MARGIN;
-		y = imageSize.height() - watermarkSize.height() - WATERMARK_MARGIN;
-		break;
-
-	case 4: // Center
-		x = (imageSize.width() - watermarkSize.width()) / 2;
-		y = (imageSize.height() - watermarkSize.height()) / 2;
-		break;
-	}
-
-	return QPoint(x, y); // Return calculated position
-}
-
-
-// --- Temperature ---
-void PhotoEditorDialog::applyTemperature(QImage& image)
-{
-	if (m_temperature == 0) return;
-
-	double factor = m_temperature / 100.0; // -1.0 to +1.0
-
-	for (int y = 0; y < image.height(); y++) {
-		QRgb* line = reinterpret_cast<QRgb*>(image.scanLine(y));
-		for (int x = 0; x < image.width(); x++) {
-			QColor color = QColor::fromRgb(line[x]);
-
-			int r = std::clamp(int(color.red() + 30 * factor), 0, 255);
-			int b = std::clamp(int(color.blue() - 30 * factor), 0, 255);
-
-			line[x] = qRgb(r, color.green(), b);
-		}
+		m_watermarkPath = file;
+		m_watermarkImage = QImage(file);
+		schedulePreview(); // Refresh preview to show watermark
 	}
 }
-
-
-// --- RGB Adjustments ---
-void PhotoEditorDialog::applyRGB(QImage& image)
-{
-	if (m_red == 0 && m_green == 0 && m_blue == 0) return;
-
-	// Convert -100..100 to 0.0..2.0 multiplier
-	double rFactor = 1.0 + (m_red / 100.0);    // -100 -> 0.0, 0 -> 1.0, +100 -> 2.0
-	double gFactor = 1.0 + (m_green / 100.0);
-	double bFactor = 1.0 + (m_blue / 100.0);
-
-	for (int y = 0; y < image.height(); y++) {
-		QRgb* line = reinterpret_cast<QRgb*>(image.scanLine(y));
-		for (int x = 0; x < image.width(); x++) {
-			QColor color = QColor::fromRgb(line[x]);
-
-			int r = std::clamp(int(color.red() * rFactor), 0, 255);
-			int g = std::clamp(int(color.green() * gFactor), 0, 255);
-			int b = std::clamp(int(color.blue() * bFactor), 0, 255);
-
-			line[x] = qRgb(r, g, b);
-		}
-	}
-}
\ No newline at end of file
@@ -1,6 +1,7 @@
 #pragma once
 #include <QDialog>
 #include "Photo.h"
+#include "EditRecipe.h"
 
 class QLabel;
 class QSlider;
@@ -11,6 +12,8 @@ class QRubberBand;
 class QComboBox;
 class QVBoxLayout;
 class QProgressDialog;
+class PreviewRenderer;
+class ImageLoader;
 
 /**
  * @brief Photo editing dialog with adjustments, filters, and watermarks
@@ -21,6 +24,9 @@ class QProgressDialog;
  * Crop tool with visual selection
  * Preset filters: grayscale, sepia, negative, pastel, vintage
  * Watermark overlay with position and opacity control
+ *
+ * Edits are non-destructive: Apply stores the EditRecipe with the photo,
+ * and the editor reopens it with the previous values.
  */
 class PhotoEditorDialog : public QDialog {
     Q_OBJECT
@@ -67,10 +73,37 @@ private slots:
     void rotateRight();
 
     /**
-     * @brief Updates the preview image with current adjustments and filters.
+     * @brief Requests a preview render with current adjustments and filters.
+     * @details Renders on a worker thread, see PreviewRenderer.
      */
     void updatePreview();
 
+    /**
+     * @brief Shows a finished preview render.
+     * @param image Preview scaled to the label.
+     */
+    void showPreview(const QImage& image);
+
+    /**
+     * @brief Requests a high-quality preview once input has been idle for a moment.
+     * @details Zoomed views render the visible region of the full-resolution
+     * original; the whole photo is rendered from a smooth proxy at about twice
+     * the display resolution.
+     */
+    void refinePreview();
+
+    /**
+     * @brief Takes the reduced-scale decode as the proxy until the full image arrives.
+     * @param preview Decoded preview, see ImageLoader.
+     */
+    void setPreviewImage(const QImage& preview);
+
+    /**
+     * @brief Takes the full-resolution decode and refines the preview.
+     * @param image Decoded original, see ImageLoader.
+     */
+    void setOriginalImage(const QImage& image);
+
     // Actions
     /**
      * @brief Applies all changes to the photo.
@@ -114,28 +147,68 @@ private:
     void connectSignals();
     void connectSliderWithSpinbox(QSlider* slider, QSpinBox* spinbox, int& value);
 
+    /**
+     * @brief Schedules a preview update for the end of the current frame.
+     * @details Changes arriving until then share one render.
+     */
+    void schedulePreview();
+
+    /**
+     * @brief Returns the preview label size in device pixels.
+     */
+    QSize displaySize() const;
+
+    /**
+     * @brief Creates the proxy image interactive previews render from.
+     * @details Sized so that the cropped result fills the label, rebuilt
+     * only when more pixels are needed.
+     */
+    void ensureProxy();
+
+    /**
+     * @brief Zooms the preview around a point.
+     * @param steps Wheel steps, positive zooms in.
+     * @param position Point in label coordinates that stays in place.
+     */
+    void zoomPreview(int steps, const QPointF& position);
+
+    /**
+     * @brief Returns the zoom at which one original pixel fills one device pixel.
+     */
+    double maxZoom() const;
+
     // Image processing
-    void applyRotation(QImage& image);
-    void applyContrast(QImage& image);
-    void applySaturation(QImage& image);
-    void applyBrightness(QImage& image);
-    void applyActiveFilter(QImage& image);
-    void applyWatermark(QImage& image);
     void displayScaledPreview();
 
-    // Filters
-    void processImagePixels(QImage& image, QProgressDialog* progress, int filterNumber);
+    /**
+     * @brief Collects the current slider values and filter preset.
+     * @return Adjustments for PointTransform.
+     */
+    ColorAdjustments adjustments() const;
 
-    // Watermark positioning
-    QPoint calculateWatermarkPosition(const QSize& imageSize, const QSize& watermarkSize);
+    /**
+     * @brief Collects the current edit.
+     * @return Recipe rendered by ImagePipeline.
+     */
+    EditRecipe recipe() const;
+
+    /**
+     * @brief Sets all values and controls from a recipe.
+     * @param recipe Edit to show.
+     */
+    void setRecipe(const EditRecipe& recipe);
 
     // Original photo data
-    Photo m_originalPhoto;
     Photo* m_photoPtr;
 
-    QPixmap m_originalPixmap;
-    QPixmap m_editedPixmap;
-    QPixmap m_previewPixmap;
+    QImage m_originalImage;     ///< Full-resolution original, source of refined previews; null while decoding.
+    QSize m_originalSize;       ///< Size of the original, read from the file header.
+    QImage m_previewImage;      ///< Display-sized proxy interactive previews are rendered from.
+    QImage m_refineImage;       ///< Smooth proxy at about twice the display size, source of unzoomed refined previews.
+    QPixmap m_renderedPreview;  ///< Latest rendered preview, as shown.
+    QRectF m_view;              ///< Zoomed part of the result, normalized; null shows all of it.
+    PreviewRenderer* m_previewRenderer;
+    ImageLoader* m_imageLoader;
 
     // UI components
     QLabel* previewLabel;
@@ -156,17 +229,20 @@ private:
     QPushButton* resetBtn;
     QPushButton* cancelBtn;
     QTimer* updateTimer;
+    QTimer* refineTimer;
 
 
     // Adjustment values
     int m_rotation;
+    QRectF m_crop;  ///< Normalized crop of the rotated image, null = uncropped.
     int m_brightness;
     int m_contrast;
     int m_saturation;
 
     // Filter & watermark
     int m_activeFilter;
-    QPixmap m_watermarkPixmap;
+    QString m_watermarkPath;
+    QImage m_watermarkImage;
     int m_watermarkOpacity;
     int m_watermarkPosition;
 
@@ -176,7 +252,6 @@ private:
     int m_temperature;
     QSlider* temperatureSlider;
     QSpinBox* temperatureValue;
-    void applyTemperature(QImage& image);
 
 
     // V private members:
@@ -192,7 +267,4 @@ private:
     QSpinBox* greenValue;
     QSpinBox* blueValue;
 
-    // V private functions:
-    void applyRGB(QImage& image);
-
 };
\ No newline at end of file
@@ -11,6 +11,8 @@
 #include <QApplication>
 #include <QTimer>
 
+static const int PROGRESS_STEPS = 100; // Progress bar steps per photo, filled by the tile render
+
 // --- Constructor ---
 PhotoExportDialog::PhotoExportDialog(const QList<Photo*>& photosToExport, QWidget* parent)
     : QDialog(parent),
@@ -127,7 +129,7 @@ void PhotoExportDialog::createTableRow(int row, Photo* photo)
 
     // Column 1: Preview
     QPixmap preview = photo->hasEditedVersion() 
-        ? photo->editedPixmap().scaled(100, 100, Qt::KeepAspectRatio, Qt::SmoothTransformation)
+        ? QPixmap::fromImage(photo->renderImage(100)) // Edit rendered from a reduced decode
         : photo->preview();    
     
     QLabel* previewLabel = new QLabel();
@@ -407,9 +409,12 @@ void PhotoExportDialog::onExportClicked()
 void PhotoExportDialog::exportPhotos()
 {
     setExportButtonsEnabled(false);
+	m_btnCancel->setEnabled(true); // Stops the export instead of closing the dialog
+    m_exporting = true;
+    m_exportCanceled = false;
 
     m_progressBar->setVisible(true);
-    m_progressBar->setMaximum(m_tableWidget->rowCount());
+    m_progressBar->setMaximum(m_tableWidget->rowCount() * PROGRESS_STEPS);
     m_progressBar->setValue(0);
 
     int exportedCount = 0;
@@ -420,7 +425,7 @@ void PhotoExportDialog::exportPhotos()
     QMap<QString, QString> backupMap; // originalPath -> tempBackupPath
 
     // --- Main export loop ---
-    for (int i = 0; i < m_tableWidget->rowCount(); i++)
+    for (int i = 0; i < m_tableWidget->rowCount() && !m_exportCanceled; i++)
     {
         QWidget* widget = m_tableWidget->cellWidget(i, ColCheckbox);
         QCheckBox* checkbox = widget ? widget->findChild<QCheckBox*>() : nullptr;
@@ -445,18 +450,30 @@ void PhotoExportDialog::exportPhotos()
                 backupMap.insert(originalPath, backupPath);
         }
 
-        // --- Save edited or original pixmap ---
-        QPixmap pixmapToSave = photo->hasEditedVersion()
-            ? photo->editedPixmap()
-            : QPixmap(photo->filePath());
+        // --- Render the edit at full resolution and save it ---
+        const bool edited = photo->hasEditedVersion();
+        QImage imageToSave = photo->renderImage(0, [this, i](int finishedTiles, int totalTiles) {
+            m_progressBar->setValue(i * PROGRESS_STEPS + finishedTiles * PROGRESS_STEPS / qMax(totalTiles, 1));
+			QApplication::processEvents(); // Keeps the Cancel button responsive
+            return !m_exportCanceled;
+            });
+
+		if (m_exportCanceled) // Render stopped, nothing was written
+        {
+            if (!backupPath.isEmpty())
+                QFile::remove(backupPath);
+            break;
+        }
 
-        bool success = pixmapToSave.save(newPath);
+        bool success = imageToSave.save(newPath);
 
         if (success)
         {
             exportedCount++;
             if (overwriting && !backupPath.isEmpty())
                 QFile::remove(backupPath); // backup no longer needed
+            if (overwriting && edited)
+                photo->setEditRecipe(EditRecipe()); // Edit is now part of the file, must not be applied twice
         }
         else
         {
@@ -476,9 +493,10 @@ void PhotoExportDialog::exportPhotos()
             }
         }
 
-        m_progressBar->setValue(i + 1);
+        m_progressBar->setValue((i + 1) * PROGRESS_STEPS);
         QApplication::processEvents();
     }
+    m_exporting = false;
 
     // Cleanup: remove any leftover backups
     for (auto it = backupMap.begin(); it != backupMap.end(); ++it)
@@ -488,7 +506,12 @@ void PhotoExportDialog::exportPhotos()
     m_progressBar->setVisible(false);
 
     // --- Result message ---
-    if (failedCount == 0)
+    if (m_exportCanceled)
+    {
+        QMessageBox::information(this, "Export Canceled",
+            QString("Export was canceled after %1 photo(s).").arg(exportedCount));
+    }
+    else if (failedCount == 0)
     {
         QMessageBox::information(this, "Export Complete",
             QString("Successfully exported %1 photo(s)!").arg(exportedCount));
@@ -519,5 +542,12 @@ void PhotoExportDialog::setExportButtonsEnabled(bool enabled)
 // --- Cancel Export ---
 void PhotoExportDialog::onCancelClicked() 
 {
+	if (m_exporting) // Export loop stops after the current tile
+    {
+        m_exportCanceled = true;
+        m_btnCancel->setEnabled(false);
+        return;
+    }
+
 	reject(); // Close dialog without exporting
 }
\ No newline at end of file
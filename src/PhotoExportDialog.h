@@ -72,7 +72,7 @@ private slots:
     void onExportClicked();
 
     /**
-    * @brief Cancels export and closes the dialog.
+    * @brief Closes the dialog, or stops a running export after the current render.
     */
     void onCancelClicked();
 
@@ -157,6 +157,10 @@ private:
     QPushButton* m_btnCancel;
     QProgressBar* m_progressBar;
 
+    // --- Export state ---
+    bool m_exporting = false;       ///< True while exportPhotos() runs.
+    bool m_exportCanceled = false;  ///< Set by the Cancel button during an export.
+
     // --- Data ---
     QList<Photo*> m_photosToExport;
 
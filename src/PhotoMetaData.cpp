@@ -1,11 +1,25 @@
 #include "PhotoMetadata.h"
+#include "SqliteMetadataStore.h"
+#include "JournalMetadataStore.h"
+#include "ShardedMetadataStore.h"
+#include "MetadataPersistence.h"
+#include "MetadataSnapshot.h"
+#include "JsonStream.h"
+#include <QSettings>
+#include <QSaveFile>
 #include <QJsonDocument>
 #include <QJsonArray>
 #include <QFile>
 #include <QFileInfo>
 #include <QStandardPaths>
 #include <QDir>
+#include <QDateTime>
 
+// Imported records handed to the store before waiting for it, bounds memory of large imports
+static const int IMPORT_BATCH_SIZE = 4096;
+
+// Snapshot entries kept decoded by photoData(), bounds memory of large catalogs
+static const int DECODED_CACHE_SIZE = 16384;
 
 // -------------------------
 //   PhotoData
@@ -14,25 +28,68 @@
 QJsonObject PhotoData::toJson() const 
 {
 	// Serialize PhotoData to JSON object
-    return 
+    QJsonObject json
     {
         {"filePath", filePath},
-        {"tag", tag},
+        {"tags", QJsonArray::fromStringList(tags)},
         {"rating", rating},
         {"comment", comment}
     };
+
+	if (hasPerceptualHash) // Hex string, JSON numbers cannot hold 64 bits
+        json["perceptualHash"] = QString::number(perceptualHash, 16);
+
+	if (contentHashSize >= 0) // Only fingerprinted files carry the fields
+    {
+        json["contentHash"] = QString::number(contentHash, 16);
+        json["contentHashSize"] = contentHashSize;
+        json["contentHashModified"] = contentHashModified;
+    }
+
+	if (missingSince != 0) // Only tombstoned entries carry the field
+        json["missingSince"] = missingSince;
+	if (!edit.isIdentity()) // Only edited photos carry a recipe
+        json["edit"] = edit.toJson();
+    return json;
 }
 
 PhotoData PhotoData::fromJson(const QJsonObject& json) 
 {
 	// Deserialize PhotoData from JSON object
-    return 
+    PhotoData data;
+    data.filePath = json["filePath"].toString();
+    data.rating = json["rating"].toInt();
+    data.comment = json["comment"].toString();
+    data.perceptualHash = json["perceptualHash"].toString().toULongLong(nullptr, 16);
+	data.hasPerceptualHash = json.contains("perceptualHash"); // Only hashed photos carry the field
+    data.contentHash = json["contentHash"].toString().toULongLong(nullptr, 16);
+    data.contentHashSize = json["contentHashSize"].toInteger(-1);
+    data.contentHashModified = json["contentHashModified"].toInteger();
+    data.missingSince = json["missingSince"].toInteger();
+    data.edit = EditRecipe::fromJson(json["edit"].toObject());
+
+	if (json.contains("tags")) // Tag list
     {
-        json["filePath"].toString(),
-        json["tag"].toString(),
-        json["rating"].toInt(),
-        json["comment"].toString()
-    };
+        for (const auto& val : json["tags"].toArray())
+            data.tags.append(val.toString());
+        data.tags = parseTags(data.tags.join(','));
+    }
+	else // Files written before multi-tag support store a single string
+        data.tags = parseTags(json["tag"].toString());
+
+    return data;
+}
+
+QStringList PhotoData::parseTags(const QString& text)
+{
+    QStringList result;
+    for (const QString& part : text.split(',', Qt::SkipEmptyParts))
+    {
+        const QString tag = part.trimmed();
+		if (!tag.isEmpty() && !result.contains(tag, Qt::CaseInsensitive)) // Skip blanks and duplicates
+            result.append(tag);
+    }
+    return result;
 }
 
 
@@ -47,82 +104,491 @@ PhotoMetadataManager& PhotoMetadataManager::instance()
     return instance;
 }
 
+QString PhotoMetadataManager::s_dataDirectory;
+
+// Redirect the store, used before the singleton is created
+void PhotoMetadataManager::setDataDirectory(const QString& folder)
+{
+    s_dataDirectory = folder;
+}
+
 // Constructor and Destructor
 PhotoMetadataManager::PhotoMetadataManager() 
 {
+	m_decoded.setMaxCost(DECODED_CACHE_SIZE); // Least recently read entries are dropped first
+    m_persistence = std::make_unique<MetadataPersistence>(createStore(m_currentFilePath));
+	m_persistence->open(m_currentFilePath); // Open (or create) the metadata store on the writer thread
+
+	// One-time migration of the JSON catalog written by older versions. The marker stays set until
+	// the file is renamed, so an interrupted migration is resumed even though the store is not empty
+    const QString legacyPath = legacyJsonFilePath();
+    const std::unique_ptr<QSettings> settings = openSettings();
+    const bool resume = settings->value("metadata/jsonMigrationPending", false).toBool();
+    if (QFileInfo::exists(legacyPath) && (resume || m_persistence->isEmpty()))
+    {
+        settings->setValue("metadata/jsonMigrationPending", true);
+
+        QSet<QString> storedKeys;
+		if (resume) // Entries stored before the interruption (and edits made since) are kept
+        {
+            const QStringList keys = m_persistence->loadKeys();
+            storedKeys = QSet<QString>(keys.cbegin(), keys.cend());
+        }
+
+        if (importJson(legacyPath, storedKeys) && QFile::rename(legacyPath, legacyPath + ".migrated"))
+            settings->remove("metadata/jsonMigrationPending");
+    }
+    else if (resume) // Legacy file removed meanwhile, nothing left to migrate
+        settings->remove("metadata/jsonMigrationPending");
+
 	loadFromFile(); // Load metadata at construction
+
+	// Missing files are found in the background instead of on every save
+    m_sweeper = std::make_unique<TombstoneSweeper>(
+        [this]() { return entryKeys(); },
+        [this](const QStringList& keys, const QList<TombstoneSweeper::FileState>& states) { applySweepResults(keys, states); });
+    m_sweeper->start();
 }
 
 PhotoMetadataManager::~PhotoMetadataManager() 
 {
-	saveToFile(); // Save metadata at destruction
+	m_sweeper->stop(); // No tombstone updates after the store is closed
+	m_persistence->shutdown(); // Last resort, the application should have called flush()
 }
 
 // Default file path for metadata storage
 QString PhotoMetadataManager::defaultFilePath() const 
 {
-	const QString basePath = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation); // e.g., %APPDATA%/PhotoManager on Windows
+	const QString basePath = s_dataDirectory.isEmpty() // e.g., %APPDATA%/PhotoManager on Windows
+        ? QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) : s_dataDirectory;
     QDir().mkpath(basePath);
-    return basePath + "/photo_metadata.json";
+    return basePath + "/photo_metadata.db";
+}
+
+// JSON catalog used before the metadata database
+QString PhotoMetadataManager::legacyJsonFilePath() const
+{
+    return QFileInfo(defaultFilePath()).absolutePath() + "/photo_metadata.json";
 }
 
-// Load metadata from JSON file
+// Settings travel with a redirected data directory
+std::unique_ptr<QSettings> PhotoMetadataManager::openSettings() const
+{
+    if (s_dataDirectory.isEmpty())
+        return std::make_unique<QSettings>("TssApp", "PhotoViewer");
+    return std::make_unique<QSettings>(s_dataDirectory + "/settings.ini", QSettings::IniFormat);
+}
+
+// Store backend chosen in settings, files live next to the metadata database
+std::unique_ptr<MetadataStore> PhotoMetadataManager::createStore(QString& filePath) const
+{
+    const QString sqlitePath = defaultFilePath();
+    const QString basePath = QFileInfo(sqlitePath).absolutePath();
+
+	// SQLite unless the snapshot-backed journal is chosen explicitly
+    const QString backend = openSettings()->value("metadata/backend", "sqlite").toString();
+
+	if (backend == "journal") // Append-only journal with background compaction
+    {
+        filePath = basePath + "/photo_metadata.journal";
+        return std::make_unique<ShardedMetadataStore>([]() { return std::make_unique<JournalMetadataStore>(); });
+    }
+
+    filePath = sqlitePath;
+    return std::make_unique<ShardedMetadataStore>([shardCount = 0]() mutable {
+		// Every shard needs its own QtSql connection
+        return std::make_unique<SqliteMetadataStore>(QString("photo_metadata_%1").arg(shardCount++));
+    });
+}
+
+// Load metadata from the store, or import a JSON file first
 bool PhotoMetadataManager::loadFromFile(const QString& filePath) 
 {
-    const QString path = filePath.isEmpty() ? defaultFilePath() : filePath;
-    m_currentFilePath = path;
+	if (!filePath.isEmpty() && !importJson(filePath)) // Explicit JSON import
+        return false;
+
+	m_metadata.clear(); // Clear existing metadata, path handles stay valid
+    m_removed.clear();
+    m_decoded.clear();
+    m_shards.clear();
+	m_snapshotIndexes.clear(); // Waits for decodes still running
+    m_indexed.clear();
+    m_tagDictionary.clear();
+    m_tagIndex.clear();
+    m_textIndex.clear();
+	m_indexesBuilt = false; // Rebuilt on first query
+
+	// Shards are loaded when one of their photos is first requested
+    m_roots = m_persistence->roots();
+    return true;
+}
+
+// Load the records of one root, snapshot entries stay in the mapped file
+void PhotoMetadataManager::loadShard(const QString& root)
+{
+    if (m_shards.contains(root))
+        return;
+
+    std::shared_ptr<const MetadataSnapshot> snapshot;
+    QStringList keys;
+    QStringList removedKeys;
+    const QList<PhotoData> records = m_persistence->loadRoot(root, snapshot, keys, removedKeys);
+	m_shards.insert(root, snapshot); // Before indexing, lookups below must not load it again
+
+	for (int i = 0; i < records.size(); ++i) // Load each photo entry
+    {
+        PhotoData data = records[i];
+		data.filePath.clear(); // Path lives in the path table only
+        m_metadata.insert(m_paths.intern(keys[i]), data);
+    }
+
+    for (const QString& key : std::as_const(removedKeys))
+        m_removed.insert(m_paths.intern(key));
+
+	// Searchable fields of the snapshot are decoded off the GUI thread, merged by the next query
+    if (snapshot)
+        m_snapshotIndexes.insert(root, std::async(std::launch::async, &PhotoMetadataManager::decodeIndexRecords, snapshot).share());
+
+	if (m_indexesBuilt) // Indexes cover all loaded shards
+    {
+        for (int i = 0; i < records.size(); ++i)
+        {
+			if (m_indexed.contains(m_paths.find(keys[i]))) // Indexed with its previous shard, e.g. moved by addRoot()
+                continue;
+
+            PhotoData data = records[i];
+            data.filePath = keys[i];
+            indexEntry(data);
+        }
+    }
+}
 
-    QFile file(path);
-    if (!file.exists()) // No metadata yet
+// Snapshot of the shard owning a photo, loading the shard if needed
+const MetadataSnapshot* PhotoMetadataManager::snapshotOf(const QString& key)
+{
+    const QString root = ShardedMetadataStore::ownerRoot(m_roots, key);
+    loadShard(root);
+    return m_shards.value(root).get();
+}
+
+// Give an imported folder its own shard
+bool PhotoMetadataManager::addRoot(const QString& folder)
+{
+    const QString root = QDir::cleanPath(QFileInfo(folder).absoluteFilePath());
+    if (m_roots.contains(root))
         return true;
 
-	if (!file.open(QIODevice::ReadOnly)) // Cannot open file
-        return false;
+	// Records below the folder move to the new shard; snapshot entries left in
+	// the old shard are no longer owned by it and are skipped from now on
+    const bool added = m_persistence->addRoot(root);
+    m_roots = m_persistence->roots();
+    return added;
+}
 
-	const QJsonDocument doc = QJsonDocument::fromJson(file.readAll()); // Parse JSON
-    file.close();
+// Add one entry to the tag and text indexes
+void PhotoMetadataManager::indexEntry(const PhotoData& data)
+{
+    const quint32 id = handleOf(data.filePath);
+    m_indexed.insert(id);
+    for (const QString& tag : data.tags)
+    {
+        m_tagDictionary.add(tag);
+        m_tagIndex.add(id, tag);
+    }
+    indexText(id, data.comment);
+}
 
-	if (!doc.isObject()) // Invalid format
-        return false;
+// Build the tag and text indexes over all loaded entries
+void PhotoMetadataManager::ensureIndexes()
+{
+    if (m_indexesBuilt)
+    {
+		mergeSnapshotIndexes(); // Shards loaded since the last query
+        return;
+    }
 
-	m_metadata.clear(); // Clear existing metadata
+	// In-memory entries are at hand, snapshot entries were decoded in the background
+    for (auto it = m_metadata.cbegin(); it != m_metadata.cend(); ++it)
+    {
+        PhotoData data = it.value();
+        data.filePath = m_paths.path(it.key());
+        indexEntry(data);
+    }
+    mergeSnapshotIndexes();
 
-	for (const auto& val : doc.object()["photos"].toArray()) // Load each photo entry
+	// Photos without metadata stay searchable by file name
+    for (PathTable::Handle id = 1; id <= PathTable::Handle(m_paths.size()); ++id)
     {
-        const PhotoData data = PhotoData::fromJson(val.toObject());
-		m_metadata.insert(QFileInfo(data.filePath).absoluteFilePath(), data); // Use absolute path as key
+        if (!m_textIndex.contains(id))
+            indexText(id, QString());
     }
-    return true;
+
+    m_indexesBuilt = true;
+}
+
+// Searchable fields of every snapshot entry, runs on a worker thread
+QList<PhotoMetadataManager::IndexRecord> PhotoMetadataManager::decodeIndexRecords(std::shared_ptr<const MetadataSnapshot> snapshot)
+{
+    QList<IndexRecord> records;
+    records.reserve(snapshot->count());
+    for (int i = 0; i < snapshot->count(); ++i)
+    {
+        const PhotoData data = snapshot->entry(i);
+        records.append({ data.filePath, data.tags, data.comment });
+    }
+    return records;
 }
 
-// Save metadata to JSON file
-bool PhotoMetadataManager::saveToFile(const QString& filePath) 
+// Add decoded snapshot entries to the indexes, waiting only for decodes still running
+void PhotoMetadataManager::mergeSnapshotIndexes()
 {
-    QString path = filePath.isEmpty() ? m_currentFilePath : filePath;
-    if (path.isEmpty())
-        path = defaultFilePath();
+    for (auto it = m_snapshotIndexes.cbegin(); it != m_snapshotIndexes.cend(); ++it)
+    {
+        for (const IndexRecord& record : it.value().get())
+        {
+			// Replaced or deleted in memory, or moved to a shard added later
+            if (isShadowed(record.key) || ShardedMetadataStore::ownerRoot(m_roots, record.key) != it.key())
+                continue;
+
+            const PathTable::Handle id = m_paths.intern(record.key);
+            if (m_indexed.contains(id))
+                continue;
+
+            m_indexed.insert(id);
+            for (const QString& tag : record.tags)
+            {
+                m_tagDictionary.add(tag);
+                m_tagIndex.add(id, tag);
+            }
+            indexText(id, record.comment);
+        }
+    }
+    m_snapshotIndexes.clear();
+}
+
+// True if a snapshot entry is replaced or deleted by a newer record
+bool PhotoMetadataManager::isShadowed(const QString& key) const
+{
+    const PathTable::Handle handle = m_paths.find(key);
+    return handle != 0 && (m_metadata.contains(handle) || m_removed.contains(handle));
+}
+
+// Snapshot keys that still belong to their shard and are not replaced in memory
+QStringList PhotoMetadataManager::snapshotKeys(const QString& root, const MetadataSnapshot& snapshot) const
+{
+    QStringList keys;
+    for (int i = 0; i < snapshot.count(); ++i)
+    {
+        const QString key = snapshot.key(i);
+        if (!isShadowed(key) && ShardedMetadataStore::ownerRoot(m_roots, key) == root)
+            keys.append(key);
+    }
+    return keys;
+}
+
+// Paths of all loaded entries, the in-memory ones shadow the snapshots
+QStringList PhotoMetadataManager::entryKeys() const
+{
+    QStringList keys;
+    keys.reserve(m_metadata.size());
+    for (auto it = m_metadata.cbegin(); it != m_metadata.cend(); ++it)
+        keys.append(m_paths.path(it.key()));
+
+    for (auto it = m_shards.cbegin(); it != m_shards.cend(); ++it)
+    {
+        if (it.value())
+            keys += snapshotKeys(it.key(), *it.value());
+    }
+    return keys;
+}
+
+const TagDictionary& PhotoMetadataManager::tagDictionary()
+{
+    ensureIndexes();
+    return m_tagDictionary;
+}
+
+RoaringBitmap PhotoMetadataManager::searchText(const QString& query)
+{
+    ensureIndexes();
+    return m_textIndex.search(query);
+}
+
+// Stream the entries of a JSON catalog into the store, one photo object in memory at a time
+bool PhotoMetadataManager::importJson(const QString& filePath, const QSet<QString>& skippedKeys)
+{
+    QFile file(filePath);
+	if (!file.exists()) // Nothing to import
+        return true;
+
+	if (!file.open(QIODevice::ReadOnly)) // Cannot open file
+        return false;
+
+    JsonStreamReader reader(&file);
+	if (reader.next() != JsonStreamReader::StartObject) // Invalid format
+        return false;
 
-	cleanupNonExistentFiles(); // if files were deleted, remove their metadata
+    int batched = 0;
+    while (reader.next() == JsonStreamReader::Key)
+    {
+		if (reader.text() != "photos") // Unknown member, skipped without building it
+        {
+            reader.next();
+            reader.skipValue();
+            continue;
+        }
+
+        if (reader.next() != JsonStreamReader::StartArray)
+            return false;
+
+		while (reader.next() == JsonStreamReader::StartObject) // Store each photo entry
+        {
+            PhotoData data = PhotoData::fromJson(reader.readValue().toObject());
+			data.filePath = QFileInfo(data.filePath).absoluteFilePath(); // Use absolute path as key
+            if (skippedKeys.contains(data.filePath))
+                continue;
+
+            m_persistence->markDirty(data.filePath, data);
 
-    QJsonArray photoArray;
-	for (const auto& data : m_metadata) // Serialize each PhotoData
-        photoArray.append(data.toJson());
+			if (++batched == IMPORT_BATCH_SIZE) // Keep pending records bounded
+            {
+                if (!m_persistence->flush())
+                    return false;
+                batched = 0;
+            }
+        }
 
-    const QJsonObject root{ {"photos", photoArray} };
+		if (reader.token() != JsonStreamReader::EndArray) // Truncated or malformed entry
+            return false;
+    }
+
+	if (reader.token() != JsonStreamReader::EndObject) // Records read so far are kept
+        return false;
+	return m_persistence->flush(); // Remaining records
+}
 
-    QFile file(path);
+// Wait for pending edits, or export the catalog as JSON
+bool PhotoMetadataManager::saveToFile(const QString& filePath, QJsonDocument::JsonFormat format) 
+{
+	if (filePath.isEmpty()) // Edits are stored in the background, just wait for them
+        return m_persistence->flush();
+
+	QSaveFile file(filePath); // Replaces the old export only when complete
 	if (!file.open(QIODevice::WriteOnly)) // Cannot open file for writing
         return false;
 
-	file.write(QJsonDocument(root).toJson(QJsonDocument::Indented)); // Write JSON to file, indented for readability
-    return true;
+	// Records are streamed from the store shard by shard, nothing is loaded into the catalog
+    JsonStreamWriter writer(&file, format);
+    writer.beginObject();
+    writer.writeKey("photos");
+    writer.beginArray();
+    m_persistence->forEachRecord([&writer](const QString& key, const PhotoData& data) {
+        QJsonObject json = data.toJson();
+        json["filePath"] = key;
+        writer.writeValue(json);
+    });
+    writer.endArray();
+    writer.endObject();
+
+    return writer.finish() && file.commit();
+}
+
+// Group following edits into one store transaction
+void PhotoMetadataManager::beginTransaction()
+{
+    m_persistence->hold();
+}
+
+void PhotoMetadataManager::commitTransaction()
+{
+    m_persistence->release();
+}
+
+// Wait until all edits are stored
+bool PhotoMetadataManager::flush()
+{
+    return m_persistence->flush();
+}
+
+// Update the in-memory entry and queue its record for writing
+void PhotoMetadataManager::writeEntry(const QString& key, const PhotoData& data)
+{
+    const PathTable::Handle handle = handleOf(key);
+    PhotoData& entry = m_metadata[handle];
+    entry = data;
+	entry.filePath.clear(); // Path lives in the path table only
+	m_removed.remove(handle); // Shadows the snapshot entry again
+    m_decoded.remove(handle);
+    m_persistence->markDirty(key, data);
+}
+
+// Drop an entry everywhere, snapshot entries are masked until the next compaction
+void PhotoMetadataManager::removeEntry(const QString& key)
+{
+    const PathTable::Handle handle = handleOf(key);
+	if (m_indexesBuilt) // Tags no longer used by this photo
+    {
+		if (m_indexed.contains(handle)) // Otherwise its snapshot entry is not merged yet
+        {
+            for (const QString& tag : getPhotoData(key).tags)
+            {
+                m_tagDictionary.remove(tag);
+                m_tagIndex.remove(handle, tag);
+            }
+        }
+        m_textIndex.remove(handle);
+    }
+
+    m_metadata.remove(handle);
+    m_decoded.remove(handle);
+    const MetadataSnapshot* snapshot = snapshotOf(key);
+    if (snapshot && snapshot->find(key) >= 0)
+        m_removed.insert(handle);
+    m_persistence->markRemoved(key);
 }
 
 // Get metadata for a specific photo
-PhotoData PhotoMetadataManager::getPhotoData(const QString& filePath) const 
+PhotoData PhotoMetadataManager::getPhotoData(const QString& filePath) 
 {
 	const QString key = QFileInfo(filePath).absoluteFilePath(); // Use absolute path as key
-    return m_metadata.value(key, PhotoData{ key }); 
+	const MetadataSnapshot* snapshot = snapshotOf(key); // Loads the shard on first access
+
+    const PathTable::Handle handle = m_paths.find(key);
+    const auto it = m_metadata.constFind(handle);
+	if (it != m_metadata.cend()) // Changed since the snapshot
+    {
+        PhotoData data = it.value();
+        data.filePath = key;
+        return data;
+    }
+
+	if (snapshot && !m_removed.contains(handle)) // Decode from the mapped snapshot
+    {
+        const int index = snapshot->find(key);
+        if (index >= 0)
+            return snapshot->entry(index);
+    }
+    return PhotoData{ key };
+}
+
+// Get metadata by id, recently decoded snapshot records are kept for the next read
+PhotoData PhotoMetadataManager::photoData(quint32 photoId)
+{
+	if (photoId == 0) // Photo without a file
+        return {};
+
+    const auto changed = m_metadata.constFind(photoId);
+    if (changed != m_metadata.cend())
+        return changed.value();
+
+    if (const PhotoData* decoded = m_decoded.object(photoId))
+        return *decoded;
+
+	PhotoData data = getPhotoData(m_paths.path(photoId)); // Loads the shard on first access
+    data.filePath.clear();
+	if (!m_metadata.contains(photoId)) // Not loaded into the overlay with the shard
+        m_decoded.insert(photoId, new PhotoData(data));
+    return data;
 }
 
 // Set rating for a specific photo
@@ -131,16 +597,43 @@ void PhotoMetadataManager::setRating(const QString& filePath, int rating)
 	const QString key = QFileInfo(filePath).absoluteFilePath(); // Use absolute path as key
     PhotoData data = getPhotoData(key);
     data.rating = qBound(0, rating, 5); // Clamp rating between 0 and 5
-    m_metadata[key] = data;
+    writeEntry(key, data);
 }
 
-// Set tag for a specific photo
+// Set tags for a specific photo from comma-separated input
 void PhotoMetadataManager::setTag(const QString& filePath, const QString& tag) 
+{
+    setTags(filePath, PhotoData::parseTags(tag));
+}
+
+// Set tags for a specific photo
+void PhotoMetadataManager::setTags(const QString& filePath, const QStringList& tags)
 {
 	const QString key = QFileInfo(filePath).absoluteFilePath(); // Use absolute path as key
     PhotoData data = getPhotoData(key);
-    data.tag = tag;
-    m_metadata[key] = data;
+    const quint32 id = photoId(key);
+
+	// Keep tag counts and postings in sync once they exist
+    if (m_indexesBuilt)
+    {
+		if (m_indexed.contains(id)) // Otherwise its snapshot entry is not merged yet, the new record shadows it
+        {
+            for (const QString& tag : std::as_const(data.tags))
+            {
+                m_tagDictionary.remove(tag);
+                m_tagIndex.remove(id, tag);
+            }
+        }
+        for (const QString& tag : tags)
+        {
+            m_tagDictionary.add(tag);
+            m_tagIndex.add(id, tag);
+        }
+        m_indexed.insert(id);
+    }
+
+    data.tags = tags;
+    writeEntry(key, data);
 }
 
 // Set comment for a specific photo
@@ -149,12 +642,202 @@ void PhotoMetadataManager::setComment(const QString& filePath, const QString& co
 	const QString key = QFileInfo(filePath).absoluteFilePath(); // Use absolute path as key
     PhotoData data = getPhotoData(key);
     data.comment = comment;
-    m_metadata[key] = data;
+    writeEntry(key, data);
+
+	if (m_indexesBuilt) // Keep full-text search up to date
+        indexText(handleOf(key), comment);
+}
+
+// Cache perceptual hash for a specific photo
+void PhotoMetadataManager::setPerceptualHash(const QString& filePath, quint64 hash)
+{
+	const QString key = QFileInfo(filePath).absoluteFilePath(); // Use absolute path as key
+    PhotoData data = getPhotoData(key);
+    data.perceptualHash = hash;
+    data.hasPerceptualHash = true;
+    writeEntry(key, data);
 }
 
-// Remove metadata entries for files that no longer exist
-void PhotoMetadataManager::cleanupNonExistentFiles() 
+// Cache content fingerprint together with the file state it belongs to
+void PhotoMetadataManager::setContentHash(const QString& filePath, quint64 hash, qint64 size, qint64 modified)
 {
-	for (auto it = m_metadata.begin(); it != m_metadata.end();) // Iterate through metadata entries
-		it = QFileInfo::exists(it.key()) ? ++it : m_metadata.erase(it); // Remove if file does not exist
+	const QString key = QFileInfo(filePath).absoluteFilePath(); // Use absolute path as key
+    PhotoData data = getPhotoData(key);
+    data.contentHash = hash;
+    data.contentHashSize = size;
+    data.contentHashModified = modified;
+    writeEntry(key, data);
+}
+
+// Store an edit as its recipe, pixels are rendered when needed
+void PhotoMetadataManager::setEditRecipe(const QString& filePath, const EditRecipe& recipe)
+{
+	const QString key = QFileInfo(filePath).absoluteFilePath(); // Use absolute path as key
+    PhotoData data = getPhotoData(key);
+    data.edit = recipe;
+    writeEntry(key, data);
+}
+
+// Rate a selection, all records go to the store in one batch
+void PhotoMetadataManager::setRatings(const QList<quint32>& photoIds, int rating)
+{
+    const int clamped = qBound(0, rating, 5);
+
+    beginTransaction();
+    for (quint32 id : photoIds)
+    {
+		if (id != 0 && photoData(id).rating != clamped) // Unchanged photos are not rewritten
+            setRating(m_paths.path(id), clamped);
+    }
+    commitTransaction();
+}
+
+// Tag a selection, all records go to the store in one batch
+void PhotoMetadataManager::addTags(const QList<quint32>& photoIds, const QStringList& tags)
+{
+    beginTransaction();
+    for (quint32 id : photoIds)
+    {
+        if (id == 0)
+            continue;
+
+        const QStringList current = photoData(id).tags;
+        QStringList merged = current;
+        for (const QString& tag : tags)
+        {
+            if (!merged.contains(tag, Qt::CaseInsensitive))
+                merged.append(tag);
+        }
+
+		if (merged.size() != current.size()) // At least one tag was new
+            setTags(m_paths.path(id), merged);
+    }
+    commitTransaction();
+}
+
+// Untag a selection, all records go to the store in one batch
+void PhotoMetadataManager::removeTags(const QList<quint32>& photoIds, const QStringList& tags)
+{
+    beginTransaction();
+    for (quint32 id : photoIds)
+    {
+        if (id == 0)
+            continue;
+
+        const QStringList current = photoData(id).tags;
+        QStringList kept;
+        for (const QString& tag : current)
+        {
+            if (!tags.contains(tag, Qt::CaseInsensitive))
+                kept.append(tag);
+        }
+
+		if (kept.size() != current.size()) // At least one tag was removed
+            setTags(m_paths.path(id), kept);
+    }
+    commitTransaction();
+}
+
+bool PhotoMetadataManager::hasEntry(const QString& key)
+{
+    const MetadataSnapshot* snapshot = snapshotOf(key);
+    const PathTable::Handle handle = m_paths.find(key);
+    if (m_metadata.contains(handle))
+        return true;
+    return snapshot && !m_removed.contains(handle) && snapshot->find(key) >= 0;
+}
+
+// Tombstone missing files, purge them once the grace period is over
+void PhotoMetadataManager::applySweepResults(const QStringList& keys, const QList<TombstoneSweeper::FileState>& states)
+{
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+
+    beginTransaction();
+    for (int i = 0; i < keys.size(); ++i)
+    {
+        const QString& key = keys[i];
+		if (!hasEntry(key)) // Removed while it was being checked
+            continue;
+
+        PhotoData data = getPhotoData(key);
+        switch (states[i])
+        {
+        case TombstoneSweeper::Present:
+			if (data.missingSince != 0) // File is back (e.g. restored from trash)
+            {
+                data.missingSince = 0;
+                writeEntry(key, data);
+            }
+            break;
+
+        case TombstoneSweeper::Missing:
+			if (data.missingSince == 0) // First time missing, start the grace period
+            {
+                data.missingSince = now;
+                writeEntry(key, data);
+            }
+            else if (now - data.missingSince >= TombstoneSweeper::GRACE_PERIOD_MS)
+                removeEntry(key);
+            break;
+
+		case TombstoneSweeper::Unavailable: // Drive or share offline, keep the entry as it is
+            break;
+        }
+    }
+    commitTransaction();
+}
+
+// Numeric photo id for the tag index, assigned on first request
+quint32 PhotoMetadataManager::photoId(const QString& filePath)
+{
+	return handleOf(QFileInfo(filePath).absoluteFilePath()); // Use absolute path as key
+}
+
+// Intern a key, new photos become searchable by file name right away
+PathTable::Handle PhotoMetadataManager::handleOf(const QString& key)
+{
+    const int known = m_paths.size();
+	const PathTable::Handle handle = m_paths.intern(key); // Ids start at 1 (0 = no photo)
+
+	if (m_indexesBuilt && m_paths.size() > known) // File name is searchable even without metadata
+        indexText(handle, getPhotoData(key).comment);
+    return handle;
+}
+
+// Comment and file name, separated so that substrings cannot span both
+void PhotoMetadataManager::indexText(quint32 id, const QString& comment)
+{
+    m_textIndex.setText(id, comment + '\n' + m_paths.fileName(id));
+}
+
+// Evaluate "a, b | c" as (a AND b) OR c
+RoaringBitmap PhotoMetadataManager::queryTags(const QString& query)
+{
+    ensureIndexes();
+
+    RoaringBitmap result;
+    for (const QString& alternative : query.split('|'))
+    {
+        RoaringBitmap matches;
+        bool hasTerm = false;
+
+        for (const QString& part : alternative.split(','))
+        {
+            const QString term = part.trimmed();
+			if (term.isEmpty()) // Ignore dangling separators
+                continue;
+
+			// A term matches every tag it is a prefix of, so partially typed tags still filter
+            RoaringBitmap termMatches;
+            for (const QString& tag : m_tagDictionary.complete(term, m_tagDictionary.size()))
+                termMatches |= m_tagIndex.photosWithTag(tag);
+
+            matches = hasTerm ? (matches & termMatches) : termMatches;
+            hasTerm = true;
+        }
+
+        if (hasTerm)
+            result |= matches;
+    }
+    return result;
 }
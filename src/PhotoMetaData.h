@@ -1,23 +1,47 @@
 #pragma once
 #include <QString>
-#include <QMap>
+#include <QStringList>
+#include <QHash>
+#include <QSet>
+#include <QCache>
 #include <QJsonObject>
+#include <QJsonDocument>
+#include "TagDictionary.h"
+#include "TagIndex.h"
+#include "TrigramIndex.h"
+#include "MetadataStore.h"
+#include "TombstoneSweeper.h"
+#include "PathTable.h"
+#include "EditRecipe.h"
+#include <memory>
+#include <functional>
+#include <future>
+
+class MetadataPersistence;
+class QSettings;
 
 /**
  * @struct PhotoData
  * @brief Represents metadata for a single photo.
  *
  * @details Stores information about a photo including its file path,
- * user-assigned tag, rating, and optional comment. Provides methods
- * for JSON serialization and deserialization.
+ * user-assigned tags, rating, optional comment and its non-destructive
+ * edit. Provides methods for JSON serialization and deserialization.
  *
  * @see PhotoMetadataManager
  */
 struct PhotoData {
     QString filePath;   ///< Absolute path to the photo file.
-    QString tag;        ///< User-defined tag (category or label).
+    QStringList tags;   ///< User-defined tags (categories or labels).
     int rating = 0;     ///< Rating from 0 to 5.
     QString comment;    ///< Optional user comment.
+    quint64 perceptualHash = 0; ///< Cached dHash of the photo thumbnail, valid if hasPerceptualHash is set.
+    bool hasPerceptualHash = false; ///< True once the hash is computed (a flat image hashes to 0).
+    quint64 contentHash = 0;    ///< XXH64 of the file bytes, valid while the file matches contentHashSize and contentHashModified.
+    qint64 contentHashSize = -1; ///< File size the content hash was computed for (-1 = not computed).
+    qint64 contentHashModified = 0; ///< File modification time (msecs since epoch) the content hash was computed for.
+    qint64 missingSince = 0;    ///< Tombstone: msecs since epoch the file was first found missing (0 = present).
+    EditRecipe edit;            ///< Non-destructive edit, identity if the photo is not edited.
 
     /**
      * @brief Serializes the photo data to a QJsonObject.
@@ -31,6 +55,13 @@ struct PhotoData {
      * @return PhotoData instance initialized from JSON.
      */
     static PhotoData fromJson(const QJsonObject& json);
+
+    /**
+     * @brief Splits user input into a tag list.
+     * @param text Comma-separated tags (e.g. "Vacation, Family").
+     * @return Trimmed, non-empty tags without case-insensitive duplicates.
+     */
+    static QStringList parseTags(const QString& text);
 };
 
 /**
@@ -38,9 +69,35 @@ struct PhotoData {
  * @brief Singleton manager for photo metadata.
  *
  * @details Manages a collection of PhotoData for multiple photos.
- * Handles loading and saving metadata from/to a JSON file. 
+ * Metadata is persisted in a MetadataStore: each setter queues only
+ * the record of the edited photo, and MetadataPersistence writes queued
+ * records in coalesced batches on a background thread. The "metadata/backend" setting selects
+ * SqliteMetadataStore ("sqlite", default) or JournalMetadataStore ("journal", opt-in). A JSON catalog written by older
+ * versions is migrated into the store once, and JSON import/export
+ * remains available through loadFromFile() / saveToFile() with a path.
+ *
+ * The store is a ShardedMetadataStore with one shard per imported folder
+ * (see addRoot()). A shard is loaded when one of its photos is first
+ * requested, so folders that are not opened are never parsed. With the
+ * journal backend, loading a shard maps its MetadataSnapshot and keeps
+ * only records changed since then in memory; other entries are decoded
+ * from the snapshot when requested.
  *
- * @see PhotoData
+ * Keeps a TagDictionary of the tags used in loaded shards up to date for
+ * autocompletion and a TagIndex answering tag queries with bitmap operations.
+ * Comments and file names are indexed by a TrigramIndex for full-text search.
+ * These indexes are built on first use.
+ *
+ * Paths are interned in a PathTable: in-memory entries are keyed by the
+ * path handle (which is also the photo id) and do not keep their own
+ * copy of the path.
+ *
+ * Metadata of deleted files is not removed on save. A TombstoneSweeper
+ * checks the catalog in the background, marks missing files with a
+ * tombstone and purges them after TombstoneSweeper::GRACE_PERIOD_MS;
+ * files on unreachable drives are left untouched.
+ *
+ * @see PhotoData, MetadataStore, ShardedMetadataStore, MetadataPersistence, MetadataSnapshot, TombstoneSweeper, PathTable, TagDictionary, TagIndex, TrigramIndex
  */
 class PhotoMetadataManager {
 public:
@@ -51,25 +108,75 @@ public:
     static PhotoMetadataManager& instance();
 
     /**
-     * @brief Loads metadata from a JSON file.
-     * @param filePath Optional path to the JSON file. Uses default path if empty.
+     * @brief Keeps the store and its settings in another folder.
+     * @param folder Folder for the store files and a settings.ini file,
+     *        empty for the application data folder and user settings.
+     *
+     * @details Takes effect only before the first call of instance(),
+     * e.g. in the initTestCase() of tests.
+     */
+    static void setDataDirectory(const QString& folder);
+
+    /**
+     * @brief Discards loaded metadata, shards are reloaded from the store on demand.
+     * @param filePath Optional JSON catalog to import into the store first.
      * @return True if loading succeeds, false otherwise.
      */
     bool loadFromFile(const QString& filePath = {});
 
     /**
-     * @brief Saves current metadata to a JSON file.
-     * @param filePath Optional path to the JSON file. Uses default path if empty.
+     * @brief Waits until all edits are stored, optionally exporting the catalog.
+     * @param filePath Optional path of a JSON file to export to. If empty,
+     *        only waits until all edits are stored (see flush()).
+     * @param format Indented for readability or Compact for smaller files.
      * @return True if saving succeeds, false otherwise.
+     *
+     * @details The export is streamed entry by entry, see JsonStreamWriter.
+     */
+    bool saveToFile(const QString& filePath = {}, QJsonDocument::JsonFormat format = QJsonDocument::Indented);
+
+    /**
+     * @brief Blocks until all edits made so far are written to the store.
+     * @return True if the store accepted all edits.
+     *
+     * @details Call before the application exits; the destructor of the
+     * singleton runs during static destruction and only flushes as a fallback.
+     */
+    bool flush();
+
+    /**
+     * @brief Starts grouping edits into one store transaction.
+     *
+     * @details Calls may be nested, edits are held back until the
+     * outermost commitTransaction() and then written in one batch.
      */
-    bool saveToFile(const QString& filePath = {});
+    void beginTransaction();
+
+    /**
+     * @brief Ends a group started by beginTransaction().
+     */
+    void commitTransaction();
 
     /**
      * @brief Retrieves metadata for a given photo.
      * @param filePath Absolute path to the photo file.
      * @return PhotoData for the specified file. Returns default PhotoData if not found.
+     *
+     * @details Loads the shard holding the photo if it is not loaded yet.
+     */
+    PhotoData getPhotoData(const QString& filePath);
+
+    /**
+     * @brief Retrieves metadata for a photo id without resolving its path.
+     * @param photoId Id returned by photoId().
+     * @return PhotoData with filePath left empty, default PhotoData if not found.
+     *
+     * @details Recently read snapshot records stay decoded in a bounded
+     * cache (least recently read dropped first), so repeated reads (e.g.
+     * table repaints) are a hash lookup while memory does not grow with the
+     * catalog.
      */
-    PhotoData getPhotoData(const QString& filePath) const;
+    PhotoData photoData(quint32 photoId);
 
     /**
      * @brief Sets the rating for a specific photo.
@@ -79,12 +186,21 @@ public:
     void setRating(const QString& filePath, int rating);
 
     /**
-     * @brief Sets the tag for a specific photo.
+     * @brief Sets the tags for a specific photo from user input.
      * @param filePath Absolute path to the photo file.
-     * @param tag User-defined tag string.
+     * @param tag Comma-separated tag string.
+     *
+     * @see PhotoData::parseTags()
      */
     void setTag(const QString& filePath, const QString& tag);
 
+    /**
+     * @brief Sets the tags for a specific photo.
+     * @param filePath Absolute path to the photo file.
+     * @param tags User-defined tags.
+     */
+    void setTags(const QString& filePath, const QStringList& tags);
+
     /**
      * @brief Sets the comment for a specific photo.
      * @param filePath Absolute path to the photo file.
@@ -93,12 +209,108 @@ public:
     void setComment(const QString& filePath, const QString& comment);
 
     /**
-     * @brief Removes metadata entries for files that no longer exist on disk.
+     * @brief Caches the perceptual hash for a specific photo.
+     * @param filePath Absolute path to the photo file.
+     * @param hash dHash computed from the photo thumbnail.
+     *
+     * @see PerceptualHash
+     */
+    void setPerceptualHash(const QString& filePath, quint64 hash);
+
+    /**
+     * @brief Caches the content fingerprint for a specific photo.
+     * @param filePath Absolute path to the photo file.
+     * @param hash XXH64 of the file bytes.
+     * @param size File size the hash was computed for.
+     * @param modified File modification time (msecs since epoch) the hash was computed for.
+     *
+     * @details The hash is ignored once the file size or modification
+     * time changes, see Photo::contentHash().
+     *
+     * @see ContentHash
+     */
+    void setContentHash(const QString& filePath, quint64 hash, qint64 size, qint64 modified);
+
+    /**
+     * @brief Sets the non-destructive edit of a specific photo.
+     * @param filePath Absolute path to the photo file.
+     * @param recipe Edit steps; an identity recipe removes the edit.
+     *
+     * @see ImagePipeline
+     */
+    void setEditRecipe(const QString& filePath, const EditRecipe& recipe);
+
+    /**
+     * @brief Sets the same rating for several photos in one transaction.
+     * @param photoIds Ids returned by photoId().
+     * @param rating Rating value from 0 to 5.
+     *
+     * @details Photos that already have the rating are not rewritten.
+     */
+    void setRatings(const QList<quint32>& photoIds, int rating);
+
+    /**
+     * @brief Adds tags to several photos in one transaction.
+     * @param photoIds Ids returned by photoId().
+     * @param tags Tags to add; tags a photo already has (case-insensitive) are skipped.
+     */
+    void addTags(const QList<quint32>& photoIds, const QStringList& tags);
+
+    /**
+     * @brief Removes tags from several photos in one transaction.
+     * @param photoIds Ids returned by photoId().
+     * @param tags Tags to remove (case-insensitive).
+     */
+    void removeTags(const QList<quint32>& photoIds, const QStringList& tags);
+
+    /**
+     * @brief Returns the dictionary of tags used by all photos.
+     * @return Tag trie with usage counts, updated by setTag() and on load.
+     */
+    const TagDictionary& tagDictionary();
+
+    /**
+     * @brief Returns the numeric id of a photo used by the tag index.
+     * @param filePath Absolute path to the photo file.
+     * @return Id stable for the lifetime of the manager.
+     */
+    quint32 photoId(const QString& filePath);
+
+    /**
+     * @brief Gives an imported folder its own metadata shard.
+     * @param folder Folder chosen for import.
+     * @return True if the folder has its own shard afterwards.
      *
-     * @details Iterates through all metadata entries and removes
-     * those whose filePath does not point to an existing file.
+     * @details Photos of the folder are then loaded and written
+     * independently of all other folders.
      */
-    void cleanupNonExistentFiles();
+    bool addRoot(const QString& folder);
+
+    /**
+     * @brief Returns the path of a photo id.
+     * @param photoId Id returned by photoId().
+     * @return Absolute path to the photo file, empty for 0.
+     */
+    QString filePath(quint32 photoId) const { return m_paths.path(photoId); }
+
+    /**
+     * @brief Evaluates a tag query.
+     * @param query Tag terms separated by ',' (AND) and '|' (OR), e.g.
+     *        "family, beach | vacation". AND binds tighter than OR.
+     *        Each term matches all tags starting with it (case-insensitive).
+     * @return Ids of matching photos (see photoId()).
+     */
+    RoaringBitmap queryTags(const QString& query);
+
+    /**
+     * @brief Searches comments and file names.
+     * @param query Words that must all occur (case-insensitive substrings,
+     *        longer words also match with a few typos).
+     * @return Ids of matching photos (see photoId()).
+     *
+     * @see TrigramIndex::search()
+     */
+    RoaringBitmap searchText(const QString& query);
 
 private:
     PhotoMetadataManager();
@@ -108,10 +320,175 @@ private:
 
     /**
     * @brief Returns the default file path used for storing metadata.
-    * @return QString containing the default JSON file path.
+    * @return QString containing the default metadata database path.
     */
     QString defaultFilePath() const;
 
-    QMap<QString, PhotoData> m_metadata; ///< Map of file paths to photo metadata.
-    QString m_currentFilePath;           ///< Current path to the JSON metadata file.
+    /**
+    * @brief Returns the path of the JSON catalog used by older versions.
+    * @return QString containing the legacy JSON file path.
+    */
+    QString legacyJsonFilePath() const;
+
+    /**
+     * @brief Opens the settings holding the "metadata/..." keys.
+     * @return User settings, or settings.ini of the data directory if one is set.
+     *
+     * @see setDataDirectory()
+     */
+    std::unique_ptr<QSettings> openSettings() const;
+
+    /**
+     * @brief Creates the store selected by the "metadata/backend" setting.
+     * @param filePath Receives the store file path.
+     * @return New, unopened store.
+     */
+    std::unique_ptr<MetadataStore> createStore(QString& filePath) const;
+
+    /**
+     * @brief Streams all entries of a JSON catalog into the store.
+     * @param filePath Path to the JSON file.
+     * @param skippedKeys Photos that are not imported (already in the store).
+     * @return True if the file is missing or was imported.
+     *
+     * @details Parsed with JsonStreamReader and written in batches, so
+     * memory does not grow with the catalog size. Entries before a syntax
+     * error stay imported.
+     */
+    bool importJson(const QString& filePath, const QSet<QString>& skippedKeys = {});
+
+    /**
+     * @brief Replaces the in-memory entry of a photo and its stored record.
+     * @param key Absolute path to the photo file.
+     * @param data New metadata.
+     */
+    void writeEntry(const QString& key, const PhotoData& data);
+
+    /**
+     * @brief Removes the entry of a photo from memory, the indexes and the store.
+     * @param key Absolute path to the photo file.
+     */
+    void removeEntry(const QString& key);
+
+    /**
+     * @brief Returns the paths of all photos with metadata in loaded shards.
+     * @return In-memory entries followed by snapshot entries.
+     */
+    QStringList entryKeys() const;
+
+    /**
+     * @brief Returns the snapshot keys of a shard that are still current.
+     * @param root Root of the shard.
+     * @param snapshot Snapshot of the shard.
+     * @return Keys owned by the shard and not replaced or deleted in memory.
+     */
+    QStringList snapshotKeys(const QString& root, const MetadataSnapshot& snapshot) const;
+
+    /**
+     * @brief Loads the records of a shard unless it is loaded already.
+     * @param root Root of the shard, see ShardedMetadataStore.
+     */
+    void loadShard(const QString& root);
+
+    /**
+     * @brief Returns the snapshot of the shard owning a photo, loading the shard if needed.
+     * @param key Absolute path to the photo file.
+     * @return Snapshot, or nullptr if the shard has none.
+     */
+    const MetadataSnapshot* snapshotOf(const QString& key);
+
+    /**
+     * @brief Searchable fields of a snapshot entry.
+     */
+    struct IndexRecord {
+        QString key;       ///< Absolute path to the photo file.
+        QStringList tags;  ///< Tags of the entry.
+        QString comment;   ///< Comment of the entry.
+    };
+
+    /**
+     * @brief Adds one entry to the tag and text indexes.
+     * @param data Entry with filePath set.
+     */
+    void indexEntry(const PhotoData& data);
+
+    /**
+     * @brief Builds the tag and text indexes if they have not been built yet.
+     *
+     * @details In-memory entries are indexed directly. Snapshot entries are
+     * decoded on a worker thread as soon as their shard is loaded (see
+     * decodeIndexRecords()) and merged here, so a query only waits for a
+     * decode that is still running.
+     */
+    void ensureIndexes();
+
+    /**
+     * @brief Decodes the searchable fields of every snapshot entry (worker thread).
+     * @param snapshot Mapped snapshot, kept alive until the decode is done.
+     * @return One record per snapshot entry.
+     */
+    static QList<IndexRecord> decodeIndexRecords(std::shared_ptr<const MetadataSnapshot> snapshot);
+
+    /**
+     * @brief Adds snapshot entries decoded in the background to the indexes.
+     *
+     * @details Entries that moved to another shard, were replaced or deleted
+     * in memory, or are indexed already are skipped.
+     */
+    void mergeSnapshotIndexes();
+
+    /**
+     * @brief Checks whether a photo has metadata.
+     * @param key Absolute path to the photo file.
+     * @return True if an entry exists in memory or in the snapshot.
+     */
+    bool hasEntry(const QString& key);
+
+    /**
+     * @brief Updates tombstones from a batch checked by the sweeper.
+     * @param keys Checked photo paths.
+     * @param states File state of each path.
+     *
+     * @details Missing files get a tombstone, files that reappeared lose it,
+     * and entries missing for longer than the grace period are removed.
+     */
+    void applySweepResults(const QStringList& keys, const QList<TombstoneSweeper::FileState>& states);
+
+    /**
+     * @brief Re-indexes the searchable text (comment and file name) of a photo.
+     * @param id Photo id.
+     * @param comment Current comment of the photo.
+     */
+    void indexText(quint32 id, const QString& comment);
+
+    /**
+     * @brief Interns an absolute path, indexing new photos if the indexes exist.
+     * @param key Absolute path to the photo file.
+     * @return Path handle, equal to the photo id.
+     */
+    PathTable::Handle handleOf(const QString& key);
+
+    /**
+     * @brief Checks whether a snapshot entry is replaced or deleted in memory.
+     * @param key Absolute path to the photo file.
+     * @return True if the snapshot record must be ignored.
+     */
+    bool isShadowed(const QString& key) const;
+
+    QHash<PathTable::Handle, PhotoData> m_metadata; ///< Entries changed after the snapshot (or all, without one), filePath left empty.
+    QStringList m_roots;                 ///< Shard roots of the store, "" included.
+    QHash<QString, std::shared_ptr<const MetadataSnapshot>> m_shards; ///< Loaded shards -> mapped snapshot (may be null).
+    QSet<PathTable::Handle> m_removed;   ///< Snapshot entries deleted since it was written.
+    QHash<QString, std::shared_future<QList<IndexRecord>>> m_snapshotIndexes; ///< Root -> searchable fields of its snapshot, not merged yet.
+    QSet<PathTable::Handle> m_indexed;   ///< Photos whose tags are in the tag indexes.
+    QCache<PathTable::Handle, PhotoData> m_decoded; ///< Recently read unchanged entries (LRU), filePath left empty.
+    QString m_currentFilePath;           ///< Current path to the metadata store.
+    static QString s_dataDirectory;      ///< Folder set by setDataDirectory(), empty for the defaults.
+    std::unique_ptr<MetadataPersistence> m_persistence; ///< Background writer owning the store.
+    std::unique_ptr<TombstoneSweeper> m_sweeper;        ///< Background missing-file checks.
+    TagDictionary m_tagDictionary;       ///< Prefix trie of used tags with counts.
+    TagIndex m_tagIndex;                 ///< Tag -> photo ids inverted index.
+    TrigramIndex m_textIndex;            ///< Comment and file name full-text index.
+    PathTable m_paths;                   ///< Interned paths, handle = photo id.
+    bool m_indexesBuilt = false;         ///< True once the indexes are built, setters keep them up to date from then on.
 };
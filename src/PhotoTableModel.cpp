@@ -1,16 +1,24 @@
 #include "PhotoTableModel.h"
 #include "PhotoMetadata.h"
+#include "PerceptualHash.h"
+#include "ContentHash.h"
 #include <QApplication>
 #include <QStyle>
 #include <algorithm>
+#include <numeric>
 #include <QProgressDialog>
 #include <QCoreApplication>
 #include <QElapsedTimer>
 #include <QSettings>
+#include <QSet>
+#include <QThread>
+#include <QPointer>
+#include <QFileInfo>
 
 // Constants
 static const QChar STAR_FILLED(0x2605); 
 static const QChar STAR_EMPTY(0x2606);  
+static const int HASH_BATCH_SIZE = 256; // Hashes handed to the GUI thread at once
 
 // Column indices
 static const QStringList COLUMN_HEADERS = {
@@ -25,6 +33,12 @@ PhotoTableModel::PhotoTableModel(QObject* parent)
 {
 }
 
+// Destructor
+PhotoTableModel::~PhotoTableModel()
+{
+	m_hashingCanceled->store(true); // Worker stops after the current file
+}
+
 // --- Row Count with Pagination ---
 int PhotoTableModel::rowCount(const QModelIndex&) const 
 {
@@ -125,7 +139,17 @@ bool PhotoTableModel::setData(const QModelIndex& index, const QVariant& value, i
     Photo& photo = photos[realIndex];
 
     if (index.column() == Export && role == Qt::CheckStateRole) {
-        photo.setMarkedForExport(value.toInt() == Qt::Checked);
+        const bool marked = value.toInt() == Qt::Checked;
+        photo.setMarkedForExport(marked);
+
+		if (m_hasFilters) // Filtered rows are copies, keep the catalog entry in sync
+        {
+            for (Photo& original : m_allPhotos)
+            {
+                if (original.filePath() == photo.filePath())
+                    original.setMarkedForExport(marked);
+            }
+        }
         emit dataChanged(index, index, { Qt::CheckStateRole });
         return true;
     }
@@ -136,8 +160,7 @@ bool PhotoTableModel::setData(const QModelIndex& index, const QVariant& value, i
 	// Update the appropriate field based on the column
     if (updatePhotoField(photo, index.column(), value)) 
     {
-		emit dataChanged(index, index, { Qt::DisplayRole, Qt::EditRole }); // Notify view of data change
-		PhotoMetadataManager::instance().saveToFile(); // Save metadata changes
+		emit dataChanged(index, index, { Qt::DisplayRole, Qt::EditRole }); // Notify view of data change (setter already stored the record)
         return true;
     }
 
@@ -154,19 +177,51 @@ void PhotoTableModel::sort(int column, Qt::SortOrder order)
 
 	bool ascending = (order == Qt::AscendingOrder); // true for ascending, false for descending
 
+	// Paths come from the interned path table and ratings from the metadata manager, fetch each one only once
+    if (column == Name || column == Rating)
+    {
+        QStringList paths;
+        QList<int> ratings;
+        if (column == Name)
+            paths.reserve(photos.size());
+        else
+            ratings.reserve(photos.size());
+
+        for (const Photo& photo : std::as_const(photos))
+        {
+            if (column == Name)
+                paths.append(photo.filePath());
+            else
+                ratings.append(photo.rating());
+        }
+
+        QList<int> indices(photos.size());
+        std::iota(indices.begin(), indices.end(), 0);
+        std::sort(indices.begin(), indices.end(), [&paths, &ratings, column, ascending](int a, int b) {
+            if (column == Name)
+                return ascending ? paths[a] > paths[b] : paths[a] < paths[b];
+            return ascending ? ratings[a] > ratings[b] : ratings[a] < ratings[b];
+        });
+
+        QList<Photo> sorted;
+        sorted.reserve(photos.size());
+        for (int index : std::as_const(indices))
+            sorted.append(photos[index]);
+        photos.swap(sorted);
+
+        emit layoutChanged();
+        return;
+    }
+
     // std::sort goes through all items and sorts them based on the comparison function
     // The lambda compares two photos and returns true if the first should come before the second
     std::sort(photos.begin(), photos.end(), [column, ascending](const Photo& a, const Photo& b) {
         switch (column)
         {
-        case Name:
-            return ascending ? a.filePath() > b.filePath() : a.filePath() < b.filePath();
         case Size:
             return ascending ? a.sizeBytes() > b.sizeBytes() : a.sizeBytes() < b.sizeBytes();
         case DateTime:
             return ascending ? a.dateTime() > b.dateTime() : a.dateTime() < b.dateTime();
-        case Rating:
-            return ascending ? a.rating() > b.rating() : a.rating() < b.rating();
         default:
             return false;
         }
@@ -179,6 +234,7 @@ void PhotoTableModel::addPhoto(const Photo& photo)
 {
 	beginResetModel(); // Notify view of upcoming changes
     m_allPhotos.append(photo);
+    m_similarityIndexDirty = true;
 
 	if (m_hasFilters) // If filters are active, re-apply them
         applyFilters();
@@ -204,6 +260,12 @@ void PhotoTableModel::setTagFilter(const QString& tag) {
     applyFilters();
 }
 
+// --- Set full-text filter ---
+void PhotoTableModel::setTextFilter(const QString& text) {
+    m_filterText = text.trimmed();
+    applyFilters();
+}
+
 // --- Set date range filter ---
 void PhotoTableModel::setDateFilter(const QDate& from, const QDate& to) {
     m_filterDateFrom = from;
@@ -218,7 +280,9 @@ void PhotoTableModel::clearFilters()
     m_filterDateFrom = QDate();
     m_filterDateTo = QDate();
     m_filterTag.clear();
+    m_filterText.clear();
     m_filterMinRating = 0;
+    m_groupFilter.clear();
     m_hasFilters = false;
     applyFilters();
 }
@@ -237,11 +301,28 @@ void PhotoTableModel::applyFilters()
         return;
     }
 
+	// Resolve the tag query once, photos are then checked by id
+    m_tagFilterMatches = m_filterTag.isEmpty()
+        ? RoaringBitmap()
+        : PhotoMetadataManager::instance().queryTags(m_filterTag);
+    m_textFilterMatches = m_filterText.isEmpty()
+        ? RoaringBitmap()
+        : PhotoMetadataManager::instance().searchText(m_filterText);
+
     // Copy photos that pass all filters
     std::copy_if(m_allPhotos.begin(), m_allPhotos.end(),
         std::back_inserter(m_filteredPhotos),
 		[this](const Photo& photo) { return photoPassesFilters(photo); }); // Filter photos
 
+	// Group view keeps members of each group next to each other
+    if (!m_groupFilter.isEmpty())
+    {
+        std::stable_sort(m_filteredPhotos.begin(), m_filteredPhotos.end(),
+            [this](const Photo& a, const Photo& b) {
+                return m_groupFilter.value(a.filePath()) < m_groupFilter.value(b.filePath());
+            });
+    }
+
 	endResetModel(); // Notify view that changes are done
 
 	emit noPhotosAfterFilter(m_filteredPhotos.isEmpty()); // Notify if no photos match filters
@@ -346,7 +427,9 @@ bool PhotoTableModel::hasActiveFilters() const
 	// Check if any filter criteria are set
     return (m_filterDateFrom.isValid() && m_filterDateTo.isValid()) ||
         !m_filterTag.isEmpty() ||
-        (m_filterMinRating > 0);
+        !m_filterText.isEmpty() ||
+        (m_filterMinRating > 0) ||
+        !m_groupFilter.isEmpty();
 }
 
 // --- Check if a photo passes all active filters ---
@@ -360,16 +443,24 @@ bool PhotoTableModel::photoPassesFilters(const Photo& photo) const
             return false;
     }
 
-    // Tag filter (case-insensitive substring match)
+    // Tag filter (query resolved by the inverted tag index in applyFilters)
     if (!m_filterTag.isEmpty()) 
     {
-		if (!photo.tag().contains(m_filterTag, Qt::CaseInsensitive))  // tag does not match
+		if (!m_tagFilterMatches.contains(photo.photoId()))  // tags do not match
             return false;
     }
 
+    // Full-text filter (comment and file name, resolved by the trigram index)
+	if (!m_filterText.isEmpty() && !m_textFilterMatches.contains(photo.photoId())) // text not found
+        return false;
+
     // Rating filter
 	if (m_filterMinRating > 0 && photo.rating() < m_filterMinRating) // rating too low
         return false;
+
+    // Group filter (similar photos / duplicates)
+	if (!m_groupFilter.isEmpty() && !m_groupFilter.contains(photo.filePath())) // not in any shown group
+        return false;
    
 
     return true;
@@ -396,10 +487,8 @@ QVariant PhotoTableModel::getDecoration(const Photo& photo, int column) const
 	// Preview column shows the photo thumbnail
     if (column == Preview) 
     {
-		// Use edited version if available, otherwise use preview
-        QPixmap displayPixmap = photo.hasEditedVersion() 
-            ? photo.editedPixmap()
-            : photo.preview();
+		// Preview shows the edited version if there is one
+        QPixmap displayPixmap = photo.preview();
 
 		// If no preview is available, load from file
         if (displayPixmap.isNull()) 
@@ -484,6 +573,50 @@ bool PhotoTableModel::updatePhotoField(Photo& photo, int column, const QVariant&
     }
 }
 
+// --- Bulk editing ---
+void PhotoTableModel::setRatingForRows(const QList<int>& rows, int rating)
+{
+	PhotoMetadataManager::instance().setRatings(photoIdsForRows(rows), rating); // One transaction for the whole selection
+    emitRowsChanged(rows, Rating);
+}
+
+void PhotoTableModel::addTagForRows(const QList<int>& rows, const QString& tag)
+{
+    PhotoMetadataManager::instance().addTags(photoIdsForRows(rows), PhotoData::parseTags(tag));
+    emitRowsChanged(rows, Tag);
+}
+
+void PhotoTableModel::removeTagForRows(const QList<int>& rows, const QString& tag)
+{
+    PhotoMetadataManager::instance().removeTags(photoIdsForRows(rows), PhotoData::parseTags(tag));
+    emitRowsChanged(rows, Tag);
+}
+
+QList<quint32> PhotoTableModel::photoIdsForRows(const QList<int>& rows) const
+{
+    const QList<Photo>& photos = getActivePhotos();
+
+    QList<quint32> ids;
+    ids.reserve(rows.size());
+    for (int row : rows)
+    {
+        const int realIndex = getRealIndex(row);
+		if (realIndex >= 0 && realIndex < photos.size()) // Skip rows outside the page
+            ids.append(photos[realIndex].photoId());
+    }
+    return ids;
+}
+
+void PhotoTableModel::emitRowsChanged(const QList<int>& rows, int column)
+{
+    if (rows.isEmpty())
+        return;
+
+	// One ranged notification instead of one per row
+    const auto [first, last] = std::minmax_element(rows.cbegin(), rows.cend());
+    emit dataChanged(index(*first, column), index(*last, column), { Qt::DisplayRole, Qt::EditRole });
+}
+
 // --- Lazy Loading Interface ---
 void PhotoTableModel::initializeWithPaths(const QStringList& allPaths) 
 {
@@ -501,19 +634,27 @@ void PhotoTableModel::initializeWithPaths(const QStringList& allPaths)
     progress.show();
 
 	m_allPhotos.reserve(oldSize + allPaths.size());  // Pre-allocate memory for efficiency
+    QStringList unhashed;
 
     for (int i = 0; i < allPaths.size(); ++i) 
     {
 	    if (progress.wasCanceled()) // User canceled loading
             break;
 
-        m_allPhotos.append(Photo(allPaths[i]));  // Append new Photo with only the file path (no heavy data yet)
+        Photo photo(allPaths[i]); // New Photo with only the file path (no heavy data yet)
+
+        // Perceptual hash is cached in metadata, decode a thumbnail only the first time
+        if (!photo.hasPerceptualHash())
+            unhashed.append(photo.filePath());
+
+        m_allPhotos.append(photo);
       
         // Update progress
         progress.setValue(i + 1);
         QCoreApplication::processEvents(); // refresh GUI
     }
 
+    m_similarityIndexDirty = true;
     endResetModel();
 
     if (hasActiveFilters()) {
@@ -521,7 +662,9 @@ void PhotoTableModel::initializeWithPaths(const QStringList& allPaths)
     }
 
     progress.close();
-   
+
+	updateDuplicateGroups(); // Groups from fingerprints cached in earlier sessions
+	hashInBackground(unhashed, duplicateCandidates()); // Table is usable while files are read
 }
 
 // --- Get pointer to Photo at given row ---
@@ -551,6 +694,337 @@ QList<Photo*> PhotoTableModel::getPhotosMarkedForExport()
     return marked;
 }
 
+// --- Similar photos ---
+
+// --- Rebuild BK-tree over perceptual hashes of all photos ---
+void PhotoTableModel::ensureSimilarityIndex()
+{
+    if (!m_similarityIndexDirty)
+        return;
+
+    m_similarityIndex.clear();
+    m_indexedPaths.clear();
+    m_indexedHashes.clear();
+
+    for (const Photo& photo : m_allPhotos)
+    {
+		if (!photo.hasPerceptualHash()) // Not hashed yet or not decodable, nothing to compare
+            continue;
+
+        m_similarityIndex.insert(photo.perceptualHash(), m_indexedPaths.size());
+        m_indexedPaths.append(photo.filePath());
+        m_indexedHashes.append(photo.perceptualHash());
+    }
+
+    m_similarityIndexDirty = false;
+}
+
+// --- Decode thumbnails and read files without blocking the GUI ---
+void PhotoTableModel::hashInBackground(const QStringList& perceptualPaths, const QStringList& contentPaths)
+{
+    if (perceptualPaths.isEmpty() && contentPaths.isEmpty())
+        return;
+
+    ++m_hashingJobs;
+
+	// Results go through a relay on this thread, which outlives the model if it is deleted first
+    QObject* relay = new QObject();
+    QPointer<PhotoTableModel> model(this);
+    const std::shared_ptr<std::atomic<bool>> canceled = m_hashingCanceled;
+
+    QThread* thread = QThread::create([perceptualPaths, contentPaths, relay, model, canceled]() {
+        const int total = perceptualPaths.size() + contentPaths.size();
+        int done = 0;
+
+        QStringList hashedPaths;
+        QList<quint64> hashes;
+        QList<qint64> sizes;
+        QList<qint64> modified;
+
+        auto deliverPerceptual = [&]() {
+            QMetaObject::invokeMethod(relay, [model, hashedPaths, hashes, done, total]() {
+                if (!model)
+                    return;
+                model->storePerceptualHashes(hashedPaths, hashes);
+                emit model->hashingProgress(done, total);
+                }, Qt::QueuedConnection);
+            hashedPaths.clear();
+            hashes.clear();
+        };
+
+        auto deliverContent = [&]() {
+            QMetaObject::invokeMethod(relay, [model, hashedPaths, hashes, sizes, modified, done, total]() {
+                if (!model)
+                    return;
+                model->storeContentHashes(hashedPaths, hashes, sizes, modified);
+                emit model->hashingProgress(done, total);
+                }, Qt::QueuedConnection);
+            hashedPaths.clear();
+            hashes.clear();
+            sizes.clear();
+            modified.clear();
+        };
+
+        for (const QString& path : perceptualPaths)
+        {
+            if (canceled->load())
+                break;
+
+            ++done;
+            bool ok = false;
+            const quint64 hash = PerceptualHash::fromFile(path, &ok);
+			if (!ok) // Not decodable, tried again on the next import
+                continue;
+
+            hashedPaths.append(path);
+            hashes.append(hash);
+            if (hashes.size() == HASH_BATCH_SIZE)
+                deliverPerceptual();
+        }
+        deliverPerceptual();
+
+        for (const QString& path : contentPaths)
+        {
+            if (canceled->load())
+                break;
+
+            ++done;
+			const QFileInfo info(path); // File state the hash belongs to, read before the bytes
+            const quint64 hash = ContentHash::fromFile(path);
+			if (hash == 0) // Unreadable file
+                continue;
+
+            hashedPaths.append(path);
+            hashes.append(hash);
+            sizes.append(info.size());
+            modified.append(info.lastModified().toMSecsSinceEpoch());
+            if (hashes.size() == HASH_BATCH_SIZE)
+                deliverContent();
+        }
+        deliverContent();
+
+        QMetaObject::invokeMethod(relay, [model]() {
+            if (model && --model->m_hashingJobs == 0)
+                emit model->hashesReady();
+            }, Qt::QueuedConnection);
+    });
+
+	// Posted after the results, so the relay handles them first
+    connect(thread, &QThread::finished, relay, &QObject::deleteLater);
+    connect(thread, &QThread::finished, thread, &QObject::deleteLater);
+    thread->start();
+}
+
+// --- Cache hashes computed by the worker ---
+void PhotoTableModel::storePerceptualHashes(const QStringList& paths, const QList<quint64>& hashes)
+{
+    if (paths.isEmpty())
+        return;
+
+    PhotoMetadataManager& manager = PhotoMetadataManager::instance();
+	manager.beginTransaction(); // One store transaction per batch
+    for (int i = 0; i < paths.size(); ++i)
+        manager.setPerceptualHash(paths[i], hashes[i]);
+    manager.commitTransaction();
+
+    m_similarityIndexDirty = true;
+}
+
+// --- Cache fingerprints computed by the worker ---
+void PhotoTableModel::storeContentHashes(const QStringList& paths, const QList<quint64>& hashes,
+    const QList<qint64>& sizes, const QList<qint64>& modified)
+{
+    if (paths.isEmpty())
+        return;
+
+    PhotoMetadataManager& manager = PhotoMetadataManager::instance();
+	manager.beginTransaction(); // One store transaction per batch
+    for (int i = 0; i < paths.size(); ++i)
+        manager.setContentHash(paths[i], hashes[i], sizes[i], modified[i]);
+    manager.commitTransaction();
+
+    updateDuplicateGroups();
+}
+
+// --- Find photos similar to the photo at given row ---
+QStringList PhotoTableModel::similarPhotos(int row, int maxDistance)
+{
+    const Photo* photo = getPhotoPointer(row);
+    if (!photo)
+        return {};
+
+    if (!photo->hasPerceptualHash()) // Only the photo itself
+        return { photo->filePath() };
+
+    ensureSimilarityIndex();
+
+    QStringList similar;
+    for (int value : m_similarityIndex.find(photo->perceptualHash(), maxDistance))
+        similar.append(m_indexedPaths[value]);
+
+    return similar;
+}
+
+// --- Cluster all photos into near-duplicate groups ---
+QList<QStringList> PhotoTableModel::nearDuplicateGroups(int maxDistance)
+{
+    ensureSimilarityIndex();
+
+    // Union-find over BK-tree matches
+    QList<int> parent(m_indexedPaths.size());
+    std::iota(parent.begin(), parent.end(), 0);
+
+    auto findRoot = [&parent](int i) {
+        while (parent[i] != i)
+        {
+			parent[i] = parent[parent[i]]; // path halving
+            i = parent[i];
+        }
+        return i;
+    };
+
+    for (int i = 0; i < m_indexedHashes.size(); ++i)
+    {
+        for (int j : m_similarityIndex.find(m_indexedHashes[i], maxDistance))
+            parent[findRoot(j)] = findRoot(i);
+    }
+
+    // Collect members of each root
+    QHash<int, QStringList> byRoot;
+    for (int i = 0; i < m_indexedPaths.size(); ++i)
+        byRoot[findRoot(i)].append(m_indexedPaths[i]);
+
+    QList<QStringList> groups;
+    for (const QStringList& group : std::as_const(byRoot))
+    {
+		if (group.size() > 1) // Single photos are not duplicates
+            groups.append(group);
+    }
+
+    std::sort(groups.begin(), groups.end(), [](const QStringList& a, const QStringList& b) {
+        return a.size() > b.size();
+    });
+
+    return groups;
+}
+
+// --- Show only photos from the given groups ---
+void PhotoTableModel::showPhotoGroups(const QList<QStringList>& groups)
+{
+    m_groupFilter.clear();
+    for (int g = 0; g < groups.size(); ++g)
+    {
+        for (const QString& path : groups[g])
+            m_groupFilter.insert(path, g);
+    }
+
+	m_currentPage = 0; // Start from first group
+    applyFilters();
+}
+
+// --- Exact duplicates ---
+
+// --- Photos sharing their size with another photo, without a valid fingerprint ---
+QStringList PhotoTableModel::duplicateCandidates() const
+{
+    // Files with a unique size cannot have a duplicate
+    QHash<qint64, QList<int>> bySize;
+    for (int i = 0; i < m_allPhotos.size(); ++i)
+        bySize[m_allPhotos[i].sizeBytes()].append(i);
+
+    QStringList paths;
+    QSet<QString> seen;
+    for (auto it = bySize.cbegin(); it != bySize.cend(); ++it)
+    {
+		if (it.value().size() < 2) // Unique size, never hashed
+            continue;
+
+        for (int i : it.value())
+        {
+            const Photo& photo = m_allPhotos[i];
+			if (photo.contentHash() != 0) // Cached and the file did not change since
+                continue;
+
+			if (!seen.contains(photo.filePath())) // Same file imported twice is read once
+            {
+                seen.insert(photo.filePath());
+                paths.append(photo.filePath());
+            }
+        }
+    }
+    return paths;
+}
+
+// --- Group byte-identical files (size first, content hash second) ---
+void PhotoTableModel::updateDuplicateGroups()
+{
+    QHash<QPair<qint64, quint64>, QStringList> byContent;
+    for (const Photo& photo : std::as_const(m_allPhotos))
+    {
+        const quint64 hash = photo.contentHash();
+		if (hash == 0) // Unique size, not hashed yet or unreadable
+            continue;
+
+        QStringList& group = byContent[{ photo.sizeBytes(), hash }];
+		if (!group.contains(photo.filePath())) // Same file imported twice is not a duplicate
+            group.append(photo.filePath());
+    }
+
+    m_duplicateGroups.clear();
+    for (const QStringList& group : std::as_const(byContent))
+    {
+        if (group.size() > 1)
+            m_duplicateGroups.append(group);
+    }
+}
+
+// --- Keep one copy per duplicate group ---
+int PhotoTableModel::ignoreDuplicateCopies()
+{
+    if (m_duplicateGroups.isEmpty())
+        return 0;
+
+    // Copies the user chose to export are preferred
+    QSet<QString> marked;
+    for (const Photo& photo : std::as_const(m_allPhotos))
+    {
+        if (photo.isMarkedForExport())
+            marked.insert(photo.filePath());
+    }
+
+    QSet<QString> ignored;
+    for (const QStringList& group : std::as_const(m_duplicateGroups))
+    {
+        QString keep = group.first();
+        for (const QString& path : group)
+        {
+            if (marked.contains(path))
+            {
+                keep = path;
+                break;
+            }
+        }
+
+        for (const QString& path : group)
+        {
+            if (path != keep)
+                ignored.insert(path);
+        }
+    }
+
+    auto isIgnored = [&ignored](const Photo& photo) { return ignored.contains(photo.filePath()); };
+
+    beginResetModel();
+    const int removed = int(m_allPhotos.removeIf(isIgnored));
+    m_filteredPhotos.removeIf(isIgnored);
+    m_duplicateGroups.clear();
+    m_similarityIndexDirty = true;
+	m_currentPage = 0; // Page count may have shrunk
+    endResetModel();
+
+    return removed;
+}
+
 // --- Load saved settings ---
 void PhotoTableModel::loadSettings()
 {
@@ -590,6 +1064,12 @@ void PhotoTableModel::loadSettings()
         setTagFilter(savedTag);
     }
 
+	// Load full-text filter
+    QString savedText = settings.value("filters/text", "").toString();
+    if (!savedText.isEmpty()) {
+        setTextFilter(savedText);
+    }
+
 	// Load minimum rating filter
     int savedMinRating = settings.value("filters/minRating", 0).toInt();
     if (savedMinRating > 0) {
@@ -615,5 +1095,6 @@ void PhotoTableModel::saveSettings()
     settings.setValue("filters/dateFrom", m_filterDateFrom);
     settings.setValue("filters/dateTo", m_filterDateTo);
     settings.setValue("filters/tag", m_filterTag);
+    settings.setValue("filters/text", m_filterText);
     settings.setValue("filters/minRating", m_filterMinRating);
 }
\ No newline at end of file
@@ -1,6 +1,11 @@
 #pragma once
 #include <QAbstractTableModel>
+#include <QHash>
+#include <atomic>
+#include <memory>
 #include "Photo.h"
+#include "BKTree.h"
+#include "RoaringBitmap.h"
 
 /**
  * @brief Table model for displaying photos with pagination, filtering, and sorting
@@ -8,10 +13,13 @@
  * @details
  * This model manages photo display in a table view with support for:
  * - Pagination (default 10 items per page)
- * - Filtering by date range, tag, and minimum rating
+ * - Filtering by date range, tag query, full-text search, and minimum rating
  * - Column sorting
  * - Inline editing of tag, rating, and comment fields
- * - Automatic persistence to JSON storage
+ * - Bulk rating and tagging of selected rows in one transaction
+ * - Automatic per-record persistence to the metadata store
+ * - Near-duplicate search over perceptual hashes (BK-tree index)
+ * - Exact duplicate grouping by file size and content fingerprint
  */
 class PhotoTableModel : public QAbstractTableModel {
     Q_OBJECT
@@ -23,6 +31,18 @@ signals:
      */
     void noPhotosAfterFilter(bool empty);
 
+    /**
+     * Emitted after each batch of hashes computed in the background.
+     * @param done Number of files processed so far
+     * @param total Number of files the worker was given
+     */
+    void hashingProgress(int done, int total);
+
+    /**
+     * Emitted when background hashing of imported photos is done.
+     */
+    void hashesReady();
+
 public:
   
     /**
@@ -47,6 +67,11 @@ public:
      */
     explicit PhotoTableModel(QObject* parent = nullptr);
 
+    /**
+     * @brief Stops background hashing, hashes computed so far are kept.
+     */
+    ~PhotoTableModel() override;
+
     // --- QAbstractTableModel interface ---
     int rowCount(const QModelIndex& parent = QModelIndex()) const override;
     int columnCount(const QModelIndex& parent = QModelIndex()) const override;
@@ -78,11 +103,22 @@ public:
     void setDateFilter(const QDate& from, const QDate& to);
 
     /**
-     * @brief Filter photos by tag (case-insensitive substring match)
-     * @param tag Tag to filter by
+     * @brief Filter photos by a tag query
+     * @param tag Tags separated by ',' (all required) or '|' (any),
+     *        each matching tags that start with it (case-insensitive)
+     *
+     * @see PhotoMetadataManager::queryTags()
      */
     void setTagFilter(const QString& tag);
 
+    /**
+     * @brief Filter photos by text in their comment or file name
+     * @param text Words that must all occur (substring, typo-tolerant for longer words)
+     *
+     * @see PhotoMetadataManager::searchText()
+     */
+    void setTextFilter(const QString& text);
+
     /**
      * @brief Filter photos by minimum rating
      * @param minRating Minimum rating (0-5)
@@ -144,6 +180,9 @@ public:
     /**
     * @brief Initialize the model with a list of photo paths.
     * @param allPaths List of absolute file paths.
+    *
+    * @details Perceptual hashes and content fingerprints missing from
+    * metadata are computed on a worker thread afterwards, see hashesReady().
     */
     void initializeWithPaths(const QStringList& allPaths);
 
@@ -161,6 +200,84 @@ public:
     */
     QList<Photo*> getPhotosMarkedForExport();
 
+    // --- Bulk editing ---
+    /**
+     * @brief Sets the rating of several rows at once.
+     * @param rows Row indices relative to the current page.
+     * @param rating Rating value from 0 to 5.
+     *
+     * @details All records are written in one metadata transaction and the
+     * view gets a single dataChanged for the covered range.
+     */
+    void setRatingForRows(const QList<int>& rows, int rating);
+
+    /**
+     * @brief Adds tags to several rows at once.
+     * @param rows Row indices relative to the current page.
+     * @param tag Comma-separated tags to add.
+     *
+     * @see setRatingForRows()
+     */
+    void addTagForRows(const QList<int>& rows, const QString& tag);
+
+    /**
+     * @brief Removes tags from several rows at once.
+     * @param rows Row indices relative to the current page.
+     * @param tag Comma-separated tags to remove.
+     *
+     * @see setRatingForRows()
+     */
+    void removeTagForRows(const QList<int>& rows, const QString& tag);
+
+
+    // --- Similar photos ---
+    /**
+     * @brief Checks whether imported photos are still being hashed.
+     * @return True until hashesReady() is emitted.
+     */
+    bool isHashingPhotos() const { return m_hashingJobs > 0; }
+
+    /**
+     * @brief Finds photos visually similar to the photo at a row.
+     * @param row Row index relative to current page.
+     * @param maxDistance Maximum Hamming distance between perceptual hashes.
+     * @return Paths of similar photos, including the photo itself.
+     */
+    QStringList similarPhotos(int row, int maxDistance = 10);
+
+    /**
+     * @brief Groups all loaded photos into near-duplicate clusters.
+     * @param maxDistance Maximum Hamming distance between perceptual hashes.
+     * @return Groups with at least two photos, largest group first.
+     *
+     * @details Each photo queries the BK-tree once and matches are merged
+     * with union-find, so no pairwise comparison of the catalog is needed.
+     */
+    QList<QStringList> nearDuplicateGroups(int maxDistance = 10);
+
+    /**
+     * @brief Shows only photos from the given groups, ordered group by group.
+     * @param groups Lists of photo paths; cleared by clearFilters().
+     */
+    void showPhotoGroups(const QList<QStringList>& groups);
+
+    // --- Exact duplicates ---
+    /**
+     * @brief Returns groups of byte-identical photo files.
+     * @return Groups with at least two distinct paths.
+     *
+     * @details Complete once isHashingPhotos() returns false.
+     */
+    const QList<QStringList>& exactDuplicateGroups() const { return m_duplicateGroups; }
+
+    /**
+     * @brief Removes all but one copy of every duplicate group from the catalog.
+     * @return Number of ignored copies.
+     *
+     * @details The copy marked for export is kept, otherwise the first one.
+     * Files on disk are not touched.
+     */
+    int ignoreDuplicateCopies();
 
     /**
      * @brief Load saved settings (page size, sorting, filters)
@@ -253,6 +370,64 @@ private:
      */
     bool updatePhotoField(Photo& photo, int column, const QVariant& value);
 
+    /**
+     * @brief Maps page rows to photo ids.
+     * @param rows Row indices relative to the current page.
+     * @return Ids of the photos on valid rows.
+     */
+    QList<quint32> photoIdsForRows(const QList<int>& rows) const;
+
+    /**
+     * @brief Notifies the view once for a column of edited rows.
+     * @param rows Edited rows, in any order.
+     * @param column Edited column.
+     */
+    void emitRowsChanged(const QList<int>& rows, int column);
+
+    /**
+     * @brief Rebuilds the perceptual hash index if photos were added.
+     */
+    void ensureSimilarityIndex();
+
+    /**
+     * @brief Computes perceptual hashes and content fingerprints on a worker thread.
+     * @param perceptualPaths Photos without a cached perceptual hash.
+     * @param contentPaths Photos without a valid content fingerprint, see duplicateCandidates().
+     */
+    void hashInBackground(const QStringList& perceptualPaths, const QStringList& contentPaths);
+
+    /**
+     * @brief Caches a batch of hashes delivered by the worker.
+     * @param paths Hashed photos.
+     * @param hashes dHash of each photo, parallel to @p paths.
+     */
+    void storePerceptualHashes(const QStringList& paths, const QList<quint64>& hashes);
+
+    /**
+     * @brief Caches a batch of content fingerprints delivered by the worker.
+     * @param paths Fingerprinted photos.
+     * @param hashes XXH64 of each file, parallel to @p paths.
+     * @param sizes File size each hash was computed for.
+     * @param modified File modification time (msecs since epoch) each hash was computed for.
+     */
+    void storeContentHashes(const QStringList& paths, const QList<quint64>& hashes,
+        const QList<qint64>& sizes, const QList<qint64>& modified);
+
+    /**
+     * @brief Lists photos that must be fingerprinted to find exact duplicates.
+     * @return Paths of photos sharing their size with another photo and
+     * lacking a fingerprint valid for the current file state.
+     */
+    QStringList duplicateCandidates() const;
+
+    /**
+     * @brief Regroups byte-identical photos from cached fingerprints.
+     *
+     * @details Does not read any file, missing fingerprints are computed
+     * by hashInBackground().
+     */
+    void updateDuplicateGroups();
+
     // --- Storage ---
     QList<Photo> m_allPhotos;      ///< Full original photo list
     QList<Photo> m_filteredPhotos; ///< Filtered photos (if filters active)
@@ -265,8 +440,23 @@ private:
     // --- Filter conditions ---
     QDate m_filterDateFrom;    ///< Filter: start date
     QDate m_filterDateTo;      ///< Filter: end date
-    QString m_filterTag;       ///< Filter: tag substring
+    QString m_filterTag;       ///< Filter: tag query
+    RoaringBitmap m_tagFilterMatches; ///< Photo ids matching m_filterTag
+    QString m_filterText;      ///< Filter: full-text query
+    RoaringBitmap m_textFilterMatches; ///< Photo ids matching m_filterText
     int m_filterMinRating;     ///< Filter: minimum rating
+    QHash<QString, int> m_groupFilter; ///< Filter: photo path -> group index (empty = off)
+
+    // --- Similarity index ---
+    BKTree m_similarityIndex;          ///< BK-tree over perceptual hashes
+    QStringList m_indexedPaths;        ///< Photo paths, indexed by BK-tree values
+    QList<quint64> m_indexedHashes;    ///< Perceptual hashes parallel to m_indexedPaths
+    bool m_similarityIndexDirty = true; ///< True if the index must be rebuilt
+    int m_hashingJobs = 0;             ///< Running background hashing threads
+    std::shared_ptr<std::atomic<bool>> m_hashingCanceled = std::make_shared<std::atomic<bool>>(false); ///< Set when the model is destroyed
+
+    // --- Exact duplicates ---
+    QList<QStringList> m_duplicateGroups; ///< Paths of byte-identical photos, one list per group
 
 	// --- Sorting ---
     int m_sortColumn = DateTime;              ///< Current sort column
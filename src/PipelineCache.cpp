@@ -0,0 +1,66 @@
+#include "PipelineCache.h"
+#include "ImagePipeline.h"
+#include <algorithm>
+
+QImage PipelineCache::render(const QImage& source, const EditRecipe& recipe, const QImage& watermark,
+    const TileRenderer::ProgressFunction& progress)
+{
+    if (source.isNull())
+        return QImage();
+
+    m_firstRecomputed = Watermark;
+
+	// Stage 1: a new source image or new adjustments invalidate everything
+    if (m_adjusted.isNull() || source.cacheKey() != m_source.cacheKey() || recipe.adjustments != m_adjustments)
+    {
+        m_firstRecomputed = Adjustments;
+        m_transformed = QImage();
+        m_adjusted = ImagePipeline::adjust(source, recipe.adjustments, progress);
+		if (m_adjusted.isNull()) // Canceled, recompute next time
+            return QImage();
+
+        m_source = source;
+        m_adjustments = recipe.adjustments;
+    }
+
+	// Stage 2: rotation and crop only copy pixels
+    const QRectF crop = recipe.hasCrop() ? recipe.crop : QRectF();
+    if (m_transformed.isNull() || recipe.rotation != m_rotation || crop != m_crop)
+    {
+        m_firstRecomputed = std::min(m_firstRecomputed, Geometry);
+        m_transformed = ImagePipeline::transform(m_adjusted, recipe.rotation, crop, progress);
+        if (m_transformed.isNull())
+            return QImage();
+
+        m_rotation = recipe.rotation;
+        m_crop = crop;
+    }
+
+	// Stage 3: blend over a copy, the cached stage stays clean
+    if (recipe.watermarkPath.isEmpty())
+        return m_transformed;
+
+    const QImage wm = scaledWatermark(recipe.watermarkPath, watermark, m_transformed.width());
+    return ImagePipeline::applyWatermark(m_transformed, wm, recipe.watermarkPosition, recipe.watermarkOpacity);
+}
+
+void PipelineCache::clear()
+{
+    *this = PipelineCache();
+}
+
+QImage PipelineCache::scaledWatermark(const QString& path, const QImage& watermark, int imageWidth)
+{
+    const bool sameImage = watermark.isNull() ? m_watermark.isNull() && path == m_watermarkPath
+        : watermark.cacheKey() == m_watermark.cacheKey();
+
+    if (!sameImage || imageWidth != m_watermarkWidth)
+    {
+		// Loading from the path happens once per watermark, not once per render
+        m_scaledWatermark = ImagePipeline::scaledWatermark(watermark.isNull() ? QImage(path) : watermark, imageWidth);
+        m_watermark = watermark;
+        m_watermarkPath = path;
+        m_watermarkWidth = imageWidth;
+    }
+    return m_scaledWatermark;
+}
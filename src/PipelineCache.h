@@ -0,0 +1,83 @@
+#pragma once
+#include <QImage>
+#include <QRectF>
+#include <QString>
+#include "EditRecipe.h"
+#include "TileRenderer.h"
+
+/**
+ * @class PipelineCache
+ * @brief Renders recipes repeatedly, re-running only the stages that changed.
+ *
+ * @details
+ * The editor renders the same preview over and over with one value
+ * changed. The cache keeps the result of every stage, keyed by the
+ * parameters upstream of it:
+ *  1. colour adjustments - source image and adjustments,
+ *  2. rotation and crop   - the above plus rotation and crop,
+ *  3. watermark           - not cached, blended over a copy of stage 2.
+ *
+ * The adjustments run first because they are the expensive stage and, as
+ * point operations, commute with rotation and crop: turning or cropping
+ * only copies pixels, and a watermark change only blends the watermark
+ * area again. The scaled watermark is cached as well.
+ *
+ * Not thread-safe; the PreviewRenderer worker owns one instance.
+ */
+class PipelineCache {
+public:
+    /**
+     * @brief Pipeline stages in the order they run.
+     */
+    enum Stage {
+        Adjustments,  ///< Colour adjustments and filter preset.
+        Geometry,     ///< Rotation and crop.
+        Watermark     ///< Watermark blend, always run.
+    };
+
+    /**
+     * @brief Renders a recipe, reusing cached stages.
+     * @param source Image the recipe is applied to; identified by QImage::cacheKey().
+     * @param recipe Edit steps.
+     * @param watermark Watermark image; loaded from the recipe path if null.
+     * @param progress Optional progress callback, see TileRenderer::run().
+     * @return Same pixels as ImagePipeline::render(), null if canceled.
+     */
+    QImage render(const QImage& source, const EditRecipe& recipe, const QImage& watermark = QImage(),
+        const TileRenderer::ProgressFunction& progress = TileRenderer::ProgressFunction());
+
+    /**
+     * @brief Drops all cached stages.
+     */
+    void clear();
+
+    /**
+     * @brief Returns the first stage the last render() had to run.
+     * @return Watermark if both cached stages were reused.
+     */
+    Stage firstRecomputedStage() const { return m_firstRecomputed; }
+
+private:
+    /**
+     * @brief Returns the watermark scaled for an image width, cached.
+     */
+    QImage scaledWatermark(const QString& path, const QImage& watermark, int imageWidth);
+
+    // Stage 1, keyed by source and adjustments
+    QImage m_source;
+    ColorAdjustments m_adjustments;
+    QImage m_adjusted;
+
+    // Stage 2, keyed by stage 1 plus rotation and crop
+    int m_rotation = 0;
+    QRectF m_crop;
+    QImage m_transformed;
+
+    // Scaled watermark, keyed by image, path and width
+    QImage m_watermark;
+    QString m_watermarkPath;
+    QImage m_scaledWatermark;
+    int m_watermarkWidth = 0;
+
+    Stage m_firstRecomputed = Adjustments;
+};
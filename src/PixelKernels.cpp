@@ -0,0 +1,608 @@
+#include "PixelKernels.h"
+#include <algorithm>
+#include <array>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define PIXELKERNELS_X86
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+// GCC and Clang compile wider instructions only inside functions marked for them,
+// MSVC accepts all intrinsics anywhere
+#if defined(PIXELKERNELS_X86) && (defined(__GNUC__) || defined(__clang__))
+#define TARGET_SSE2 __attribute__((target("sse2")))
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#define TARGET_AVX512 __attribute__((target("avx512f,avx512bw")))
+#else
+#define TARGET_SSE2
+#define TARGET_AVX2
+#define TARGET_AVX512
+#endif
+
+using PixelKernels::ChannelLut;
+using PixelKernels::MATRIX_SHIFT;
+using PixelKernels::SATURATION_SHIFT;
+
+// Saturation cap uses reciprocals 65536 / d instead of a division per pixel
+static const int RECIPROCAL_SHIFT = 16;
+static const int CAP_SHIFT = RECIPROCAL_SHIFT - SATURATION_SHIFT;
+
+static const std::array<int, 256> RECIPROCALS = [] {
+    std::array<int, 256> table{}; // Entry 0 stays 0, gray pixels get no scale
+    for (int d = 1; d < 256; ++d)
+        table[d] = ((1 << RECIPROCAL_SHIFT) + d / 2) / d;
+    return table;
+}();
+
+// Rounded x / 255 for 0 <= x <= 65025, the same expression in every version
+static inline int div255(int x)
+{
+    x += 128;
+    return (x + (x >> 8)) >> 8;
+}
+
+
+// -------------------------
+//   Scalar
+// -------------------------
+
+static void lutScalar(QRgb* pixels, int count, const ChannelLut luts[3])
+{
+    for (int i = 0; i < count; ++i)
+    {
+        const QRgb p = pixels[i];
+        pixels[i] = qRgba(luts[0][qRed(p)], luts[1][qGreen(p)], luts[2][qBlue(p)], qAlpha(p));
+    }
+}
+
+static void matrixScalar(QRgb* pixels, int count, const int m[9])
+{
+    for (int i = 0; i < count; ++i)
+    {
+        const QRgb p = pixels[i];
+        const int r = qRed(p), g = qGreen(p), b = qBlue(p);
+        const int nr = std::clamp((m[0] * r + m[1] * g + m[2] * b) >> MATRIX_SHIFT, 0, 255);
+        const int ng = std::clamp((m[3] * r + m[4] * g + m[5] * b) >> MATRIX_SHIFT, 0, 255);
+        const int nb = std::clamp((m[6] * r + m[7] * g + m[8] * b) >> MATRIX_SHIFT, 0, 255);
+        pixels[i] = qRgba(nr, ng, nb, qAlpha(p));
+    }
+}
+
+static void blendScalar(QRgb* dst, const QRgb* src, int count, int opacity)
+{
+    for (int i = 0; i < count; ++i)
+    {
+        const QRgb s = src[i];
+        const QRgb d = dst[i];
+        const int a = div255(qAlpha(s) * opacity);
+        dst[i] = qRgba(div255(qRed(s) * a + qRed(d) * (255 - a)),
+            div255(qGreen(s) * a + qGreen(d) * (255 - a)),
+            div255(qBlue(s) * a + qBlue(d) * (255 - a)),
+            qAlpha(d));
+    }
+}
+
+// L + (c - L) * scale with L = sum / 2, in units of half a channel step
+static inline int saturateChannel(int c, int sum, int scale)
+{
+    const int value = sum * (1 << SATURATION_SHIFT) + (2 * c - sum) * scale;
+    return std::clamp((value + (1 << SATURATION_SHIFT)) >> (SATURATION_SHIFT + 1), 0, 255);
+}
+
+static void saturationScalar(QRgb* pixels, int count, int factor)
+{
+    for (int i = 0; i < count; ++i)
+    {
+        const QRgb p = pixels[i];
+        const int r = qRed(p), g = qGreen(p), b = qBlue(p);
+        const int maxChannel = std::max({ r, g, b });
+        const int minChannel = std::min({ r, g, b });
+        const int sum = maxChannel + minChannel;
+
+		// Largest scale that keeps HSL saturation at most 1
+        const int cap = (std::min(sum, 510 - sum) * RECIPROCALS[maxChannel - minChannel] + (1 << (CAP_SHIFT - 1))) >> CAP_SHIFT;
+        const int scale = std::min(factor, cap);
+
+        pixels[i] = qRgba(saturateChannel(r, sum, scale), saturateChannel(g, sum, scale), saturateChannel(b, sum, scale), qAlpha(p));
+    }
+}
+
+
+#ifdef PIXELKERNELS_X86
+
+// -------------------------
+//   SSE2 (4 pixels)
+// -------------------------
+
+// Rounded x / 255 on unsigned 16-bit lanes, x <= 65025
+TARGET_SSE2 static inline __m128i div255Sse2(__m128i x)
+{
+    x = _mm_add_epi16(x, _mm_set1_epi16(128));
+    return _mm_srli_epi16(_mm_add_epi16(x, _mm_srli_epi16(x, 8)), 8);
+}
+
+// One output channel: lanes hold r | g << 16 and b, coefficients are packed the same way
+TARGET_SSE2 static inline __m128i mixSse2(__m128i rg, __m128i b, __m128i rgCoef, __m128i bCoef)
+{
+    __m128i sum = _mm_add_epi32(_mm_madd_epi16(rg, rgCoef), _mm_madd_epi16(b, bCoef));
+    sum = _mm_srai_epi32(sum, MATRIX_SHIFT);
+
+	// Clamp to 0-255, SSE2 has no 32-bit min/max
+    sum = _mm_andnot_si128(_mm_srai_epi32(sum, 31), sum);
+    const __m128i max = _mm_set1_epi32(255);
+    const __m128i over = _mm_cmpgt_epi32(sum, max);
+    return _mm_or_si128(_mm_and_si128(over, max), _mm_andnot_si128(over, sum));
+}
+
+TARGET_SSE2 static void matrixSse2(QRgb* pixels, int count, const int m[9])
+{
+    const __m128i mask = _mm_set1_epi32(0xFF);
+    const __m128i alphaMask = _mm_set1_epi32(int(0xFF000000));
+    __m128i rgCoef[3], bCoef[3];
+    for (int row = 0; row < 3; ++row)
+    {
+        rgCoef[row] = _mm_set1_epi32(int(quint32(m[row * 3 + 1]) << 16 | (quint32(m[row * 3]) & 0xFFFF)));
+        bCoef[row] = _mm_set1_epi32(m[row * 3 + 2] & 0xFFFF);
+    }
+
+    int i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        const __m128i p = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pixels + i));
+        const __m128i rg = _mm_or_si128(_mm_and_si128(_mm_srli_epi32(p, 16), mask),
+            _mm_slli_epi32(_mm_and_si128(_mm_srli_epi32(p, 8), mask), 16));
+        const __m128i b = _mm_and_si128(p, mask);
+
+        const __m128i r = mixSse2(rg, b, rgCoef[0], bCoef[0]);
+        const __m128i g = mixSse2(rg, b, rgCoef[1], bCoef[1]);
+        const __m128i bl = mixSse2(rg, b, rgCoef[2], bCoef[2]);
+
+        const __m128i out = _mm_or_si128(_mm_or_si128(_mm_and_si128(p, alphaMask), _mm_slli_epi32(r, 16)),
+            _mm_or_si128(_mm_slli_epi32(g, 8), bl));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(pixels + i), out);
+    }
+    matrixScalar(pixels + i, count - i, m);
+}
+
+// Blend two pixels widened to 16-bit lanes (b, g, r, a per pixel)
+TARGET_SSE2 static inline __m128i blendHalfSse2(__m128i s, __m128i d, __m128i opacity)
+{
+    __m128i a = _mm_shufflehi_epi16(_mm_shufflelo_epi16(s, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+    a = div255Sse2(_mm_mullo_epi16(a, opacity));
+    const __m128i inverse = _mm_sub_epi16(_mm_set1_epi16(255), a);
+    return div255Sse2(_mm_add_epi16(_mm_mullo_epi16(s, a), _mm_mullo_epi16(d, inverse)));
+}
+
+TARGET_SSE2 static void blendSse2(QRgb* dst, const QRgb* src, int count, int opacity)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i alpha = _mm_set1_epi32(int(0xFF000000));
+    const __m128i op = _mm_set1_epi16(short(opacity));
+
+    int i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        const __m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        const __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dst + i));
+        const __m128i lo = blendHalfSse2(_mm_unpacklo_epi8(s, zero), _mm_unpacklo_epi8(d, zero), op);
+        const __m128i hi = blendHalfSse2(_mm_unpackhi_epi8(s, zero), _mm_unpackhi_epi8(d, zero), op);
+        const __m128i out = _mm_packus_epi16(lo, hi);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i),
+            _mm_or_si128(_mm_andnot_si128(alpha, out), _mm_and_si128(alpha, d)));
+    }
+    blendScalar(dst + i, src + i, count - i, opacity);
+}
+
+
+// -------------------------
+//   AVX2 (8 pixels)
+// -------------------------
+
+// Gathers read 4 bytes at every index, pad the tables so the last entry stays in bounds
+struct PaddedLuts {
+    alignas(64) quint8 table[3][256 + 4];
+
+    explicit PaddedLuts(const ChannelLut luts[3])
+    {
+        std::memset(table, 0, sizeof(table));
+        for (int c = 0; c < 3; ++c)
+            std::memcpy(table[c], luts[c].data(), 256);
+    }
+};
+
+TARGET_AVX2 static void lutAvx2(QRgb* pixels, int count, const ChannelLut luts[3])
+{
+    const PaddedLuts padded(luts);
+    const __m256i mask = _mm256_set1_epi32(0xFF);
+    const __m256i alphaMask = _mm256_set1_epi32(int(0xFF000000));
+    const int* red = reinterpret_cast<const int*>(padded.table[0]);
+    const int* green = reinterpret_cast<const int*>(padded.table[1]);
+    const int* blue = reinterpret_cast<const int*>(padded.table[2]);
+
+    int i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        const __m256i p = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pixels + i));
+        const __m256i r = _mm256_and_si256(_mm256_i32gather_epi32(red, _mm256_and_si256(_mm256_srli_epi32(p, 16), mask), 1), mask);
+        const __m256i g = _mm256_and_si256(_mm256_i32gather_epi32(green, _mm256_and_si256(_mm256_srli_epi32(p, 8), mask), 1), mask);
+        const __m256i b = _mm256_and_si256(_mm256_i32gather_epi32(blue, _mm256_and_si256(p, mask), 1), mask);
+
+        const __m256i out = _mm256_or_si256(_mm256_or_si256(_mm256_and_si256(p, alphaMask), _mm256_slli_epi32(r, 16)),
+            _mm256_or_si256(_mm256_slli_epi32(g, 8), b));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(pixels + i), out);
+    }
+    lutScalar(pixels + i, count - i, luts);
+}
+
+TARGET_AVX2 static inline __m256i mixAvx2(__m256i rg, __m256i b, __m256i rgCoef, __m256i bCoef)
+{
+    const __m256i sum = _mm256_srai_epi32(_mm256_add_epi32(_mm256_madd_epi16(rg, rgCoef), _mm256_madd_epi16(b, bCoef)), MATRIX_SHIFT);
+    return _mm256_min_epi32(_mm256_max_epi32(sum, _mm256_setzero_si256()), _mm256_set1_epi32(255));
+}
+
+TARGET_AVX2 static void matrixAvx2(QRgb* pixels, int count, const int m[9])
+{
+    const __m256i mask = _mm256_set1_epi32(0xFF);
+    const __m256i alphaMask = _mm256_set1_epi32(int(0xFF000000));
+    __m256i rgCoef[3], bCoef[3];
+    for (int row = 0; row < 3; ++row)
+    {
+        rgCoef[row] = _mm256_set1_epi32(int(quint32(m[row * 3 + 1]) << 16 | (quint32(m[row * 3]) & 0xFFFF)));
+        bCoef[row] = _mm256_set1_epi32(m[row * 3 + 2] & 0xFFFF);
+    }
+
+    int i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        const __m256i p = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pixels + i));
+        const __m256i rg = _mm256_or_si256(_mm256_and_si256(_mm256_srli_epi32(p, 16), mask),
+            _mm256_slli_epi32(_mm256_and_si256(_mm256_srli_epi32(p, 8), mask), 16));
+        const __m256i b = _mm256_and_si256(p, mask);
+
+        const __m256i r = mixAvx2(rg, b, rgCoef[0], bCoef[0]);
+        const __m256i g = mixAvx2(rg, b, rgCoef[1], bCoef[1]);
+        const __m256i bl = mixAvx2(rg, b, rgCoef[2], bCoef[2]);
+
+        const __m256i out = _mm256_or_si256(_mm256_or_si256(_mm256_and_si256(p, alphaMask), _mm256_slli_epi32(r, 16)),
+            _mm256_or_si256(_mm256_slli_epi32(g, 8), bl));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(pixels + i), out);
+    }
+    matrixScalar(pixels + i, count - i, m);
+}
+
+TARGET_AVX2 static inline __m256i div255Avx2(__m256i x)
+{
+    x = _mm256_add_epi16(x, _mm256_set1_epi16(128));
+    return _mm256_srli_epi16(_mm256_add_epi16(x, _mm256_srli_epi16(x, 8)), 8);
+}
+
+TARGET_AVX2 static inline __m256i blendHalfAvx2(__m256i s, __m256i d, __m256i opacity)
+{
+    __m256i a = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(s, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+    a = div255Avx2(_mm256_mullo_epi16(a, opacity));
+    const __m256i inverse = _mm256_sub_epi16(_mm256_set1_epi16(255), a);
+    return div255Avx2(_mm256_add_epi16(_mm256_mullo_epi16(s, a), _mm256_mullo_epi16(d, inverse)));
+}
+
+TARGET_AVX2 static void blendAvx2(QRgb* dst, const QRgb* src, int count, int opacity)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i alpha = _mm256_set1_epi32(int(0xFF000000));
+    const __m256i op = _mm256_set1_epi16(short(opacity));
+
+	// Unpack and pack both work within 128-bit lanes, so pixel order is kept
+    int i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        const __m256i s = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+        const __m256i d = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(dst + i));
+        const __m256i lo = blendHalfAvx2(_mm256_unpacklo_epi8(s, zero), _mm256_unpacklo_epi8(d, zero), op);
+        const __m256i hi = blendHalfAvx2(_mm256_unpackhi_epi8(s, zero), _mm256_unpackhi_epi8(d, zero), op);
+        const __m256i out = _mm256_packus_epi16(lo, hi);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i),
+            _mm256_or_si256(_mm256_andnot_si256(alpha, out), _mm256_and_si256(alpha, d)));
+    }
+    blendScalar(dst + i, src + i, count - i, opacity);
+}
+
+TARGET_AVX2 static inline __m256i saturateChannelAvx2(__m256i c, __m256i sum, __m256i scale)
+{
+    const __m256i offset = _mm256_sub_epi32(_mm256_slli_epi32(c, 1), sum);
+    __m256i value = _mm256_add_epi32(_mm256_slli_epi32(sum, SATURATION_SHIFT), _mm256_mullo_epi32(offset, scale));
+    value = _mm256_srai_epi32(_mm256_add_epi32(value, _mm256_set1_epi32(1 << SATURATION_SHIFT)), SATURATION_SHIFT + 1);
+    return _mm256_min_epi32(_mm256_max_epi32(value, _mm256_setzero_si256()), _mm256_set1_epi32(255));
+}
+
+TARGET_AVX2 static void saturationAvx2(QRgb* pixels, int count, int factor)
+{
+    const __m256i mask = _mm256_set1_epi32(0xFF);
+    const __m256i alphaMask = _mm256_set1_epi32(int(0xFF000000));
+    const __m256i maxSum = _mm256_set1_epi32(510);
+    const __m256i capRound = _mm256_set1_epi32(1 << (CAP_SHIFT - 1));
+    const __m256i factors = _mm256_set1_epi32(factor);
+
+    int i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        const __m256i p = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pixels + i));
+        const __m256i r = _mm256_and_si256(_mm256_srli_epi32(p, 16), mask);
+        const __m256i g = _mm256_and_si256(_mm256_srli_epi32(p, 8), mask);
+        const __m256i b = _mm256_and_si256(p, mask);
+
+        const __m256i maxChannel = _mm256_max_epi32(_mm256_max_epi32(r, g), b);
+        const __m256i minChannel = _mm256_min_epi32(_mm256_min_epi32(r, g), b);
+        const __m256i sum = _mm256_add_epi32(maxChannel, minChannel);
+        const __m256i reciprocal = _mm256_i32gather_epi32(RECIPROCALS.data(), _mm256_sub_epi32(maxChannel, minChannel), 4);
+        const __m256i cap = _mm256_srai_epi32(_mm256_add_epi32(
+            _mm256_mullo_epi32(_mm256_min_epi32(sum, _mm256_sub_epi32(maxSum, sum)), reciprocal), capRound), CAP_SHIFT);
+        const __m256i scale = _mm256_min_epi32(factors, cap);
+
+        const __m256i out = _mm256_or_si256(
+            _mm256_or_si256(_mm256_and_si256(p, alphaMask), _mm256_slli_epi32(saturateChannelAvx2(r, sum, scale), 16)),
+            _mm256_or_si256(_mm256_slli_epi32(saturateChannelAvx2(g, sum, scale), 8), saturateChannelAvx2(b, sum, scale)));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(pixels + i), out);
+    }
+    saturationScalar(pixels + i, count - i, factor);
+}
+
+
+// -------------------------
+//   AVX-512 (16 pixels)
+// -------------------------
+
+TARGET_AVX512 static void lutAvx512(QRgb* pixels, int count, const ChannelLut luts[3])
+{
+    const PaddedLuts padded(luts);
+    const __m512i mask = _mm512_set1_epi32(0xFF);
+    const __m512i alphaMask = _mm512_set1_epi32(int(0xFF000000));
+
+    int i = 0;
+    for (; i + 16 <= count; i += 16)
+    {
+        const __m512i p = _mm512_loadu_si512(pixels + i);
+        const __m512i r = _mm512_and_si512(_mm512_i32gather_epi32(_mm512_and_si512(_mm512_srli_epi32(p, 16), mask), padded.table[0], 1), mask);
+        const __m512i g = _mm512_and_si512(_mm512_i32gather_epi32(_mm512_and_si512(_mm512_srli_epi32(p, 8), mask), padded.table[1], 1), mask);
+        const __m512i b = _mm512_and_si512(_mm512_i32gather_epi32(_mm512_and_si512(p, mask), padded.table[2], 1), mask);
+
+        const __m512i out = _mm512_or_si512(_mm512_or_si512(_mm512_and_si512(p, alphaMask), _mm512_slli_epi32(r, 16)),
+            _mm512_or_si512(_mm512_slli_epi32(g, 8), b));
+        _mm512_storeu_si512(pixels + i, out);
+    }
+    lutScalar(pixels + i, count - i, luts);
+}
+
+TARGET_AVX512 static inline __m512i mixAvx512(__m512i rg, __m512i b, __m512i rgCoef, __m512i bCoef)
+{
+    const __m512i sum = _mm512_srai_epi32(_mm512_add_epi32(_mm512_madd_epi16(rg, rgCoef), _mm512_madd_epi16(b, bCoef)), MATRIX_SHIFT);
+    return _mm512_min_epi32(_mm512_max_epi32(sum, _mm512_setzero_si512()), _mm512_set1_epi32(255));
+}
+
+TARGET_AVX512 static void matrixAvx512(QRgb* pixels, int count, const int m[9])
+{
+    const __m512i mask = _mm512_set1_epi32(0xFF);
+    const __m512i alphaMask = _mm512_set1_epi32(int(0xFF000000));
+    __m512i rgCoef[3], bCoef[3];
+    for (int row = 0; row < 3; ++row)
+    {
+        rgCoef[row] = _mm512_set1_epi32(int(quint32(m[row * 3 + 1]) << 16 | (quint32(m[row * 3]) & 0xFFFF)));
+        bCoef[row] = _mm512_set1_epi32(m[row * 3 + 2] & 0xFFFF);
+    }
+
+    int i = 0;
+    for (; i + 16 <= count; i += 16)
+    {
+        const __m512i p = _mm512_loadu_si512(pixels + i);
+        const __m512i rg = _mm512_or_si512(_mm512_and_si512(_mm512_srli_epi32(p, 16), mask),
+            _mm512_slli_epi32(_mm512_and_si512(_mm512_srli_epi32(p, 8), mask), 16));
+        const __m512i b = _mm512_and_si512(p, mask);
+
+        const __m512i r = mixAvx512(rg, b, rgCoef[0], bCoef[0]);
+        const __m512i g = mixAvx512(rg, b, rgCoef[1], bCoef[1]);
+        const __m512i bl = mixAvx512(rg, b, rgCoef[2], bCoef[2]);
+
+        const __m512i out = _mm512_or_si512(_mm512_or_si512(_mm512_and_si512(p, alphaMask), _mm512_slli_epi32(r, 16)),
+            _mm512_or_si512(_mm512_slli_epi32(g, 8), bl));
+        _mm512_storeu_si512(pixels + i, out);
+    }
+    matrixScalar(pixels + i, count - i, m);
+}
+
+TARGET_AVX512 static inline __m512i div255Avx512(__m512i x)
+{
+    x = _mm512_add_epi16(x, _mm512_set1_epi16(128));
+    return _mm512_srli_epi16(_mm512_add_epi16(x, _mm512_srli_epi16(x, 8)), 8);
+}
+
+TARGET_AVX512 static inline __m512i blendHalfAvx512(__m512i s, __m512i d, __m512i opacity)
+{
+    __m512i a = _mm512_shufflehi_epi16(_mm512_shufflelo_epi16(s, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+    a = div255Avx512(_mm512_mullo_epi16(a, opacity));
+    const __m512i inverse = _mm512_sub_epi16(_mm512_set1_epi16(255), a);
+    return div255Avx512(_mm512_add_epi16(_mm512_mullo_epi16(s, a), _mm512_mullo_epi16(d, inverse)));
+}
+
+TARGET_AVX512 static void blendAvx512(QRgb* dst, const QRgb* src, int count, int opacity)
+{
+    const __m512i zero = _mm512_setzero_si512();
+    const __m512i alpha = _mm512_set1_epi32(int(0xFF000000));
+    const __m512i op = _mm512_set1_epi16(short(opacity));
+
+    int i = 0;
+    for (; i + 16 <= count; i += 16)
+    {
+        const __m512i s = _mm512_loadu_si512(src + i);
+        const __m512i d = _mm512_loadu_si512(dst + i);
+        const __m512i lo = blendHalfAvx512(_mm512_unpacklo_epi8(s, zero), _mm512_unpacklo_epi8(d, zero), op);
+        const __m512i hi = blendHalfAvx512(_mm512_unpackhi_epi8(s, zero), _mm512_unpackhi_epi8(d, zero), op);
+        const __m512i out = _mm512_packus_epi16(lo, hi);
+        _mm512_storeu_si512(dst + i, _mm512_or_si512(_mm512_andnot_si512(alpha, out), _mm512_and_si512(alpha, d)));
+    }
+    blendScalar(dst + i, src + i, count - i, opacity);
+}
+
+TARGET_AVX512 static inline __m512i saturateChannelAvx512(__m512i c, __m512i sum, __m512i scale)
+{
+    const __m512i offset = _mm512_sub_epi32(_mm512_slli_epi32(c, 1), sum);
+    __m512i value = _mm512_add_epi32(_mm512_slli_epi32(sum, SATURATION_SHIFT), _mm512_mullo_epi32(offset, scale));
+    value = _mm512_srai_epi32(_mm512_add_epi32(value, _mm512_set1_epi32(1 << SATURATION_SHIFT)), SATURATION_SHIFT + 1);
+    return _mm512_min_epi32(_mm512_max_epi32(value, _mm512_setzero_si512()), _mm512_set1_epi32(255));
+}
+
+TARGET_AVX512 static void saturationAvx512(QRgb* pixels, int count, int factor)
+{
+    const __m512i mask = _mm512_set1_epi32(0xFF);
+    const __m512i alphaMask = _mm512_set1_epi32(int(0xFF000000));
+    const __m512i maxSum = _mm512_set1_epi32(510);
+    const __m512i capRound = _mm512_set1_epi32(1 << (CAP_SHIFT - 1));
+    const __m512i factors = _mm512_set1_epi32(factor);
+
+    int i = 0;
+    for (; i + 16 <= count; i += 16)
+    {
+        const __m512i p = _mm512_loadu_si512(pixels + i);
+        const __m512i r = _mm512_and_si512(_mm512_srli_epi32(p, 16), mask);
+        const __m512i g = _mm512_and_si512(_mm512_srli_epi32(p, 8), mask);
+        const __m512i b = _mm512_and_si512(p, mask);
+
+        const __m512i maxChannel = _mm512_max_epi32(_mm512_max_epi32(r, g), b);
+        const __m512i minChannel = _mm512_min_epi32(_mm512_min_epi32(r, g), b);
+        const __m512i sum = _mm512_add_epi32(maxChannel, minChannel);
+        const __m512i reciprocal = _mm512_i32gather_epi32(_mm512_sub_epi32(maxChannel, minChannel), RECIPROCALS.data(), 4);
+        const __m512i cap = _mm512_srai_epi32(_mm512_add_epi32(
+            _mm512_mullo_epi32(_mm512_min_epi32(sum, _mm512_sub_epi32(maxSum, sum)), reciprocal), capRound), CAP_SHIFT);
+        const __m512i scale = _mm512_min_epi32(factors, cap);
+
+        const __m512i out = _mm512_or_si512(
+            _mm512_or_si512(_mm512_and_si512(p, alphaMask), _mm512_slli_epi32(saturateChannelAvx512(r, sum, scale), 16)),
+            _mm512_or_si512(_mm512_slli_epi32(saturateChannelAvx512(g, sum, scale), 8), saturateChannelAvx512(b, sum, scale)));
+        _mm512_storeu_si512(pixels + i, out);
+    }
+    saturationScalar(pixels + i, count - i, factor);
+}
+
+
+// -------------------------
+//   CPU detection
+// -------------------------
+
+static PixelKernels::Isa detectIsa()
+{
+    bool sse2 = false;
+    bool avx2 = false;
+    bool avx512 = false;
+
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    const int maxLeaf = info[0];
+
+    __cpuid(info, 1);
+    sse2 = info[3] & (1 << 26);
+    const bool osxsave = info[2] & (1 << 27);
+    const bool avx = info[2] & (1 << 28);
+
+	// The OS must save the wide registers on context switches
+    const unsigned long long xcr0 = osxsave ? _xgetbv(0) : 0;
+    const bool ymmSaved = (xcr0 & 0x06) == 0x06;
+    const bool zmmSaved = (xcr0 & 0xE6) == 0xE6;
+
+    if (maxLeaf >= 7)
+    {
+        __cpuidex(info, 7, 0);
+        avx2 = avx && ymmSaved && (info[1] & (1 << 5));
+        avx512 = zmmSaved && (info[1] & (1 << 16)) && (info[1] & (1 << 30)); // F and BW
+    }
+#else
+	// Also checks that the OS saves the wide registers
+    __builtin_cpu_init();
+    sse2 = __builtin_cpu_supports("sse2");
+    avx2 = __builtin_cpu_supports("avx2");
+    avx512 = __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw");
+#endif
+
+    if (avx512)
+        return PixelKernels::Avx512;
+    if (avx2)
+        return PixelKernels::Avx2;
+    return sse2 ? PixelKernels::Sse2 : PixelKernels::Scalar;
+}
+
+#else
+
+static PixelKernels::Isa detectIsa()
+{
+    return PixelKernels::Scalar;
+}
+
+#endif // PIXELKERNELS_X86
+
+
+namespace PixelKernels {
+
+	Isa bestIsa()
+	{
+		static const Isa isa = detectIsa(); // Detected once, thread-safe initialization
+		return isa;
+	}
+
+	bool isSupported(Isa isa)
+	{
+		return isa <= bestIsa();
+	}
+
+	void applyLut(QRgb* pixels, int count, const ChannelLut luts[3], Isa isa)
+	{
+		switch (isa)
+		{
+#ifdef PIXELKERNELS_X86
+		case Avx512: lutAvx512(pixels, count, luts); break;
+		case Avx2:   lutAvx2(pixels, count, luts); break;
+#endif
+		default:     lutScalar(pixels, count, luts); break;
+		}
+	}
+
+	void applyMatrix(QRgb* pixels, int count, const int matrix[9], Isa isa)
+	{
+		switch (isa)
+		{
+#ifdef PIXELKERNELS_X86
+		case Avx512: matrixAvx512(pixels, count, matrix); break;
+		case Avx2:   matrixAvx2(pixels, count, matrix); break;
+		case Sse2:   matrixSse2(pixels, count, matrix); break;
+#endif
+		default:     matrixScalar(pixels, count, matrix); break;
+		}
+	}
+
+	void applySaturation(QRgb* pixels, int count, int factor, Isa isa)
+	{
+		factor = std::clamp(factor, 0, 8 << SATURATION_SHIFT);
+		switch (isa)
+		{
+#ifdef PIXELKERNELS_X86
+		case Avx512: saturationAvx512(pixels, count, factor); break;
+		case Avx2:   saturationAvx2(pixels, count, factor); break;
+#endif
+		default:     saturationScalar(pixels, count, factor); break;
+		}
+	}
+
+	void blend(QRgb* dst, const QRgb* src, int count, int opacity, Isa isa)
+	{
+		switch (isa)
+		{
+#ifdef PIXELKERNELS_X86
+		case Avx512: blendAvx512(dst, src, count, opacity); break;
+		case Avx2:   blendAvx2(dst, src, count, opacity); break;
+		case Sse2:   blendSse2(dst, src, count, opacity); break;
+#endif
+		default:     blendScalar(dst, src, count, opacity); break;
+		}
+	}
+
+}
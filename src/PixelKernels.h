@@ -0,0 +1,109 @@
+#pragma once
+#include <QtGlobal>
+#include <QRgb>
+#include <array>
+
+/**
+ * @brief Vectorized pixel kernels with runtime CPU dispatch.
+ *
+ * @details
+ * Every kernel has a portable scalar version and, on x86, SSE2, AVX2 and
+ * AVX-512 (F + BW) versions. The widest instruction set supported by the
+ * CPU is detected once and used by default; all versions produce
+ * bit-identical results, so the choice only affects speed.
+ *
+ * Kernels work on runs of 32-bit straight (non-premultiplied) ARGB
+ * pixels and clamp every result channel to 0-255.
+ *
+ * @see PointTransform
+ */
+namespace PixelKernels {
+
+	/**
+	 * @brief Instruction set of a kernel version.
+	 */
+	enum Isa {
+		Scalar,  ///< Portable C++.
+		Sse2,    ///< 4 pixels per step.
+		Avx2,    ///< 8 pixels per step.
+		Avx512   ///< 16 pixels per step.
+	};
+
+	/// Lookup table for one colour channel.
+	using ChannelLut = std::array<quint8, 256>;
+
+	/**
+	 * @brief Returns the widest instruction set supported by this CPU and OS.
+	 * @return Detected once, then cached.
+	 */
+	Isa bestIsa();
+
+	/**
+	 * @brief Checks whether kernels of an instruction set can run here.
+	 * @param isa Instruction set.
+	 * @return True if the CPU supports it and it was compiled in.
+	 */
+	bool isSupported(Isa isa);
+
+	/**
+	 * @brief Replaces the R, G and B channels through lookup tables.
+	 * @param pixels Pixels to modify in place; alpha is kept.
+	 * @param count Number of pixels.
+	 * @param luts Tables for red, green and blue.
+	 * @param isa Version to run (must be supported).
+	 *
+	 * @details The SSE2 version is the scalar one, SSE2 has no gather.
+	 */
+	void applyLut(QRgb* pixels, int count, const ChannelLut luts[3], Isa isa = bestIsa());
+
+	/**
+	 * @brief Mixes the R, G and B channels with a fixed-point colour matrix.
+	 * @param pixels Pixels to modify in place; alpha is kept.
+	 * @param count Number of pixels.
+	 * @param matrix Row-major 3x3 matrix (rows produce R, G, B from R, G, B),
+	 *        scaled by 1 << MATRIX_SHIFT; coefficients must lie in (-8, 8).
+	 * @param isa Version to run (must be supported).
+	 *
+	 * @details Results are shifted down (rounding towards negative infinity)
+	 * and clamped to 0-255.
+	 */
+	void applyMatrix(QRgb* pixels, int count, const int matrix[9], Isa isa = bestIsa());
+
+	/**
+	 * @brief Scales the HSL saturation of pixels, keeping hue and lightness.
+	 * @param pixels Pixels to modify in place; alpha is kept.
+	 * @param count Number of pixels.
+	 * @param factor Saturation scale multiplied by 1 << SATURATION_SHIFT,
+	 *        0 gives gray, clamped to 0-8.
+	 * @param isa Version to run (must be supported).
+	 *
+	 * @details For fixed hue and lightness every channel lies on a line
+	 * through the lightness L = (max + min) / 2, so channels move away from
+	 * L linearly; the scale is capped where HSL saturation reaches 1. The
+	 * cap max(S) = min(max + min, 510 - max - min) / (max - min) uses a
+	 * reciprocal table instead of a division, everything else is integer
+	 * arithmetic. The SSE2 version is the scalar one, SSE2 has no 32-bit
+	 * multiply or gather.
+	 */
+	void applySaturation(QRgb* pixels, int count, int factor, Isa isa = bestIsa());
+
+	/**
+	 * @brief Blends source pixels over destination pixels.
+	 * @param dst Destination pixels, modified in place; alpha is kept.
+	 * @param src Source pixels with straight alpha.
+	 * @param count Number of pixels.
+	 * @param opacity Global source opacity 0-255.
+	 * @param isa Version to run (must be supported).
+	 *
+	 * @details Per channel dst = (src * a + dst * (255 - a)) / 255 with
+	 * a = srcAlpha * opacity / 255, both divisions rounded.
+	 */
+	void blend(QRgb* dst, const QRgb* src, int count, int opacity, Isa isa = bestIsa());
+
+	/// Fixed-point scale of applyMatrix() coefficients.
+	constexpr int MATRIX_SHIFT = 12;
+
+	/// Fixed-point scale of the applySaturation() factor.
+	constexpr int SATURATION_SHIFT = 12;
+
+}
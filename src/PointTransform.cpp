@@ -0,0 +1,151 @@
+#include "PointTransform.h"
+#include <algorithm>
+#include <cmath>
+
+// Filter presets, same numbering as the editor combo box
+enum Preset { None, Grayscale, Sepia, Negative, Pastel, Vintage };
+
+static int clampChannel(int value)
+{
+    return std::clamp(value, 0, 255);
+}
+
+PointTransform::PointTransform(const ColorAdjustments& adjustments)
+{
+    m_identity = adjustments.isIdentity();
+    m_saturate = adjustments.saturation != 0;
+    m_saturation = int(std::lround((1.0 + adjustments.saturation / 100.0) * (1 << PixelKernels::SATURATION_SHIFT)));
+
+    const double contrast = (259 * (adjustments.contrast + 255)) / (255.0 * (259 - adjustments.contrast)); // Photoshop formula
+    const double temperature = 30 * (adjustments.temperature / 100.0);
+    const double gains[3] = { 1.0 + adjustments.red / 100.0, 1.0 + adjustments.green / 100.0, 1.0 + adjustments.blue / 100.0 };
+    const int filter = adjustments.filter;
+
+    for (int c = 0; c < 3; ++c)
+    {
+        for (int v = 0; v < 256; ++v)
+        {
+			// Stages before saturation
+            int pre = clampChannel(v + adjustments.brightness);
+            if (adjustments.contrast != 0)
+                pre = clampChannel(int(contrast * (pre - 128) + 128));
+            m_pre[c][v] = quint8(pre);
+
+			// Stages after saturation, in editor order
+            int post = v;
+            if (adjustments.temperature != 0 && c != 1) // Green is not affected
+                post = clampChannel(int(post + (c == 0 ? temperature : -temperature)));
+            if (gains[c] != 1.0)
+                post = clampChannel(int(post * gains[c]));
+
+            if (filter == Negative)
+                post = 255 - post;
+			else if (filter == Pastel) // Compress towards a light tint
+            {
+                static const double scale[3] = { 0.8, 0.8, 0.9 };
+                static const int offset[3] = { 70, 60, 95 };
+                post = clampChannel(int(post * scale[c] + offset[c]));
+            }
+            m_post[c][v] = quint8(post);
+
+			m_final[c][v] = quint8(filter == Vintage ? (v + 255) / 2 : v); // Vintage fades towards white
+        }
+    }
+    m_hasFinal = filter == Vintage;
+
+	// Without saturation in between, both tables collapse into one lookup
+    if (!m_saturate)
+    {
+        for (int c = 0; c < 3; ++c)
+        {
+            Lut merged;
+            for (int v = 0; v < 256; ++v)
+                merged[v] = m_post[c][m_pre[c][v]];
+            m_post[c] = merged;
+        }
+    }
+
+    // Mixing presets as one matrix
+    double matrix[9];
+    const double gray[3] = { 11 / 32.0, 16 / 32.0, 5 / 32.0 }; // qGray() weights
+
+    switch (filter)
+    {
+    case Grayscale:
+        for (int row = 0; row < 3; ++row)
+            std::copy(gray, gray + 3, matrix + row * 3);
+        m_hasMatrix = true;
+        break;
+
+    case Sepia: {
+        const double sepia[9] = { 0.393, 0.769, 0.189,
+                                  0.349, 0.686, 0.168,
+                                  0.272, 0.534, 0.131 };
+        std::copy(sepia, sepia + 9, matrix);
+        m_hasMatrix = true;
+        break;
+    }
+
+    case Vintage: {
+		// Desaturate by two thirds towards gray, then mix the channels
+        const double mix[9] = { 0.9, 0.5, 0.2,
+                                0.3, 0.7, 0.2,
+                                0.1, 0.3, 0.6 };
+        double desaturate[9];
+        for (int row = 0; row < 3; ++row)
+            for (int col = 0; col < 3; ++col)
+                desaturate[row * 3 + col] = (2 * gray[col] + (row == col ? 1.0 : 0.0)) / 3;
+
+        for (int row = 0; row < 3; ++row)
+            for (int col = 0; col < 3; ++col)
+            {
+                matrix[row * 3 + col] = 0;
+                for (int k = 0; k < 3; ++k)
+                    matrix[row * 3 + col] += mix[row * 3 + k] * desaturate[k * 3 + col];
+            }
+        m_hasMatrix = true;
+        break;
+    }
+
+    default:
+        break;
+    }
+
+    if (m_hasMatrix)
+    {
+        for (int i = 0; i < 9; ++i)
+            m_matrix[i] = int(std::lround(matrix[i] * (1 << MATRIX_SHIFT)));
+    }
+}
+
+void PointTransform::applyToPixels(QRgb* pixels, int count) const
+{
+    if (m_saturate)
+    {
+        PixelKernels::applyLut(pixels, count, m_pre);
+        PixelKernels::applySaturation(pixels, count, m_saturation);
+    }
+
+    PixelKernels::applyLut(pixels, count, m_post);
+
+    if (m_hasMatrix)
+    {
+        PixelKernels::applyMatrix(pixels, count, m_matrix);
+        if (m_hasFinal)
+            PixelKernels::applyLut(pixels, count, m_final);
+    }
+}
+
+void PointTransform::apply(QImage& image) const
+{
+    if (m_identity || image.isNull())
+        return;
+
+	// Kernels work on straight (not premultiplied) 32-bit pixels
+    if (image.format() != QImage::Format_RGB32 && image.format() != QImage::Format_ARGB32)
+        image = image.convertToFormat(image.hasAlphaChannel() ? QImage::Format_ARGB32 : QImage::Format_RGB32);
+
+    const int width = image.width();
+    for (int y = 0; y < image.height(); ++y)
+        applyToPixels(reinterpret_cast<QRgb*>(image.scanLine(y)), width);
+}
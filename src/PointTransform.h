@@ -0,0 +1,103 @@
+#pragma once
+#include <QtGlobal>
+#include <QImage>
+#include "PixelKernels.h"
+
+/**
+ * @brief Colour adjustment values of the photo editor.
+ *
+ * @details Slider values use the editor range -100..100, 0 means no change.
+ */
+struct ColorAdjustments {
+    int brightness = 0;   ///< Added to every channel.
+    int contrast = 0;     ///< Photoshop-style contrast around mid grey.
+    int saturation = 0;   ///< HSL saturation scale, -100 -> 0.0, 100 -> 2.0.
+    int temperature = 0;  ///< Positive warms (red up, blue down), negative cools.
+    int red = 0;          ///< Red gain, -100 -> 0.0, 100 -> 2.0.
+    int green = 0;        ///< Green gain.
+    int blue = 0;         ///< Blue gain.
+    int filter = 0;       ///< Preset: 0 none, 1 grayscale, 2 sepia, 3 negative, 4 pastel, 5 vintage.
+
+    /**
+     * @brief Checks whether the adjustments leave pixels unchanged.
+     * @return True if all values are at their defaults.
+     */
+    bool isIdentity() const
+    {
+        return brightness == 0 && contrast == 0 && saturation == 0 && temperature == 0
+            && red == 0 && green == 0 && blue == 0 && filter == 0;
+    }
+
+    bool operator==(const ColorAdjustments& other) const
+    {
+        return brightness == other.brightness && contrast == other.contrast && saturation == other.saturation
+            && temperature == other.temperature && red == other.red && green == other.green
+            && blue == other.blue && filter == other.filter;
+    }
+
+    bool operator!=(const ColorAdjustments& other) const { return !(*this == other); }
+};
+
+/**
+ * @class PointTransform
+ * @brief All per-pixel colour adjustments compiled into one fused transform.
+ *
+ * @details
+ * The editor adjustments are point operations: every output pixel depends
+ * only on the same input pixel. Instead of one full-image pass per
+ * adjustment, they are compiled once into
+ *  - a per-channel lookup table for brightness and contrast,
+ *  - the saturation scale,
+ *  - a per-channel lookup table for temperature, channel gains and the
+ *    per-channel presets (negative, pastel),
+ *  - a 3x3 fixed-point colour matrix for the mixing presets (grayscale,
+ *    sepia, vintage) followed by a final lookup table,
+ * and applied scanline by scanline. Stages that are not needed are skipped;
+ * without saturation the two tables are merged. Every stage runs through
+ * the vectorized integer PixelKernels.
+ *
+ * Alpha is preserved.
+ */
+class PointTransform {
+public:
+    /**
+     * @brief Compiles the adjustments into tables and a matrix.
+     * @param adjustments Editor slider values.
+     */
+    explicit PointTransform(const ColorAdjustments& adjustments);
+
+    /**
+     * @brief Checks whether applying the transform would change nothing.
+     * @return True for default adjustments.
+     */
+    bool isIdentity() const { return m_identity; }
+
+    /**
+     * @brief Applies the transform to a whole image in one pass.
+     * @param image Image to modify; converted to a 32-bit format if needed.
+     */
+    void apply(QImage& image) const;
+
+    /**
+     * @brief Applies the transform to a run of pixels.
+     * @param pixels 32-bit (A)RGB pixels, modified in place.
+     * @param count Number of pixels.
+     */
+    void applyToPixels(QRgb* pixels, int count) const;
+
+    /// Fixed-point scale of the colour matrix coefficients.
+    static const int MATRIX_SHIFT = PixelKernels::MATRIX_SHIFT;
+
+private:
+    using Lut = PixelKernels::ChannelLut;
+
+    bool m_identity = true;
+    bool m_saturate = false;     ///< Saturation stage is active.
+    bool m_hasMatrix = false;    ///< Colour matrix stage is active.
+    bool m_hasFinal = false;     ///< Table after the matrix is not the identity.
+    int m_saturation = 1 << PixelKernels::SATURATION_SHIFT; ///< Saturation scale, fixed point.
+    Lut m_pre[3];                ///< Brightness and contrast (R, G, B), only used with saturation.
+    Lut m_post[3];               ///< Temperature, gains, per-channel presets (merged with m_pre without saturation).
+    int m_matrix[9] = {};        ///< Row-major colour matrix, scaled by 1 << MATRIX_SHIFT.
+    Lut m_final[3];              ///< Applied after the matrix.
+};
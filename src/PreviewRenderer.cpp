@@ -0,0 +1,75 @@
+#include "PreviewRenderer.h"
+#include "ImagePipeline.h"
+#include <QThread>
+
+PreviewRenderer::PreviewRenderer(QObject* parent)
+    : QObject(parent),
+      m_thread(new QThread(this)),
+      m_worker(new QObject())
+{
+    m_worker->moveToThread(m_thread);
+    connect(m_thread, &QThread::finished, m_worker, &QObject::deleteLater);
+    m_thread->setObjectName("PreviewRenderer");
+    m_thread->start();
+}
+
+PreviewRenderer::~PreviewRenderer()
+{
+	cancel(); // Running render stops after its current tiles
+    m_thread->quit();
+    m_thread->wait();
+}
+
+int PreviewRenderer::request(const QImage& source, const EditRecipe& recipe, const QImage& watermark, const QSize& targetSize,
+    const QRectF& view, Quality quality)
+{
+    const int generation = ++m_generation;
+
+	// Images are implicitly shared, posting a request copies no pixels
+    QMetaObject::invokeMethod(m_worker, [this, generation, source, recipe, watermark, targetSize, view, quality]() {
+        render(generation, source, recipe, watermark, targetSize, view, quality);
+        }, Qt::QueuedConnection);
+    return generation;
+}
+
+void PreviewRenderer::cancel()
+{
+    ++m_generation;
+}
+
+void PreviewRenderer::render(int generation, const QImage& source, const EditRecipe& recipe, const QImage& watermark,
+    const QSize& targetSize, const QRectF& view, Quality quality)
+{
+	if (isOutdated(generation)) // Superseded while queued, e.g. during a slider drag
+        return;
+
+    const auto progress = [this, generation](int, int) {
+        return !isOutdated(generation);
+    };
+
+    QImage image;
+    if (quality == Interactive)
+    {
+        image = m_cache.render(source, recipe, watermark, progress);
+        if (!image.isNull() && !view.isNull())
+            image = image.copy(ImagePipeline::cropRect(image.size(), view));
+    }
+    else
+    {
+		// Only the visible pixels of the original are read and processed
+        const QSize size = ImagePipeline::outputSize(source.size(), recipe);
+        const QRect region = view.isNull() ? QRect(QPoint(0, 0), size) : ImagePipeline::cropRect(size, view);
+        image = ImagePipeline::renderRegion(source, recipe, region, watermark, progress);
+    }
+    if (image.isNull() || isOutdated(generation))
+        return;
+
+    if (targetSize.isValid() && image.size() != image.size().scaled(targetSize, Qt::KeepAspectRatio))
+        image = image.scaled(targetSize, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+
+	// Deliver on the owning thread, unless a newer request arrived meanwhile
+    QMetaObject::invokeMethod(this, [this, generation, image]() {
+        if (!isOutdated(generation))
+            emit rendered(image, generation);
+        }, Qt::QueuedConnection);
+}
@@ -0,0 +1,106 @@
+#pragma once
+#include <QObject>
+#include <QImage>
+#include <QSize>
+#include <QRectF>
+#include <atomic>
+#include "EditRecipe.h"
+#include "PipelineCache.h"
+
+class QThread;
+
+/**
+ * @class PreviewRenderer
+ * @brief Renders editor previews on a worker thread, newest request wins.
+ *
+ * @details
+ * Every request() gets a new generation number. The worker skips requests
+ * that are already outdated when it reaches them and cancels a running
+ * render (through the TileRenderer progress callback) as soon as a newer
+ * request arrives, so at most one tile band of stale work is finished.
+ * Results of older generations are dropped before they are delivered:
+ * rendered() only ever carries the image of the latest request.
+ *
+ * The GUI thread only posts requests and shows results, so input events
+ * are processed while a preview renders.
+ *
+ * Interactive requests render a display-sized proxy through a
+ * PipelineCache, so a request re-runs only the stages whose parameters
+ * changed since the previous one. Refined requests render the visible
+ * region of the full-resolution original and scale it down smoothly; the
+ * editor sends one when input goes idle or the view is zoomed.
+ *
+ * @see ImagePipeline
+ */
+class PreviewRenderer : public QObject {
+    Q_OBJECT
+
+public:
+    /**
+     * @brief How a request is rendered.
+     */
+    enum Quality {
+        Interactive,  ///< Whole result through the stage cache, then the view is cut out.
+        Refined       ///< Only the view, at the resolution of the source, not cached.
+    };
+
+    /**
+     * @brief Creates the renderer and its worker thread.
+     * @param parent Optional parent object.
+     */
+    explicit PreviewRenderer(QObject* parent = nullptr);
+
+    /**
+     * @brief Cancels the running render and stops the worker thread.
+     */
+    ~PreviewRenderer() override;
+
+    /**
+     * @brief Queues a preview render, superseding all earlier requests.
+     * @param source Image the recipe is applied to.
+     * @param recipe Edit steps.
+     * @param watermark Watermark image, see ImagePipeline::render().
+     * @param targetSize Bounding size the result is scaled to, invalid to keep the rendered size.
+     * @param view Visible part of the result in normalized coordinates, null for all of it.
+     * @param quality Rendering path, see Quality.
+     * @return Generation of the request.
+     */
+    int request(const QImage& source, const EditRecipe& recipe, const QImage& watermark, const QSize& targetSize = QSize(),
+        const QRectF& view = QRectF(), Quality quality = Interactive);
+
+    /**
+     * @brief Cancels all pending and running renders.
+     */
+    void cancel();
+
+    /**
+     * @brief Returns the generation of the latest request.
+     * @return Generation, 0 before the first request.
+     */
+    int generation() const { return m_generation.load(); }
+
+signals:
+    /**
+     * @brief Emitted on the owning thread when the latest request is rendered.
+     * @param image Rendered (and scaled) preview.
+     * @param generation Generation of the request.
+     */
+    void rendered(const QImage& image, int generation);
+
+private:
+    /**
+     * @brief Renders one request on the worker thread.
+     */
+    void render(int generation, const QImage& source, const EditRecipe& recipe, const QImage& watermark,
+        const QSize& targetSize, const QRectF& view, Quality quality);
+
+    /**
+     * @brief Checks whether a newer request or cancel() superseded a generation.
+     */
+    bool isOutdated(int generation) const { return m_generation.load() != generation; }
+
+    QThread* m_thread = nullptr;          ///< Worker thread.
+    QObject* m_worker = nullptr;          ///< Context object living on the worker thread.
+    std::atomic<int> m_generation{ 0 };   ///< Generation of the latest request.
+    PipelineCache m_cache;                ///< Stage results, only used on the worker thread.
+};
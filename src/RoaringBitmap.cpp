@@ -0,0 +1,306 @@
+#include "RoaringBitmap.h"
+#include <QtAlgorithms>
+#include <algorithm>
+#include <iterator>
+
+// Containers switch to the bitmap representation above this size
+static const int ARRAY_LIMIT = 4096;
+static const int BITMAP_WORDS = 1024; // 65536 bits
+
+
+// -------------------------
+//   Container
+// -------------------------
+
+bool RoaringBitmap::Container::contains(quint16 low) const
+{
+    if (isBitmap())
+        return (bitmap[low >> 6] >> (low & 63)) & 1;
+
+    return std::binary_search(array.cbegin(), array.cend(), low);
+}
+
+bool RoaringBitmap::Container::add(quint16 low)
+{
+    if (isBitmap())
+    {
+        quint64& word = bitmap[low >> 6];
+        const quint64 mask = quint64(1) << (low & 63);
+		if (word & mask) // Already present
+            return false;
+
+        word |= mask;
+        ++cardinality;
+        return true;
+    }
+
+    auto it = std::lower_bound(array.begin(), array.end(), low);
+	if (it != array.end() && *it == low) // Already present
+        return false;
+
+    array.insert(it, low);
+	if (++cardinality > ARRAY_LIMIT) // Too dense for an array
+        toBitmap();
+    return true;
+}
+
+bool RoaringBitmap::Container::remove(quint16 low)
+{
+    if (isBitmap())
+    {
+        quint64& word = bitmap[low >> 6];
+        const quint64 mask = quint64(1) << (low & 63);
+		if (!(word & mask)) // Not present
+            return false;
+
+        word &= ~mask;
+		if (--cardinality <= ARRAY_LIMIT) // Sparse again
+            toArray();
+        return true;
+    }
+
+    auto it = std::lower_bound(array.begin(), array.end(), low);
+	if (it == array.end() || *it != low) // Not present
+        return false;
+
+    array.erase(it);
+    --cardinality;
+    return true;
+}
+
+void RoaringBitmap::Container::toBitmap()
+{
+    bitmap.fill(0, BITMAP_WORDS);
+    for (quint16 low : std::as_const(array))
+        bitmap[low >> 6] |= quint64(1) << (low & 63);
+
+    array.clear();
+    array.squeeze();
+}
+
+void RoaringBitmap::Container::toArray()
+{
+    QList<quint16> values;
+    values.reserve(cardinality);
+
+    for (int w = 0; w < bitmap.size(); ++w)
+    {
+        // Extract set bits from lowest to highest
+        for (quint64 word = bitmap[w]; word != 0; word &= word - 1)
+            values.append(quint16(w * 64 + qCountTrailingZeroBits(word)));
+    }
+
+    array = values;
+    bitmap.clear();
+    bitmap.squeeze();
+}
+
+
+// -------------------------
+//   Container operations
+// -------------------------
+
+RoaringBitmap::Container RoaringBitmap::intersect(const Container& a, const Container& b)
+{
+    Container result;
+    result.key = a.key;
+
+    if (a.isBitmap() && b.isBitmap()) // Word-wise AND
+    {
+        result.bitmap.resize(BITMAP_WORDS);
+        for (int w = 0; w < BITMAP_WORDS; ++w)
+        {
+            result.bitmap[w] = a.bitmap[w] & b.bitmap[w];
+            result.cardinality += qPopulationCount(result.bitmap[w]);
+        }
+
+        if (result.cardinality <= ARRAY_LIMIT)
+            result.toArray();
+    }
+	else if (!a.isBitmap() && !b.isBitmap()) // Merge of two sorted arrays
+    {
+        std::set_intersection(a.array.cbegin(), a.array.cend(), b.array.cbegin(), b.array.cend(),
+            std::back_inserter(result.array));
+        result.cardinality = int(result.array.size());
+    }
+	else // Probe the bitmap with every array value
+    {
+        const Container& sparse = a.isBitmap() ? b : a;
+        const Container& dense = a.isBitmap() ? a : b;
+
+        for (quint16 low : sparse.array)
+        {
+            if (dense.contains(low))
+                result.array.append(low);
+        }
+        result.cardinality = int(result.array.size());
+    }
+
+    return result;
+}
+
+RoaringBitmap::Container RoaringBitmap::unite(const Container& a, const Container& b)
+{
+	if (!a.isBitmap() && !b.isBitmap()) // Merge of two sorted arrays
+    {
+        Container result;
+        result.key = a.key;
+        std::set_union(a.array.cbegin(), a.array.cend(), b.array.cbegin(), b.array.cend(),
+            std::back_inserter(result.array));
+        result.cardinality = int(result.array.size());
+
+        if (result.cardinality > ARRAY_LIMIT)
+            result.toBitmap();
+        return result;
+    }
+
+    // At least one side is dense, OR into a bitmap copy of it
+    Container result = a.isBitmap() ? a : b;
+    const Container& other = a.isBitmap() ? b : a;
+
+    if (other.isBitmap())
+    {
+        for (int w = 0; w < BITMAP_WORDS; ++w)
+            result.bitmap[w] |= other.bitmap[w];
+    }
+    else
+    {
+        for (quint16 low : other.array)
+            result.bitmap[low >> 6] |= quint64(1) << (low & 63);
+    }
+
+    result.cardinality = 0;
+    for (quint64 word : std::as_const(result.bitmap))
+        result.cardinality += qPopulationCount(word);
+
+    return result;
+}
+
+
+// -------------------------
+//   RoaringBitmap
+// -------------------------
+
+int RoaringBitmap::lowerBound(quint16 key) const
+{
+    auto it = std::lower_bound(m_containers.cbegin(), m_containers.cend(), key,
+        [](const Container& c, quint16 k) { return c.key < k; });
+    return int(it - m_containers.cbegin());
+}
+
+void RoaringBitmap::add(quint32 value)
+{
+    const quint16 key = quint16(value >> 16);
+    const int index = lowerBound(key);
+
+	if (index == m_containers.size() || m_containers[index].key != key) // New container
+    {
+        Container container;
+        container.key = key;
+        m_containers.insert(index, container);
+    }
+
+    m_containers[index].add(quint16(value & 0xFFFF));
+}
+
+void RoaringBitmap::remove(quint32 value)
+{
+    const quint16 key = quint16(value >> 16);
+    const int index = lowerBound(key);
+
+	if (index == m_containers.size() || m_containers[index].key != key) // Not present
+        return;
+
+    Container& container = m_containers[index];
+    container.remove(quint16(value & 0xFFFF));
+
+	if (container.cardinality == 0) // Drop empty containers
+        m_containers.removeAt(index);
+}
+
+bool RoaringBitmap::contains(quint32 value) const
+{
+    const quint16 key = quint16(value >> 16);
+    const int index = lowerBound(key);
+
+    return index < m_containers.size()
+        && m_containers[index].key == key
+        && m_containers[index].contains(quint16(value & 0xFFFF));
+}
+
+qint64 RoaringBitmap::cardinality() const
+{
+    qint64 total = 0;
+    for (const Container& container : m_containers)
+        total += container.cardinality;
+    return total;
+}
+
+QList<quint32> RoaringBitmap::toList() const
+{
+    QList<quint32> values;
+    values.reserve(cardinality());
+
+    for (const Container& container : m_containers)
+    {
+        const quint32 high = quint32(container.key) << 16;
+
+        if (container.isBitmap())
+        {
+            for (int w = 0; w < BITMAP_WORDS; ++w)
+                for (quint64 word = container.bitmap[w]; word != 0; word &= word - 1)
+                    values.append(high | quint32(w * 64 + qCountTrailingZeroBits(word)));
+        }
+        else
+        {
+            for (quint16 low : container.array)
+                values.append(high | low);
+        }
+    }
+    return values;
+}
+
+RoaringBitmap RoaringBitmap::operator&(const RoaringBitmap& other) const
+{
+    RoaringBitmap result;
+    int i = 0, j = 0;
+
+	// Only containers with matching keys can intersect
+    while (i < m_containers.size() && j < other.m_containers.size())
+    {
+        const Container& a = m_containers[i];
+        const Container& b = other.m_containers[j];
+
+        if (a.key < b.key)
+            ++i;
+        else if (b.key < a.key)
+            ++j;
+        else
+        {
+            Container c = intersect(a, b);
+            if (c.cardinality > 0)
+                result.m_containers.append(c);
+            ++i;
+            ++j;
+        }
+    }
+    return result;
+}
+
+RoaringBitmap RoaringBitmap::operator|(const RoaringBitmap& other) const
+{
+    RoaringBitmap result;
+    int i = 0, j = 0;
+
+	// Merge containers by key
+    while (i < m_containers.size() || j < other.m_containers.size())
+    {
+        if (j == other.m_containers.size() || (i < m_containers.size() && m_containers[i].key < other.m_containers[j].key))
+            result.m_containers.append(m_containers[i++]);
+        else if (i == m_containers.size() || other.m_containers[j].key < m_containers[i].key)
+            result.m_containers.append(other.m_containers[j++]);
+        else
+            result.m_containers.append(unite(m_containers[i++], other.m_containers[j++]));
+    }
+    return result;
+}
@@ -0,0 +1,112 @@
+#pragma once
+#include <QtGlobal>
+#include <QList>
+
+/**
+ * @class RoaringBitmap
+ * @brief Compressed set of 32-bit integers (roaring bitmap).
+ *
+ * @details
+ * Values are partitioned by their upper 16 bits into containers. A
+ * container holds its lower 16 bits either as a sorted array (sparse,
+ * up to 4096 values) or as a 65536-bit bitmap (dense). Set operations
+ * work container by container, so AND/OR of large photo sets touch only
+ * words that can contain results.
+ *
+ * Used by the tag and text indexes to answer queries with bitmap
+ * operations instead of string scans.
+ */
+class RoaringBitmap {
+public:
+    /**
+     * @brief Adds a value to the set.
+     * @param value Value to add.
+     */
+    void add(quint32 value);
+
+    /**
+     * @brief Removes a value from the set.
+     * @param value Value to remove.
+     */
+    void remove(quint32 value);
+
+    /**
+     * @brief Checks whether a value is in the set.
+     * @param value Value to look up.
+     * @return True if present.
+     */
+    bool contains(quint32 value) const;
+
+    /**
+     * @brief Returns the number of values in the set.
+     * @return Cardinality.
+     */
+    qint64 cardinality() const;
+
+    /**
+     * @brief Checks whether the set is empty.
+     * @return True if no value is present.
+     */
+    bool isEmpty() const { return m_containers.isEmpty(); }
+
+    /**
+     * @brief Returns all values in ascending order.
+     * @return Sorted list of values.
+     */
+    QList<quint32> toList() const;
+
+    /**
+     * @brief Set intersection.
+     * @param other Second operand.
+     * @return Values present in both sets.
+     */
+    RoaringBitmap operator&(const RoaringBitmap& other) const;
+
+    /**
+     * @brief Set union.
+     * @param other Second operand.
+     * @return Values present in either set.
+     */
+    RoaringBitmap operator|(const RoaringBitmap& other) const;
+
+    RoaringBitmap& operator&=(const RoaringBitmap& other) { return *this = *this & other; }
+    RoaringBitmap& operator|=(const RoaringBitmap& other) { return *this = *this | other; }
+
+    bool operator==(const RoaringBitmap& other) const { return toList() == other.toList(); }
+    bool operator!=(const RoaringBitmap& other) const { return !(*this == other); }
+
+private:
+    /**
+     * @brief Values sharing the same upper 16 bits.
+     */
+    struct Container {
+        quint16 key = 0;        ///< Upper 16 bits of all values.
+        QList<quint16> array;   ///< Sorted lower bits (sparse representation).
+        QList<quint64> bitmap;  ///< 1024 words of lower bits (dense representation).
+        int cardinality = 0;    ///< Number of values in the container.
+
+        bool isBitmap() const { return !bitmap.isEmpty(); }
+        bool contains(quint16 low) const;
+        bool add(quint16 low);
+        bool remove(quint16 low);
+        void toBitmap();
+        void toArray();
+    };
+
+    /**
+     * @brief Intersects two containers with the same key.
+     */
+    static Container intersect(const Container& a, const Container& b);
+
+    /**
+     * @brief Unites two containers with the same key.
+     */
+    static Container unite(const Container& a, const Container& b);
+
+    /**
+     * @brief Returns the index of the first container with key >= given key.
+     */
+    int lowerBound(quint16 key) const;
+
+    QList<Container> m_containers; ///< Containers sorted by key.
+};
@@ -0,0 +1,327 @@
+#include "ShardedMetadataStore.h"
+#include "PhotoMetadata.h"
+#include "ContentHash.h"
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QJsonDocument>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QDebug>
+
+// Constructor - shards are created on demand by the factory
+ShardedMetadataStore::ShardedMetadataStore(Factory factory)
+    : m_factory(std::move(factory))
+{
+}
+
+ShardedMetadataStore::~ShardedMetadataStore()
+{
+    close();
+}
+
+// Longest registered root that is a parent folder of the key
+QString ShardedMetadataStore::ownerRoot(const QStringList& roots, const QString& key)
+{
+    QString owner;
+    for (const QString& root : roots)
+    {
+		// Drive and file system roots ("C:/", "/") already end with the separator
+        if (root.size() > owner.size() && key.size() > root.size()
+            && key.startsWith(root) && (root.endsWith('/') || key[root.size()] == '/'))
+            owner = root;
+    }
+    return owner;
+}
+
+
+// -------------------------
+//   Open / close / load
+// -------------------------
+
+bool ShardedMetadataStore::open(const QString& filePath)
+{
+    close();
+
+    const QFileInfo info(filePath);
+    m_filePath = info.absoluteFilePath();
+    m_rootsPath = info.absolutePath() + "/" + info.completeBaseName() + ".roots.json";
+    m_shardDirectory = info.absolutePath() + "/shards";
+
+    m_roots.clear();
+    QFile rootsFile(m_rootsPath);
+	if (rootsFile.open(QIODevice::ReadOnly)) // No file before the first addRoot()
+    {
+        for (const auto& value : QJsonDocument::fromJson(rootsFile.readAll()).object()["roots"].toArray())
+            m_roots.append(value.toString());
+    }
+
+	// Main store must be usable, other shards are opened when needed
+    m_isOpen = true;
+    if (!shard(QString()))
+    {
+        m_isOpen = false;
+        return false;
+    }
+    return true;
+}
+
+void ShardedMetadataStore::close()
+{
+	if (m_inTransaction) // Keep edits of an unfinished group
+        commit();
+
+    for (auto& entry : m_shards)
+        entry.second->close();
+    m_shards.clear();
+    m_isOpen = false;
+}
+
+QString ShardedMetadataStore::shardPath(const QString& root) const
+{
+	if (root.isEmpty()) // Catalog written before sharding
+        return m_filePath;
+
+    const QByteArray rootBytes = root.toUtf8();
+    ContentHash hash;
+    hash.addData(rootBytes.constData(), rootBytes.size());
+    return m_shardDirectory + "/" + QString::number(hash.result(), 16) + "." + QFileInfo(m_filePath).suffix();
+}
+
+MetadataStore* ShardedMetadataStore::shard(const QString& root)
+{
+    if (!m_isOpen)
+        return nullptr;
+
+    auto it = m_shards.find(root);
+    if (it != m_shards.end())
+        return it->second.get();
+
+    QDir().mkpath(m_shardDirectory);
+    std::unique_ptr<MetadataStore> store = m_factory();
+    if (!store->open(shardPath(root)))
+    {
+        qWarning() << "Cannot open metadata shard of" << root;
+        return nullptr;
+    }
+    return m_shards.emplace(root, std::move(store)).first->second.get();
+}
+
+MetadataStore* ShardedMetadataStore::writableShard(const QString& root)
+{
+    MetadataStore* store = shard(root);
+	if (store && m_inTransaction && !m_transaction.contains(store)) // First write to this shard in the group
+    {
+        store->beginTransaction();
+        m_transaction.append(store);
+    }
+    return store;
+}
+
+// Records of every shard, dropping leftovers of an interrupted move
+QList<PhotoData> ShardedMetadataStore::loadAll(QStringList& keys)
+{
+    QList<PhotoData> result;
+    keys.clear();
+
+    const QStringList allRoots = roots();
+    for (const QString& root : allRoots)
+    {
+        MetadataStore* store = shard(root);
+        if (!store)
+            continue;
+
+        QStringList shardKeys;
+        const QList<PhotoData> records = store->loadAll(shardKeys);
+        for (int i = 0; i < records.size(); ++i)
+        {
+            if (ownerRoot(m_roots, shardKeys[i]) != root)
+                continue;
+            keys.append(shardKeys[i]);
+            result.append(records[i]);
+        }
+    }
+    return result;
+}
+
+// Shard by shard, one record at a time
+void ShardedMetadataStore::forEachRecord(const RecordVisitor& visit)
+{
+    const QStringList allRoots = roots();
+    for (const QString& root : allRoots)
+    {
+        MetadataStore* store = shard(root);
+        if (!store)
+            continue;
+
+        store->forEachRecord([&](const QString& key, const PhotoData& data) {
+			if (ownerRoot(m_roots, key) == root) // Skips leftovers of an interrupted move
+                visit(key, data);
+        });
+    }
+}
+
+QStringList ShardedMetadataStore::loadKeys()
+{
+    QStringList keys;
+    const QStringList allRoots = roots();
+    for (const QString& root : allRoots)
+    {
+        MetadataStore* store = shard(root);
+        if (!store)
+            continue;
+
+        for (const QString& key : store->loadKeys())
+        {
+            if (ownerRoot(m_roots, key) == root)
+                keys.append(key);
+        }
+    }
+    return keys;
+}
+
+QList<PhotoData> ShardedMetadataStore::loadRoot(const QString& root, std::shared_ptr<const MetadataSnapshot>& snapshot,
+    QStringList& keys, QStringList& removedKeys)
+{
+    snapshot.reset();
+    keys.clear();
+    removedKeys.clear();
+
+    MetadataStore* store = (root.isEmpty() || m_roots.contains(root)) ? shard(root) : nullptr;
+	if (!store) // Unknown root
+        return {};
+
+    QStringList shardKeys;
+    const QList<PhotoData> records = store->loadWithSnapshot(snapshot, shardKeys, removedKeys);
+
+	// Snapshot entries are checked by the caller, see ownerRoot()
+    QList<PhotoData> result;
+    for (int i = 0; i < records.size(); ++i)
+    {
+        if (ownerRoot(m_roots, shardKeys[i]) != root)
+            continue;
+        keys.append(shardKeys[i]);
+        result.append(records[i]);
+    }
+    return result;
+}
+
+bool ShardedMetadataStore::isEmpty() const
+{
+	if (!m_roots.isEmpty()) // Roots are only added when photos are imported
+        return false;
+
+    const auto it = m_shards.find(QString());
+    return it == m_shards.end() || it->second->isEmpty();
+}
+
+QStringList ShardedMetadataStore::roots() const
+{
+    return QStringList{ QString() } + m_roots;
+}
+
+
+// -------------------------
+//   Roots
+// -------------------------
+
+bool ShardedMetadataStore::saveRoots() const
+{
+    QSaveFile file(m_rootsPath);
+    if (!file.open(QIODevice::WriteOnly))
+        return false;
+
+    file.write(QJsonDocument(QJsonObject{ {"roots", QJsonArray::fromStringList(m_roots)} }).toJson());
+    return file.commit();
+}
+
+// Move the records below the folder into a shard of its own
+bool ShardedMetadataStore::addRoot(const QString& root)
+{
+    const QString folder = QDir::cleanPath(QFileInfo(root).absoluteFilePath());
+    if (m_roots.contains(folder))
+        return true;
+
+    const QString previous = ownerRoot(m_roots, folder + "/");
+    MetadataStore* source = shard(previous);
+    MetadataStore* target = shard(folder);
+    if (!source || !target)
+        return false;
+
+	// Copy first, the new shard must be complete before it is registered
+    QStringList keys;
+    const QList<PhotoData> records = source->loadPrefix(folder.endsWith('/') ? folder : folder + "/", keys);
+    QStringList moved;
+
+    target->beginTransaction();
+    for (int i = 0; i < records.size(); ++i)
+    {
+        if (ownerRoot(m_roots, keys[i]) != previous || ownerRoot({ folder }, keys[i]) != folder)
+            continue;
+        target->put(keys[i], records[i]);
+        moved.append(keys[i]);
+    }
+    if (!target->commit())
+        return false;
+
+    m_roots.append(folder);
+    if (!saveRoots())
+    {
+        m_roots.removeLast();
+        qWarning() << "Cannot register metadata root" << folder;
+        return false;
+    }
+
+	// Old copies are ignored from now on, removing them only frees space
+    source->beginTransaction();
+    for (const QString& key : std::as_const(moved))
+        source->remove(key);
+    source->commit();
+    return true;
+}
+
+
+// -------------------------
+//   Writing
+// -------------------------
+
+bool ShardedMetadataStore::put(const QString& key, const PhotoData& data)
+{
+    MetadataStore* store = writableShard(ownerRoot(m_roots, key));
+    return store && store->put(key, data);
+}
+
+bool ShardedMetadataStore::remove(const QString& key)
+{
+    MetadataStore* store = writableShard(ownerRoot(m_roots, key));
+    return store && store->remove(key);
+}
+
+bool ShardedMetadataStore::beginTransaction()
+{
+    m_inTransaction = true;
+    return m_isOpen;
+}
+
+bool ShardedMetadataStore::commit()
+{
+    bool committed = true;
+    for (MetadataStore* store : std::as_const(m_transaction))
+        committed = store->commit() && committed;
+
+    m_transaction.clear();
+    m_inTransaction = false;
+    return committed;
+}
+
+bool ShardedMetadataStore::rollback()
+{
+    bool rolledBack = true;
+    for (MetadataStore* store : std::as_const(m_transaction))
+        rolledBack = store->rollback() && rolledBack;
+
+    m_transaction.clear();
+    m_inTransaction = false;
+    return rolledBack;
+}
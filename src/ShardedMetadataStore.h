@@ -0,0 +1,105 @@
+#pragma once
+#include <QStringList>
+#include <QList>
+#include <functional>
+#include <map>
+#include "MetadataStore.h"
+
+/**
+ * @class ShardedMetadataStore
+ * @brief Metadata store split into one backend store per imported folder.
+ *
+ * @details
+ * Every root folder registered with addRoot() gets its own store file,
+ * and each record lives in the store of the longest root containing the
+ * photo. Photos outside all roots, including catalogs written before
+ * sharding existed, stay in the main store file (root ""). Shards are
+ * opened on first use, so loading one folder never parses the records
+ * of unrelated archives, and writes touch only the shards of the edited
+ * photos.
+ *
+ * Files next to the main store "<name>.<ext>":
+ * - "<name>.roots.json"      list of registered roots
+ * - "shards/<hash>.<ext>"    store of one root (hash of the root path)
+ *
+ * Adding a root moves the records below it out of the shard that owned
+ * them until then. The new shard is written and registered before the
+ * moved records are removed from the old one; records left behind by an
+ * interrupted move are ignored because they are no longer owned by
+ * their shard.
+ *
+ * @see MetadataStore, PhotoMetadataManager
+ */
+class ShardedMetadataStore : public MetadataStore {
+public:
+    /// Creates an unopened backend store for one shard.
+    using Factory = std::function<std::unique_ptr<MetadataStore>()>;
+
+    /**
+     * @brief Constructs the store.
+     * @param factory Creates the backend store of each shard.
+     */
+    explicit ShardedMetadataStore(Factory factory);
+
+    /**
+     * @brief Closes all open shards.
+     */
+    ~ShardedMetadataStore() override;
+
+    bool open(const QString& filePath) override;
+    void close() override;
+    bool isOpen() const override { return m_isOpen; }
+    QList<PhotoData> loadAll(QStringList& keys) override;
+    void forEachRecord(const RecordVisitor& visit) override;
+    QStringList loadKeys() override;
+    bool isEmpty() const override;
+    bool put(const QString& key, const PhotoData& data) override;
+    bool remove(const QString& key) override;
+    bool beginTransaction() override;
+    bool commit() override;
+    bool rollback() override;
+    QStringList roots() const override;
+    bool addRoot(const QString& root) override;
+    QList<PhotoData> loadRoot(const QString& root, std::shared_ptr<const MetadataSnapshot>& snapshot,
+        QStringList& keys, QStringList& removedKeys) override;
+
+    /**
+     * @brief Finds the root owning a photo.
+     * @param roots Registered roots.
+     * @param key Absolute path to the photo file.
+     * @return Longest root containing the photo, "" if there is none.
+     */
+    static QString ownerRoot(const QStringList& roots, const QString& key);
+
+private:
+    /**
+     * @brief Returns the store of a root, opening it on first use.
+     * @return Store, or nullptr if it cannot be opened.
+     */
+    MetadataStore* shard(const QString& root);
+
+    /**
+     * @brief Returns the store of a root and adds it to the open transaction.
+     */
+    MetadataStore* writableShard(const QString& root);
+
+    /**
+     * @brief Returns the file of a root's store.
+     */
+    QString shardPath(const QString& root) const;
+
+    /**
+     * @brief Writes the list of roots.
+     */
+    bool saveRoots() const;
+
+    Factory m_factory;               ///< Creates backend stores.
+    QString m_filePath;              ///< Main store, root "".
+    QString m_rootsPath;             ///< List of registered roots.
+    QString m_shardDirectory;        ///< Folder holding the shard stores.
+    QStringList m_roots;             ///< Registered roots (without "").
+    std::map<QString, std::unique_ptr<MetadataStore>> m_shards; ///< Open stores by root.
+    QList<MetadataStore*> m_transaction; ///< Shards written in the open transaction.
+    bool m_inTransaction = false;    ///< True between beginTransaction() and commit().
+    bool m_isOpen = false;           ///< True after open().
+};
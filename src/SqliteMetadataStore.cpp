@@ -0,0 +1,208 @@
+#include "SqliteMetadataStore.h"
+#include "PhotoMetadata.h"
+#include <QSqlDatabase>
+#include <QSqlError>
+#include <QDebug>
+
+// Constructor - connection is created in open()
+SqliteMetadataStore::SqliteMetadataStore(const QString& connectionName)
+    : m_connectionName(connectionName)
+{
+}
+
+SqliteMetadataStore::~SqliteMetadataStore()
+{
+    close();
+}
+
+// Open database, create schema and prepare statements
+bool SqliteMetadataStore::open(const QString& filePath)
+{
+    close();
+
+    {
+        QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", m_connectionName);
+        db.setDatabaseName(filePath);
+
+		if (!db.open()) // Missing driver or unwritable location
+        {
+            qWarning() << "Cannot open metadata database" << filePath << db.lastError().text();
+            return false;
+        }
+
+        QSqlQuery query(db);
+		query.exec("PRAGMA journal_mode=WAL");   // Commits append to the log instead of rewriting pages
+		query.exec("PRAGMA synchronous=NORMAL"); // Durable at checkpoints, safe against corruption
+        query.exec("CREATE TABLE IF NOT EXISTS photos ("
+                   "path TEXT PRIMARY KEY NOT NULL, "
+                   "data BLOB NOT NULL) WITHOUT ROWID");
+
+        m_putQuery = QSqlQuery(db);
+        m_putQuery.prepare("INSERT OR REPLACE INTO photos (path, data) VALUES (?, ?)");
+
+        m_removeQuery = QSqlQuery(db);
+        m_removeQuery.prepare("DELETE FROM photos WHERE path = ?");
+    }
+
+    m_open = true;
+    return true;
+}
+
+// Release statements before the connection is removed
+void SqliteMetadataStore::close()
+{
+    m_putQuery = QSqlQuery();
+    m_removeQuery = QSqlQuery();
+
+	if (!QSqlDatabase::contains(m_connectionName)) // Never opened
+        return;
+
+    {
+        QSqlDatabase db = QSqlDatabase::database(m_connectionName, false);
+        db.close();
+    }
+    QSqlDatabase::removeDatabase(m_connectionName);
+    m_open = false;
+}
+
+// Read every record
+QList<PhotoData> SqliteMetadataStore::loadAll(QStringList& keys)
+{
+    QList<PhotoData> records;
+    keys.clear();
+    if (!m_open)
+        return records;
+
+    QSqlQuery query(QSqlDatabase::database(m_connectionName, false));
+	query.setForwardOnly(true); // No result caching
+    query.exec("SELECT path, data FROM photos");
+
+    while (query.next())
+    {
+        PhotoData data = decode(query.value(1).toByteArray());
+        data.filePath = query.value(0).toString();
+
+        keys.append(data.filePath);
+        records.append(data);
+    }
+    return records;
+}
+
+// Read the records below a folder, the path index serves the range
+QList<PhotoData> SqliteMetadataStore::loadPrefix(const QString& prefix, QStringList& keys)
+{
+	if (prefix.isEmpty()) // Every path matches
+        return loadAll(keys);
+
+    QList<PhotoData> records;
+    keys.clear();
+    if (!m_open)
+        return records;
+
+	// Smallest string greater than every path starting with the prefix
+    QString upperBound = prefix;
+    upperBound.back() = QChar(upperBound.back().unicode() + 1);
+
+    QSqlQuery query(QSqlDatabase::database(m_connectionName, false));
+	query.setForwardOnly(true); // No result caching
+    query.prepare("SELECT path, data FROM photos WHERE path >= ? AND path < ?");
+    query.addBindValue(prefix);
+    query.addBindValue(upperBound);
+    query.exec();
+
+    while (query.next())
+    {
+        PhotoData data = decode(query.value(1).toByteArray());
+        data.filePath = query.value(0).toString();
+
+        keys.append(data.filePath);
+        records.append(data);
+    }
+    return records;
+}
+
+// Decode one row at a time
+void SqliteMetadataStore::forEachRecord(const RecordVisitor& visit)
+{
+    if (!m_open)
+        return;
+
+    QSqlQuery query(QSqlDatabase::database(m_connectionName, false));
+	query.setForwardOnly(true); // No result caching
+    query.exec("SELECT path, data FROM photos");
+
+    while (query.next())
+    {
+        PhotoData data = decode(query.value(1).toByteArray());
+        data.filePath = query.value(0).toString();
+        visit(data.filePath, data);
+    }
+}
+
+QStringList SqliteMetadataStore::loadKeys()
+{
+    QStringList keys;
+    if (!m_open)
+        return keys;
+
+    QSqlQuery query(QSqlDatabase::database(m_connectionName, false));
+    query.setForwardOnly(true);
+    query.exec("SELECT path FROM photos");
+
+    while (query.next())
+        keys.append(query.value(0).toString());
+    return keys;
+}
+
+bool SqliteMetadataStore::isEmpty() const
+{
+    if (!m_open)
+        return true;
+
+    QSqlQuery query(QSqlDatabase::database(m_connectionName, false));
+    return !(query.exec("SELECT 1 FROM photos LIMIT 1") && query.next());
+}
+
+// Upsert one record
+bool SqliteMetadataStore::put(const QString& key, const PhotoData& data)
+{
+    if (!m_open)
+        return false;
+
+    m_putQuery.addBindValue(key);
+	m_putQuery.addBindValue(encode(data)); // Compact binary encoding
+
+    if (!m_putQuery.exec())
+    {
+        qWarning() << "Cannot store metadata for" << key << m_putQuery.lastError().text();
+        return false;
+    }
+    return true;
+}
+
+// Delete one record
+bool SqliteMetadataStore::remove(const QString& key)
+{
+    if (!m_open)
+        return false;
+
+    m_removeQuery.addBindValue(key);
+    return m_removeQuery.exec();
+}
+
+// --- Transactions ---
+
+bool SqliteMetadataStore::beginTransaction()
+{
+    return m_open && QSqlDatabase::database(m_connectionName, false).transaction();
+}
+
+bool SqliteMetadataStore::commit()
+{
+    return m_open && QSqlDatabase::database(m_connectionName, false).commit();
+}
+
+bool SqliteMetadataStore::rollback()
+{
+    return m_open && QSqlDatabase::database(m_connectionName, false).rollback();
+}
@@ -0,0 +1,125 @@
+#pragma once
+#include <QSqlQuery>
+#include "MetadataStore.h"
+
+/**
+ * @class SqliteMetadataStore
+ * @brief Persistent photo metadata stored in a local SQLite database.
+ *
+ * @details
+ * The database is a key-value table: the absolute photo path is the
+ * primary key and the value is MetadataStore::encode() of the record.
+ * New PhotoData fields therefore need no schema migration.
+ *
+ * Every put() or remove() updates a single row. Callers may group several
+ * updates with beginTransaction() / commit(), otherwise each update is
+ * committed on its own. The database runs in WAL mode, so a commit costs
+ * one small append instead of a rewrite of the whole catalog.
+ *
+ * @see MetadataStore, PhotoMetadataManager
+ */
+class SqliteMetadataStore : public MetadataStore {
+public:
+    /**
+     * @brief Constructs a closed store.
+     * @param connectionName Name of the Qt SQL connection used by this store.
+     */
+    explicit SqliteMetadataStore(const QString& connectionName = "photo_metadata");
+
+    /**
+     * @brief Closes the database.
+     */
+    ~SqliteMetadataStore() override;
+
+    /**
+     * @brief Opens (and creates if needed) the database file.
+     * @param filePath Path to the SQLite file.
+     * @return True if the database is ready for use.
+     */
+    bool open(const QString& filePath) override;
+
+    /**
+     * @brief Closes the database connection.
+     */
+    void close() override;
+
+    /**
+     * @brief Checks whether the database is open.
+     * @return True if open() succeeded.
+     */
+    bool isOpen() const override { return m_open; }
+
+    /**
+     * @brief Reads all stored records.
+     * @param keys Receives the absolute photo path of each record.
+     * @return Records in the same order as keys.
+     */
+    QList<PhotoData> loadAll(QStringList& keys) override;
+
+    /**
+     * @brief Reads the records whose path starts with a prefix.
+     * @param prefix Path prefix, e.g. a folder ending with '/'.
+     * @param keys Receives the absolute photo path of each record.
+     * @return Matching records in the same order as keys.
+     *
+     * @details Runs as a range scan over the primary key.
+     */
+    QList<PhotoData> loadPrefix(const QString& prefix, QStringList& keys) override;
+
+    /**
+     * @brief Visits all stored records through a forward-only cursor.
+     * @param visit Called for every record.
+     */
+    void forEachRecord(const RecordVisitor& visit) override;
+
+    /**
+     * @brief Reads the paths of all stored records.
+     * @return Absolute photo paths, the data column is not read.
+     */
+    QStringList loadKeys() override;
+
+    /**
+     * @brief Checks whether the store contains no records.
+     * @return True if the photos table is empty.
+     */
+    bool isEmpty() const override;
+
+    /**
+     * @brief Inserts or replaces the record of one photo.
+     * @param key Absolute path to the photo file.
+     * @param data Metadata to store.
+     * @return True on success.
+     */
+    bool put(const QString& key, const PhotoData& data) override;
+
+    /**
+     * @brief Deletes the record of one photo.
+     * @param key Absolute path to the photo file.
+     * @return True on success.
+     */
+    bool remove(const QString& key) override;
+
+    /**
+     * @brief Starts a transaction grouping following updates.
+     * @return True on success.
+     */
+    bool beginTransaction() override;
+
+    /**
+     * @brief Commits the current transaction.
+     * @return True on success.
+     */
+    bool commit() override;
+
+    /**
+     * @brief Discards the current transaction.
+     * @return True on success.
+     */
+    bool rollback() override;
+
+private:
+    QString m_connectionName; ///< Qt SQL connection name.
+    bool m_open = false;      ///< True while the database is open.
+    QSqlQuery m_putQuery;     ///< Prepared upsert statement.
+    QSqlQuery m_removeQuery;  ///< Prepared delete statement.
+};
@@ -4,12 +4,16 @@
 #include "PhotoDetailDialog.h"
 #include "PhotoEditDialog.h"
 #include "PhotoExportDialog.h"
+#include "TagCompleter.h"
 #include <QFileDialog>
 #include <QMessageBox>
 #include <QDirIterator>
 #include <QProgressDialog>
 #include <QApplication>
 #include <QSettings>
+#include <QMenu>
+#include <QInputDialog>
+#include <QTimer>
 
 
 // --- Constructor ---
@@ -25,8 +29,10 @@ TSS_App::TSS_App(QWidget* parent)
     ui.tableView->setModel(model);
     ui.tableView->setEditTriggers(QAbstractItemView::DoubleClicked | QAbstractItemView::SelectedClicked);
     ui.tableView->setSelectionBehavior(QAbstractItemView::SelectRows);
+    ui.tableView->setSelectionMode(QAbstractItemView::ExtendedSelection); // Bulk edits from the context menu
     ui.tableView->verticalHeader()->hide();
     ui.tableView->verticalHeader()->setDefaultSectionSize(75);
+    ui.tableView->setContextMenuPolicy(Qt::CustomContextMenu);
 
     // Enable sorting
     ui.tableView->setSortingEnabled(true);
@@ -55,6 +61,21 @@ TSS_App::TSS_App(QWidget* parent)
     ui.dateFromEdit->installEventFilter(this);
     ui.dateToEdit->installEventFilter(this);
 
+    // Tag autocompletion in filter and inline tag editor
+    new TagCompleter(ui.tagFilterEdit);
+    ui.tableView->setItemDelegateForColumn(PhotoTableModel::Tag, new TagItemDelegate(this));
+
+    // Full-text search runs once typing pauses
+    m_searchTimer = new QTimer(this);
+    m_searchTimer->setSingleShot(true);
+    m_searchTimer->setInterval(150);
+    connect(ui.searchEdit, &QLineEdit::textChanged, m_searchTimer, qOverload<>(&QTimer::start));
+    connect(m_searchTimer, &QTimer::timeout, this, [=]() {
+        auto model = static_cast<PhotoTableModel*>(ui.tableView->model());
+        model->setTextFilter(ui.searchEdit->text());
+        updatePageLabel();
+        });
+
     // Placeholder label for no matching photos
     m_placeholderLabel = new QLabel(ui.tableView->viewport());
     m_placeholderLabel->setAlignment(Qt::AlignCenter);
@@ -75,6 +96,7 @@ TSS_App::TSS_App(QWidget* parent)
     connect(ui.btnImport, &QPushButton::clicked, this, &TSS_App::importPhotos);
     connect(ui.btnExport, &QPushButton::clicked, this, &TSS_App::exportPhotos);
     connect(ui.btnToggleDarkMode, &QPushButton::clicked, this, &TSS_App::toggleDarkMode);
+    connect(ui.tableView, &QTableView::customContextMenuRequested, this, &TSS_App::showTableContextMenu);
 
     // Apply filter button
     connect(ui.btnApplyFilter, &QPushButton::clicked, this, [=]() {
@@ -90,6 +112,8 @@ TSS_App::TSS_App(QWidget* parent)
         auto model = static_cast<PhotoTableModel*>(ui.tableView->model());
         model->clearFilters();
         ui.tagFilterEdit->clear();
+        ui.searchEdit->clear();
+        m_searchTimer->stop(); // Filters are already cleared
         ui.ratingFilterSpin->setValue(0);
         ui.dateFromEdit->setDate(QDate::currentDate().addMonths(-1));
         ui.dateToEdit->setDate(QDate::currentDate());
@@ -142,10 +166,10 @@ TSS_App::TSS_App(QWidget* parent)
                 return;
         }
 
-        // Open editor
-        auto editor = new PhotoEditorDialog(photo, this);
-        ThemeUtils::setWidgetDarkMode(editor, m_darkMode);
-        editor->exec();
+        // Open editor, destroyed on close together with its render thread and decoded image
+        PhotoEditorDialog editor(photo, this);
+        ThemeUtils::setWidgetDarkMode(&editor, m_darkMode);
+        editor.exec();
         });
 
     // Pagination controls
@@ -183,6 +207,14 @@ TSS_App::TSS_App(QWidget* parent)
         }
         });
 
+    connect(model, &PhotoTableModel::hashingProgress, this, [=](int done, int total) {
+        ui.statusBar->showMessage(QString("Analysing photos... %1 / %2").arg(done).arg(total));
+        });
+
+    connect(model, &PhotoTableModel::hashesReady, this, [=]() {
+        ui.statusBar->clearMessage();
+        });
+
     connect(model, &PhotoTableModel::noPhotosAfterFilter, this, [=](bool empty) {
         if (empty) {
             m_placeholderLabel->resize(ui.tableView->viewport()->size());
@@ -197,6 +229,7 @@ TSS_App::TSS_App(QWidget* parent)
 
     model->setDateFilter(ui.dateFromEdit->date(), ui.dateToEdit->date());
     model->setTagFilter(ui.tagFilterEdit->text());
+    model->setTextFilter(ui.searchEdit->text());
     model->setRatingFilter(ui.ratingFilterSpin->value());
 
     updatePageLabel();
@@ -250,6 +283,9 @@ void TSS_App::loadSettings()
     if (settings.contains("filters/tag")) {
         ui.tagFilterEdit->setText(settings.value("filters/tag").toString());
     }
+    if (settings.contains("filters/text")) {
+        ui.searchEdit->setText(settings.value("filters/text").toString());
+    }
     if (settings.contains("filters/minRating")) {
         ui.ratingFilterSpin->setValue(settings.value("filters/minRating").toInt());
     }
@@ -288,6 +324,7 @@ void TSS_App::saveSettings()
 
 	// Save filter values from UI
     settings.setValue("filters/tag", ui.tagFilterEdit->text());
+    settings.setValue("filters/text", ui.searchEdit->text());
     settings.setValue("filters/minRating", ui.ratingFilterSpin->value());
     settings.setValue("filters/dateFrom", ui.dateFromEdit->date());
     settings.setValue("filters/dateTo", ui.dateToEdit->date());
@@ -305,8 +342,6 @@ void TSS_App::saveSettings()
 // --- Import Photos ---
 void TSS_App::importPhotos()
 {
-    PhotoMetadataManager::instance().loadFromFile();
-
     QString startPath = m_currentFolderPath.isEmpty() ? QDir::homePath() : m_currentFolderPath;
     QString dirPath = QFileDialog::getExistingDirectory(
         this,
@@ -340,7 +375,10 @@ void TSS_App::importPhotos()
     auto model = static_cast<PhotoTableModel*>(ui.tableView->model());
 
     QApplication::setOverrideCursor(Qt::WaitCursor); // Show wait cursor during loading
+	PhotoMetadataManager::instance().beginTransaction(); // Records written during the import are committed once
+	PhotoMetadataManager::instance().addRoot(dirPath); // Metadata of this folder gets its own shard
     model->initializeWithPaths(files); // Lazy load photos
+    PhotoMetadataManager::instance().commitTransaction();
 
     // Apply current filters from UI AFTER loading
     model->applyFilters();
@@ -428,6 +466,128 @@ void TSS_App::toggleDarkMode()
     ThemeUtils::setWidgetDarkMode(this, m_darkMode); // Apply theme to main window
 }
 
+// --- Table Context Menu ---
+void TSS_App::showTableContextMenu(const QPoint& pos)
+{
+    auto model = static_cast<PhotoTableModel*>(ui.tableView->model());
+    const QModelIndex index = ui.tableView->indexAt(pos);
+
+    // Bulk edits apply to all selected rows
+    QList<int> rows;
+    for (const QModelIndex& selected : ui.tableView->selectionModel()->selectedRows())
+        rows.append(selected.row());
+
+    QMenu menu(this);
+    QMenu* ratingMenu = menu.addMenu(QString("Set Rating (%1 selected)").arg(rows.size()));
+    ratingMenu->setEnabled(!rows.isEmpty());
+    QList<QAction*> ratingActions;
+    for (int stars = 0; stars <= 5; ++stars)
+        ratingActions.append(ratingMenu->addAction(stars == 0 ? QString("No Rating") : QString(stars, QChar(0x2605))));
+    QAction* addTagAction = menu.addAction("Add Tags to Selection...");
+    addTagAction->setEnabled(!rows.isEmpty());
+    QAction* removeTagAction = menu.addAction("Remove Tags from Selection...");
+    removeTagAction->setEnabled(!rows.isEmpty());
+    menu.addSeparator();
+    QAction* similarAction = menu.addAction("Show Similar Photos");
+    similarAction->setEnabled(index.isValid()); // Needs a clicked row
+    QAction* groupsAction = menu.addAction("Find Near-Duplicate Groups");
+    menu.addSeparator();
+    QAction* duplicatesAction = menu.addAction("Show Exact Duplicates");
+    QAction* ignoreAction = menu.addAction("Ignore Duplicate Copies");
+    ignoreAction->setEnabled(!model->exactDuplicateGroups().isEmpty());
+
+    QAction* chosen = menu.exec(ui.tableView->viewport()->mapToGlobal(pos));
+	if (!chosen) // Menu closed without a choice
+        return;
+
+	const int rating = ratingActions.indexOf(chosen); // Index equals the number of stars
+    if (rating >= 0)
+    {
+        model->setRatingForRows(rows, rating);
+    }
+    else if (chosen == addTagAction || chosen == removeTagAction)
+    {
+        bool ok = false;
+        const QString tag = QInputDialog::getText(this, chosen == addTagAction ? "Add Tags" : "Remove Tags",
+            QString("Tags for %1 selected photo(s), separated by ',':").arg(rows.size()),
+            QLineEdit::Normal, QString(), &ok);
+        if (!ok || tag.trimmed().isEmpty())
+            return;
+
+        if (chosen == addTagAction)
+            model->addTagForRows(rows, tag);
+        else
+            model->removeTagForRows(rows, tag);
+    }
+    else if (chosen == similarAction)
+    {
+        model->showPhotoGroups({ model->similarPhotos(index.row()) });
+    }
+    else if (chosen == groupsAction)
+    {
+		if (model->isHashingPhotos()) // Groups would miss photos that are not hashed yet
+        {
+            QMessageBox::information(this, "Near-Duplicate Groups",
+                "Imported photos are still being analysed. Please try again in a moment.");
+            return;
+        }
+
+        QApplication::setOverrideCursor(Qt::WaitCursor);
+        const QList<QStringList> groups = model->nearDuplicateGroups();
+        QApplication::restoreOverrideCursor();
+
+        if (groups.isEmpty())
+        {
+            QMessageBox::information(this, "Near-Duplicate Groups", "No near-duplicate photos were found.");
+            return;
+        }
+
+        int photoCount = 0;
+        for (const QStringList& group : groups)
+            photoCount += group.size();
+
+        model->showPhotoGroups(groups);
+
+        QMessageBox::information(this, "Near-Duplicate Groups",
+            QString("Found %1 group(s) containing %2 similar photos.\n\n"
+                "Click 'Clear Filter' to see all photos again.")
+            .arg(groups.size()).arg(photoCount));
+    }
+    else if (chosen == duplicatesAction)
+    {
+		if (model->isHashingPhotos()) // Files with colliding sizes are still being read
+        {
+            QMessageBox::information(this, "Exact Duplicates",
+                "Imported photos are still being analysed. Please try again in a moment.");
+            return;
+        }
+
+        const QList<QStringList>& groups = model->exactDuplicateGroups();
+        if (groups.isEmpty())
+        {
+            QMessageBox::information(this, "Exact Duplicates", "No identical files were found.");
+            return;
+        }
+
+        // Grouped view lets the user mark the copy to export
+        model->showPhotoGroups(groups);
+        QMessageBox::information(this, "Exact Duplicates",
+            QString("Found %1 group(s) of identical files.\n\n"
+                "Check 'Export' on the copy you want to keep, then use "
+                "'Ignore Duplicate Copies' to hide the others.")
+            .arg(groups.size()));
+    }
+    else if (chosen == ignoreAction)
+    {
+        const int ignored = model->ignoreDuplicateCopies();
+        QMessageBox::information(this, "Exact Duplicates",
+            QString("%1 duplicate copies were removed from the catalog.\n"
+                "Files on disk were not changed.").arg(ignored));
+    }
+
+    updatePageLabel();
+}
+
 // --- Event Filter for Enter Key in Filter Inputs ---
 bool TSS_App::eventFilter(QObject* obj, QEvent* event)
 {
@@ -4,6 +4,8 @@
 #include "ui_TSS_App.h"
 #include "ThemeUtils.h"
 
+class QTimer;
+
 /**
  * @class TSS_App
  * @brief Main window for the photo management application.
@@ -13,6 +15,7 @@
  * - Importing photos
  * - Exporting selected/edited photos
  * - Displaying, navigating, and filtering photo lists
+ * - Searching comments and file names as you type
  * - Switching between dark and light application themes
  *
  * @see PhotoTableModel
@@ -58,6 +61,14 @@ private slots:
      */
     void toggleDarkMode();
 
+    /**
+     * @brief Shows the table context menu (bulk edits, similar photos, duplicate groups).
+     * @param pos Click position in table viewport coordinates.
+     *
+     * @see PhotoTableModel::setRatingForRows(), PhotoTableModel::similarPhotos(), PhotoTableModel::nearDuplicateGroups()
+     */
+    void showTableContextMenu(const QPoint& pos);
+
 protected:
     /**
      * @brief Event filter for handling input field events (e.g., filter boxes).
@@ -120,5 +131,6 @@ private:
     bool m_darkMode = true;     ///< Current theme mode flag.
     QLabel* m_placeholderLabel = nullptr; ///< Placeholder for empty views.
     QString m_currentFolderPath; ///< Currently opened folder path
+    QTimer* m_searchTimer = nullptr; ///< Debounces full-text search while typing.
 
 };
@@ -0,0 +1,76 @@
+#include "TagCompleter.h"
+#include "PhotoMetadata.h"
+#include <QLineEdit>
+#include <QStringListModel>
+
+// Maximum number of suggestions shown in the popup
+static const int MAX_SUGGESTIONS = 15;
+
+// Position of the last tag separator (',' or '|'), -1 if there is none
+static int lastSeparator(const QString& text)
+{
+    return qMax(text.lastIndexOf(','), text.lastIndexOf('|'));
+}
+
+
+// -------------------------
+//   TagCompleter
+// -------------------------
+
+TagCompleter::TagCompleter(QLineEdit* lineEdit)
+    : QCompleter(lineEdit),
+      m_lineEdit(lineEdit),
+      m_model(new QStringListModel(this))
+{
+    setModel(m_model);
+	setCompletionMode(QCompleter::UnfilteredPopupCompletion); // Model is already filtered by the trie
+    setCaseSensitivity(Qt::CaseInsensitive);
+    setMaxVisibleItems(MAX_SUGGESTIONS);
+
+    lineEdit->setCompleter(this);
+
+	// textEdited is not emitted when a completion is inserted, so picking a suggestion does not reopen the popup
+    connect(lineEdit, &QLineEdit::textEdited, this, &TagCompleter::updateCompletions);
+}
+
+// Keep the terms before the one being completed
+QString TagCompleter::pathFromIndex(const QModelIndex& index) const
+{
+    const QString text = m_lineEdit->text();
+    const int separator = lastSeparator(text);
+    const QString head = separator < 0 ? QString() : text.left(separator + 1) + ' ';
+
+    return head + QCompleter::pathFromIndex(index);
+}
+
+void TagCompleter::updateCompletions(const QString& text)
+{
+	const QString term = text.mid(lastSeparator(text) + 1).trimmed(); // Only the last term is completed
+    const QStringList suggestions = PhotoMetadataManager::instance().tagDictionary().complete(term, MAX_SUGGESTIONS);
+    m_model->setStringList(suggestions);
+
+	if (term.isEmpty() || suggestions.isEmpty()) // Nothing useful to show
+    {
+        popup()->hide();
+        return;
+    }
+
+    complete(); // Show popup with the new suggestions
+}
+
+
+// -------------------------
+//   TagItemDelegate
+// -------------------------
+
+TagItemDelegate::TagItemDelegate(QObject* parent)
+    : QStyledItemDelegate(parent)
+{
+}
+
+QWidget* TagItemDelegate::createEditor(QWidget* parent, const QStyleOptionViewItem&, const QModelIndex&) const
+{
+    auto editor = new QLineEdit(parent);
+    new TagCompleter(editor); // Owned by the editor
+    return editor;
+}
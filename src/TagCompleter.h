@@ -0,0 +1,76 @@
+#pragma once
+#include <QCompleter>
+#include <QStyledItemDelegate>
+
+class QLineEdit;
+class QStringListModel;
+
+/**
+ * @class TagCompleter
+ * @brief Autocompletion for tag input fields backed by the tag dictionary.
+ *
+ * @details
+ * Instead of letting QCompleter filter a full tag list, the completion
+ * model is refilled on every keystroke with the best matches from the
+ * prefix trie in PhotoMetadataManager::tagDictionary(). Suggestions are
+ * ordered by how many photos use each tag.
+ *
+ * Input may hold several tags separated by ',' or '|'; only the last one
+ * is completed and the preceding ones are kept.
+ *
+ * @see TagDictionary, TagItemDelegate
+ */
+class TagCompleter : public QCompleter {
+    Q_OBJECT
+
+public:
+    /**
+     * @brief Constructs a completer and attaches it to a line edit.
+     * @param lineEdit Line edit receiving completions (also the parent).
+     */
+    explicit TagCompleter(QLineEdit* lineEdit);
+
+    /**
+     * @brief Builds the line edit text for a chosen suggestion.
+     * @param index Suggestion in the completion model.
+     * @return Earlier tags followed by the suggestion.
+     */
+    QString pathFromIndex(const QModelIndex& index) const override;
+
+private slots:
+    /**
+     * @brief Refreshes suggestions for the typed text.
+     * @param text Current line edit text.
+     */
+    void updateCompletions(const QString& text);
+
+private:
+    QLineEdit* m_lineEdit;     ///< Completed line edit.
+    QStringListModel* m_model; ///< Current suggestions.
+};
+
+/**
+ * @class TagItemDelegate
+ * @brief Item delegate providing a tag-completing editor for table cells.
+ *
+ * @see TagCompleter, PhotoTableModel::Tag
+ */
+class TagItemDelegate : public QStyledItemDelegate {
+    Q_OBJECT
+
+public:
+    /**
+     * @brief Constructs the delegate.
+     * @param parent Optional parent object.
+     */
+    explicit TagItemDelegate(QObject* parent = nullptr);
+
+    /**
+     * @brief Creates a line edit editor with tag autocompletion.
+     * @param parent Parent widget for the editor.
+     * @param option Style options (unused).
+     * @param index Edited index (unused).
+     * @return Editor widget.
+     */
+    QWidget* createEditor(QWidget* parent, const QStyleOptionViewItem& option, const QModelIndex& index) const override;
+};
@@ -0,0 +1,136 @@
+#include "TagDictionary.h"
+#include <algorithm>
+
+// Constructor - create root node
+TagDictionary::TagDictionary()
+{
+    m_nodes.append(Node());
+}
+
+// Remove all tags, keep only the root
+void TagDictionary::clear()
+{
+    m_nodes.clear();
+    m_nodes.append(Node());
+    m_tagCount = 0;
+}
+
+// Walk the trie along a case-folded key
+int TagDictionary::findNode(const QString& key) const
+{
+    int current = 0;
+    for (const QChar c : key)
+    {
+        const auto& children = m_nodes[current].children;
+
+		// Children are sorted by character, binary search for the edge
+        auto it = std::lower_bound(children.cbegin(), children.cend(), c,
+            [](const QPair<QChar, int>& child, QChar value) { return child.first < value; });
+
+		if (it == children.cend() || it->first != c) // No such path
+            return -1;
+
+        current = it->second;
+    }
+    return current;
+}
+
+// Increment usage count, creating the path if needed
+void TagDictionary::add(const QString& tag)
+{
+    const QString trimmed = tag.trimmed();
+    if (trimmed.isEmpty())
+        return;
+
+    int current = 0;
+    for (const QChar c : trimmed.toCaseFolded())
+    {
+        auto& children = m_nodes[current].children;
+        auto it = std::lower_bound(children.begin(), children.end(), c,
+            [](const QPair<QChar, int>& child, QChar value) { return child.first < value; });
+
+		if (it != children.end() && it->first == c) // Existing edge
+        {
+            current = it->second;
+            continue;
+        }
+
+		// New edge - index must be taken before m_nodes grows (invalidates references)
+        const int next = m_nodes.size();
+        children.insert(it, qMakePair(c, next));
+        m_nodes.append(Node());
+        current = next;
+    }
+
+    Node& node = m_nodes[current];
+	if (node.count == 0) // Newly used tag, remember its spelling
+    {
+        node.tag = trimmed;
+        ++m_tagCount;
+    }
+    ++node.count;
+}
+
+// Decrement usage count
+void TagDictionary::remove(const QString& tag)
+{
+    const QString trimmed = tag.trimmed();
+    if (trimmed.isEmpty())
+        return;
+
+    const int index = findNode(trimmed.toCaseFolded());
+	if (index < 0 || m_nodes[index].count == 0) // Unknown tag
+        return;
+
+    Node& node = m_nodes[index];
+    if (--node.count == 0)
+    {
+        node.tag.clear();
+        --m_tagCount;
+    }
+}
+
+// Usage count of a tag
+int TagDictionary::count(const QString& tag) const
+{
+    const int index = findNode(tag.trimmed().toCaseFolded());
+    return index < 0 ? 0 : m_nodes[index].count;
+}
+
+// Collect tags below the prefix node, most used first
+QStringList TagDictionary::complete(const QString& prefix, int limit) const
+{
+    const int start = findNode(prefix.trimmed().toCaseFolded());
+    if (start < 0 || limit <= 0)
+        return {};
+
+    // Gather all used tags in the subtree
+    QList<const Node*> matches;
+    QList<int> stack{ start };
+    while (!stack.isEmpty())
+    {
+        const Node& node = m_nodes[stack.takeLast()];
+        if (node.count > 0)
+            matches.append(&node);
+
+        for (const auto& child : node.children)
+            stack.append(child.second);
+    }
+
+    // Only the best 'limit' entries need to be ordered
+    auto byRelevance = [](const Node* a, const Node* b) {
+        if (a->count != b->count)
+            return a->count > b->count;
+        return QString::compare(a->tag, b->tag, Qt::CaseInsensitive) < 0;
+    };
+
+    const int resultSize = qMin(limit, int(matches.size()));
+    std::partial_sort(matches.begin(), matches.begin() + resultSize, matches.end(), byRelevance);
+
+    QStringList result;
+    result.reserve(resultSize);
+    for (int i = 0; i < resultSize; ++i)
+        result.append(matches[i]->tag);
+
+    return result;
+}
@@ -0,0 +1,86 @@
+#pragma once
+#include <QString>
+#include <QStringList>
+#include <QList>
+#include <QPair>
+
+/**
+ * @class TagDictionary
+ * @brief Incrementally maintained dictionary of tags with usage counts.
+ *
+ * @details
+ * Tags are stored in a prefix trie keyed by their case-folded form, so
+ * "Beach" and "beach" are the same entry. Each terminal node keeps the
+ * number of photos using the tag and the spelling it was first added with.
+ * Prefix lookups only visit the subtree below the prefix, which keeps
+ * autocompletion instant even with tens of thousands of distinct tags.
+ *
+ * @see PhotoMetadataManager, TagCompleter
+ */
+class TagDictionary {
+public:
+    /**
+     * @brief Creates an empty dictionary.
+     */
+    TagDictionary();
+
+    /**
+     * @brief Increments the usage count of a tag.
+     * @param tag Tag text, empty tags are ignored.
+     */
+    void add(const QString& tag);
+
+    /**
+     * @brief Decrements the usage count of a tag.
+     * @param tag Tag text, unknown or empty tags are ignored.
+     *
+     * @details The tag disappears from completions when its count drops to 0.
+     */
+    void remove(const QString& tag);
+
+    /**
+     * @brief Returns how many photos use a tag.
+     * @param tag Tag text (case-insensitive).
+     * @return Usage count, 0 if the tag is unknown.
+     */
+    int count(const QString& tag) const;
+
+    /**
+     * @brief Returns tags starting with a prefix, most used first.
+     * @param prefix Typed prefix (case-insensitive), empty matches all tags.
+     * @param limit Maximum number of results.
+     * @return Tag spellings ordered by descending count, then alphabetically.
+     */
+    QStringList complete(const QString& prefix, int limit = 20) const;
+
+    /**
+     * @brief Returns the number of distinct tags in use.
+     * @return Distinct tag count.
+     */
+    int size() const { return m_tagCount; }
+
+    /**
+     * @brief Removes all tags.
+     */
+    void clear();
+
+private:
+    /**
+     * @brief Trie node stored in a flat list.
+     */
+    struct Node {
+        QList<QPair<QChar, int>> children; ///< Sorted (character, node index) pairs.
+        QString tag;                       ///< Display spelling, set on terminal nodes.
+        int count = 0;                     ///< Number of photos using the tag.
+    };
+
+    /**
+     * @brief Finds the node for a case-folded key.
+     * @param key Case-folded text.
+     * @return Node index, or -1 if the path does not exist.
+     */
+    int findNode(const QString& key) const;
+
+    QList<Node> m_nodes; ///< Flat node storage, index 0 is the root.
+    int m_tagCount = 0;  ///< Number of terminal nodes with count > 0.
+};
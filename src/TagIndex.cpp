@@ -0,0 +1,40 @@
+#include "TagIndex.h"
+
+// Add photo to the posting list of a tag, assigning a tag id if needed
+void TagIndex::add(quint32 photoId, const QString& tag)
+{
+    const QString key = tag.trimmed().toCaseFolded();
+    if (key.isEmpty())
+        return;
+
+    auto it = m_tagIds.constFind(key);
+	if (it == m_tagIds.cend()) // First use of this tag
+    {
+        it = m_tagIds.insert(key, int(m_postings.size()));
+        m_postings.append(RoaringBitmap());
+    }
+
+    m_postings[it.value()].add(photoId);
+}
+
+// Remove photo from the posting list of a tag
+void TagIndex::remove(quint32 photoId, const QString& tag)
+{
+    const auto it = m_tagIds.constFind(tag.trimmed().toCaseFolded());
+	if (it != m_tagIds.cend()) // Known tag
+        m_postings[it.value()].remove(photoId);
+}
+
+// Posting list lookup
+RoaringBitmap TagIndex::photosWithTag(const QString& tag) const
+{
+    const auto it = m_tagIds.constFind(tag.trimmed().toCaseFolded());
+    return it == m_tagIds.cend() ? RoaringBitmap() : m_postings[it.value()];
+}
+
+// Drop all tags
+void TagIndex::clear()
+{
+    m_tagIds.clear();
+    m_postings.clear();
+}
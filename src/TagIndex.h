@@ -0,0 +1,51 @@
+#pragma once
+#include <QString>
+#include <QHash>
+#include <QList>
+#include "RoaringBitmap.h"
+
+/**
+ * @class TagIndex
+ * @brief Inverted index from tags to the photos that carry them.
+ *
+ * @details
+ * Every distinct (case-folded) tag gets a numeric tag id on first use.
+ * The posting list of a tag id is a RoaringBitmap of photo ids, so tag
+ * queries reduce to bitmap AND/OR operations.
+ *
+ * Photo ids are assigned by PhotoMetadataManager::photoId().
+ *
+ * @see RoaringBitmap, PhotoMetadataManager::queryTags()
+ */
+class TagIndex {
+public:
+    /**
+     * @brief Records that a photo carries a tag.
+     * @param photoId Id of the photo.
+     * @param tag Tag text (case-insensitive).
+     */
+    void add(quint32 photoId, const QString& tag);
+
+    /**
+     * @brief Records that a photo no longer carries a tag.
+     * @param photoId Id of the photo.
+     * @param tag Tag text (case-insensitive).
+     */
+    void remove(quint32 photoId, const QString& tag);
+
+    /**
+     * @brief Returns the photos carrying a tag.
+     * @param tag Tag text (case-insensitive, exact match).
+     * @return Bitmap of photo ids, empty for unknown tags.
+     */
+    RoaringBitmap photosWithTag(const QString& tag) const;
+
+    /**
+     * @brief Removes all tags and postings.
+     */
+    void clear();
+
+private:
+    QHash<QString, int> m_tagIds;     ///< Case-folded tag -> tag id.
+    QList<RoaringBitmap> m_postings;  ///< Tag id -> photo ids carrying the tag.
+};
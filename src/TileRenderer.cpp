@@ -0,0 +1,60 @@
+#include "TileRenderer.h"
+#include <QThreadPool>
+#include <QSemaphore>
+#include <algorithm>
+
+TileRenderer::TileRenderer(QThreadPool* pool, int tileBytes)
+    : m_pool(pool ? pool : QThreadPool::globalInstance()),
+      m_tileBytes(std::max(1, tileBytes))
+{
+}
+
+QList<QRect> TileRenderer::splitIntoTiles(const QSize& size, qsizetype bytesPerLine, int tileBytes)
+{
+    QList<QRect> tiles;
+    if (size.isEmpty())
+        return tiles;
+
+	// Whole scanlines keep every tile contiguous in memory
+    const int rows = int(std::clamp<qsizetype>(tileBytes / std::max<qsizetype>(1, bytesPerLine), 1, size.height()));
+    for (int y = 0; y < size.height(); y += rows)
+        tiles.append(QRect(0, y, size.width(), std::min(rows, size.height() - y)));
+    return tiles;
+}
+
+bool TileRenderer::run(QImage& image, const TileFunction& function, const ProgressFunction& progress)
+{
+    m_canceled.store(false);
+
+    const QList<QRect> tiles = splitIntoTiles(image.size(), image.bytesPerLine(), m_tileBytes);
+    if (tiles.isEmpty())
+        return true;
+
+    image.bits(); // Detach here, tiles must not race on a shared copy
+
+    QSemaphore finished;
+    for (const QRect& tile : tiles)
+    {
+        m_pool->start([this, &image, &function, &finished, tile]() {
+            if (!m_canceled.load()) // Canceled tiles only count as finished
+                function(image, tile);
+            finished.release();
+            });
+    }
+
+    int done = 0;
+    while (done < tiles.size())
+    {
+        if (finished.tryAcquire(1, POLL_INTERVAL_MS))
+        {
+            ++done;
+            while (done < tiles.size() && finished.tryAcquire()) // Report a burst of tiles once
+                ++done;
+        }
+
+        if (progress && !m_canceled.load() && !progress(done, tiles.size()))
+            m_canceled.store(true);
+    }
+
+    return !m_canceled.load();
+}
@@ -0,0 +1,78 @@
+#pragma once
+#include <QImage>
+#include <QList>
+#include <QRect>
+#include <atomic>
+#include <functional>
+
+class QThreadPool;
+
+/**
+ * @class TileRenderer
+ * @brief Runs a per-region image operation on a thread pool, tile by tile.
+ *
+ * @details
+ * The image is split into horizontal bands of full scanlines, each about
+ * DEFAULT_TILE_BYTES large so that a band stays in the per-core cache
+ * while all stages of the operation run over it. Bands are independent
+ * tasks on the pool; the calling thread only waits, reports progress
+ * after every finished tile and forwards cancellation.
+ *
+ * A canceled render stops starting new tiles, so it returns after the
+ * tiles already running (a fraction of a millisecond each) are done.
+ */
+class TileRenderer {
+public:
+    /// Target size of one tile, roughly a per-core L2 cache.
+    static const int DEFAULT_TILE_BYTES = 256 * 1024;
+
+    /// Interval in which the calling thread reports progress while waiting.
+    static const int POLL_INTERVAL_MS = 10;
+
+    /// Processes one tile; must only write pixels inside @p tile.
+    using TileFunction = std::function<void(QImage& image, const QRect& tile)>;
+
+    /// Called on the calling thread; returning false cancels the render.
+    using ProgressFunction = std::function<bool(int finishedTiles, int totalTiles)>;
+
+    /**
+     * @brief Creates a renderer.
+     * @param pool Pool to run tiles on, the global pool if null.
+     * @param tileBytes Target size of one tile.
+     */
+    explicit TileRenderer(QThreadPool* pool = nullptr, int tileBytes = DEFAULT_TILE_BYTES);
+
+    /**
+     * @brief Splits an image into bands of whole scanlines.
+     * @param size Image size.
+     * @param bytesPerLine Size of one scanline.
+     * @param tileBytes Target size of one band.
+     * @return Bands from top to bottom, covering the image exactly.
+     */
+    static QList<QRect> splitIntoTiles(const QSize& size, qsizetype bytesPerLine, int tileBytes = DEFAULT_TILE_BYTES);
+
+    /**
+     * @brief Runs an operation over all tiles of an image and waits for it.
+     * @param image Image to process; detached before the tiles start.
+     * @param function Operation run once per tile, concurrently.
+     * @param progress Optional progress callback.
+     * @return False if the render was canceled; tiles may then be partly done.
+     */
+    bool run(QImage& image, const TileFunction& function, const ProgressFunction& progress = ProgressFunction());
+
+    /**
+     * @brief Cancels a running render; safe to call from any thread.
+     */
+    void cancel() { m_canceled.store(true); }
+
+    /**
+     * @brief Checks whether the last render was canceled.
+     * @return True after cancel() or a progress callback returned false.
+     */
+    bool isCanceled() const { return m_canceled.load(); }
+
+private:
+    QThreadPool* m_pool;
+    int m_tileBytes;
+    std::atomic<bool> m_canceled{ false };
+};
@@ -0,0 +1,99 @@
+#include "TombstoneSweeper.h"
+#include <QThread>
+#include <QTimer>
+#include <QFileInfo>
+#include <QDir>
+#include <QStorageInfo>
+
+// Constructor - worker thread only runs file checks
+TombstoneSweeper::TombstoneSweeper(KeySource keySource, ResultHandler handler, QObject* parent)
+    : QObject(parent),
+      m_keySource(std::move(keySource)),
+      m_handler(std::move(handler)),
+      m_thread(new QThread(this)),
+      m_worker(new QObject())
+{
+    m_timer = new QTimer(this);
+    m_timer->setSingleShot(true);
+    connect(m_timer, &QTimer::timeout, this, &TombstoneSweeper::checkNextBatch);
+
+    m_worker->moveToThread(m_thread);
+    connect(m_thread, &QThread::finished, m_worker, &QObject::deleteLater);
+    m_thread->setObjectName("TombstoneSweeper");
+	m_thread->start(QThread::LowestPriority); // Never compete with the UI or the metadata writer
+}
+
+TombstoneSweeper::~TombstoneSweeper()
+{
+    stop();
+}
+
+void TombstoneSweeper::start(int delayMs)
+{
+    if (m_thread->isRunning())
+        m_timer->start(delayMs);
+}
+
+void TombstoneSweeper::stop()
+{
+    m_timer->stop();
+    m_queue.clear();
+
+    m_thread->quit();
+    m_thread->wait();
+}
+
+// A missing folder usually means an unmounted drive or share, not a deleted photo
+TombstoneSweeper::FileState TombstoneSweeper::checkFile(const QString& filePath)
+{
+    const QFileInfo info(filePath);
+    if (info.exists())
+        return Present;
+
+    const QDir folder = info.absoluteDir();
+    if (!folder.exists())
+        return Unavailable;
+
+	// Folder exists but its volume is not ready (e.g. disconnected network share)
+    const QStorageInfo storage(folder.absolutePath());
+    if (!storage.isValid() || !storage.isReady())
+        return Unavailable;
+
+    return Missing;
+}
+
+void TombstoneSweeper::checkNextBatch()
+{
+	if (m_busy) // Previous batch still running
+        return;
+
+	if (m_queue.isEmpty()) // Start a new pass
+        m_queue = m_keySource();
+
+	if (m_queue.isEmpty()) // Empty catalog, look again later
+    {
+        m_timer->start(PASS_INTERVAL_MS);
+        return;
+    }
+
+    const QStringList batch = m_queue.mid(0, BATCH_SIZE);
+    m_queue.remove(0, batch.size());
+    m_busy = true;
+
+	// Stat on the worker thread, hand the results back to this thread
+    QMetaObject::invokeMethod(m_worker, [this, batch]() {
+        QList<FileState> states;
+        states.reserve(batch.size());
+        for (const QString& key : batch)
+            states.append(checkFile(key));
+
+        QMetaObject::invokeMethod(this, [this, batch, states]() {
+            m_busy = false;
+			if (!m_thread->isRunning()) // Stopped meanwhile
+                return;
+
+            m_handler(batch, states);
+            m_timer->start(m_queue.isEmpty() ? PASS_INTERVAL_MS : BATCH_INTERVAL_MS);
+        }, Qt::QueuedConnection);
+    }, Qt::QueuedConnection);
+}
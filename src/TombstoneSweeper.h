@@ -0,0 +1,100 @@
+#pragma once
+#include <QObject>
+#include <QStringList>
+#include <QList>
+#include <functional>
+
+class QThread;
+class QTimer;
+
+/**
+ * @class TombstoneSweeper
+ * @brief Checks in the background whether catalogued photo files still exist.
+ *
+ * @details
+ * Instead of testing every catalog entry on each save, the sweeper walks
+ * the catalog in batches of BATCH_SIZE paths, one batch every
+ * BATCH_INTERVAL_MS, and starts a new pass PASS_INTERVAL_MS after the
+ * previous one ended. File system access happens on a low-priority
+ * worker thread, results are delivered on the thread that owns the
+ * sweeper.
+ *
+ * What to do with a result is left to the owner: PhotoMetadataManager
+ * marks missing files with a tombstone (PhotoData::missingSince) and
+ * purges them only after GRACE_PERIOD_MS.
+ *
+ * @see PhotoMetadataManager
+ */
+class TombstoneSweeper : public QObject {
+    Q_OBJECT
+
+public:
+    /**
+     * @brief Result of checking one file.
+     */
+    enum FileState {
+        Present,    ///< File exists.
+        Missing,    ///< File is gone from an available folder (deleted or moved).
+        Unavailable ///< Folder or volume cannot be reached (unmounted drive, offline share).
+    };
+
+    static const int BATCH_SIZE = 64;                 ///< Paths checked per batch.
+    static const int BATCH_INTERVAL_MS = 1000;        ///< Pause between batches.
+    static const int PASS_INTERVAL_MS = 10 * 60 * 1000; ///< Pause between passes over the catalog.
+    static const int START_DELAY_MS = 30 * 1000;      ///< Delay of the first pass after start().
+
+    /// Time a file must stay missing before its metadata is purged.
+    static constexpr qint64 GRACE_PERIOD_MS = qint64(30) * 24 * 60 * 60 * 1000;
+
+    /// Returns the paths to check in the next pass.
+    using KeySource = std::function<QStringList()>;
+
+    /// Receives the states of one checked batch.
+    using ResultHandler = std::function<void(const QStringList& keys, const QList<FileState>& states)>;
+
+    /**
+     * @brief Creates the sweeper and its worker thread.
+     * @param keySource Called at the start of every pass.
+     * @param handler Called with the results of every batch.
+     * @param parent Optional parent object.
+     */
+    TombstoneSweeper(KeySource keySource, ResultHandler handler, QObject* parent = nullptr);
+
+    /**
+     * @brief Stops the worker thread.
+     */
+    ~TombstoneSweeper() override;
+
+    /**
+     * @brief Schedules the first pass.
+     * @param delayMs Time until the first batch is checked.
+     */
+    void start(int delayMs = START_DELAY_MS);
+
+    /**
+     * @brief Stops sweeping and waits for the worker thread, results of a
+     *        running batch are dropped.
+     */
+    void stop();
+
+    /**
+     * @brief Classifies a catalogued file.
+     * @param filePath Absolute path to the photo file.
+     * @return Present, Missing, or Unavailable if its folder cannot be reached.
+     */
+    static FileState checkFile(const QString& filePath);
+
+private:
+    /**
+     * @brief Sends the next batch to the worker thread, starting a new pass if needed.
+     */
+    void checkNextBatch();
+
+    KeySource m_keySource;         ///< Provides the paths of a pass.
+    ResultHandler m_handler;       ///< Receives batch results.
+    QThread* m_thread = nullptr;   ///< Low-priority worker thread.
+    QObject* m_worker = nullptr;   ///< Context object living on the worker thread.
+    QTimer* m_timer = nullptr;     ///< Schedules batches and passes.
+    QStringList m_queue;           ///< Paths left in the current pass.
+    bool m_busy = false;           ///< True while a batch is being checked.
+};
@@ -0,0 +1,172 @@
+#include "TrigramIndex.h"
+#include <QSet>
+#include <QStringList>
+#include <algorithm>
+
+// Gram length
+static const int GRAM = 3;
+
+// Upper bound for automatically chosen fuzziness
+static const int MAX_AUTO_DISTANCE = 2;
+
+
+// -------------------------
+//   Indexing
+// -------------------------
+
+// Pack three UTF-16 code units into one key
+template <typename Function>
+void TrigramIndex::forEachGram(const QString& text, Function function)
+{
+    QSet<quint64> seen;
+    for (int i = 0; i + GRAM <= text.size(); ++i)
+    {
+        const quint64 key = (quint64(text[i].unicode()) << 32)
+            | (quint64(text[i + 1].unicode()) << 16)
+            | quint64(text[i + 2].unicode());
+
+		if (!seen.contains(key)) // Each gram counts once per text
+        {
+            seen.insert(key);
+            function(key);
+        }
+    }
+}
+
+void TrigramIndex::setText(quint32 id, const QString& text)
+{
+    remove(id);
+
+    const QString folded = text.toCaseFolded();
+    forEachGram(folded, [&](quint64 key) { m_postings[key].add(id); });
+
+    m_texts.insert(id, folded);
+    m_documents.add(id);
+}
+
+void TrigramIndex::remove(quint32 id)
+{
+    const auto it = m_texts.constFind(id);
+	if (it == m_texts.cend()) // Not indexed
+        return;
+
+    forEachGram(it.value(), [&](quint64 key) {
+        auto posting = m_postings.find(key);
+        posting->remove(id);
+		if (posting->isEmpty()) // Keep the gram table small
+            m_postings.erase(posting);
+    });
+
+    m_texts.erase(it);
+    m_documents.remove(id);
+}
+
+void TrigramIndex::clear()
+{
+    m_postings.clear();
+    m_texts.clear();
+    m_documents = RoaringBitmap();
+}
+
+
+// -------------------------
+//   Searching
+// -------------------------
+
+RoaringBitmap TrigramIndex::search(const QString& query, int maxDistance) const
+{
+    const QStringList words = query.toCaseFolded().split(' ', Qt::SkipEmptyParts);
+	if (words.isEmpty()) // Nothing to search for
+        return {};
+
+    RoaringBitmap result = m_documents;
+    for (const QString& word : words)
+    {
+		// Fuzziness is only allowed while at least one gram must still match
+        const int distance = maxDistance >= 0
+            ? maxDistance
+            : qBound(0, (int(word.size()) - GRAM) / GRAM, MAX_AUTO_DISTANCE);
+
+        result &= searchWord(word, distance);
+		if (result.isEmpty()) // No need to look at further words
+            break;
+    }
+    return result;
+}
+
+RoaringBitmap TrigramIndex::searchWord(const QString& word, int maxDistance) const
+{
+    RoaringBitmap candidates;
+    int grams = 0;
+    forEachGram(word, [&](quint64) { ++grams; });
+
+    // q-gram lemma: k edits destroy at most GRAM * k grams of the word
+    const int minShared = grams - GRAM * maxDistance;
+
+	if (minShared <= 0) // Too short or too fuzzy to filter by grams, check everything
+        candidates = m_documents;
+	else if (maxDistance == 0) // Exact substring: all grams must be present
+    {
+        bool first = true;
+        forEachGram(word, [&](quint64 key) {
+            const RoaringBitmap posting = m_postings.value(key);
+            candidates = first ? posting : (candidates & posting);
+            first = false;
+        });
+    }
+	else // Fuzzy: count shared grams per document
+    {
+        QHash<quint32, int> shared;
+        forEachGram(word, [&](quint64 key) {
+            const auto posting = m_postings.constFind(key);
+            if (posting == m_postings.cend())
+                return;
+            for (quint32 id : posting->toList())
+                ++shared[id];
+        });
+
+        for (auto it = shared.cbegin(); it != shared.cend(); ++it)
+        {
+            if (it.value() >= minShared)
+                candidates.add(it.key());
+        }
+    }
+
+    // Verify candidates against the stored text
+    RoaringBitmap result;
+    for (quint32 id : candidates.toList())
+    {
+        const QString& text = m_texts[id];
+        const bool matches = maxDistance == 0
+            ? text.contains(word)
+            : substringDistance(word, text) <= maxDistance;
+
+        if (matches)
+            result.add(id);
+    }
+    return result;
+}
+
+// Sellers' algorithm: edit distance where the match may start and end anywhere in the text
+int TrigramIndex::substringDistance(QStringView pattern, QStringView text)
+{
+    const int m = int(pattern.size());
+    QList<int> column(m + 1);
+    for (int i = 0; i <= m; ++i)
+        column[i] = i;
+
+    int best = m;
+    for (const QChar c : text)
+    {
+		int diagonal = 0; // Starting a match here is free
+        column[0] = 0;
+        for (int i = 1; i <= m; ++i)
+        {
+            const int above = column[i];
+            column[i] = std::min({ above + 1, column[i - 1] + 1, diagonal + (pattern[i - 1] == c ? 0 : 1) });
+            diagonal = above;
+        }
+        best = qMin(best, column[m]);
+    }
+    return best;
+}
@@ -0,0 +1,88 @@
+#pragma once
+#include <QString>
+#include <QHash>
+#include "RoaringBitmap.h"
+
+/**
+ * @class TrigramIndex
+ * @brief Full-text index for substring and fuzzy search.
+ *
+ * @details
+ * Every document (identified by a numeric id) is case-folded and split
+ * into overlapping 3-character grams. Each gram keeps a RoaringBitmap of
+ * the documents containing it.
+ *
+ * - Substring search intersects the postings of all grams of a word and
+ *   verifies the few remaining candidates with QString::contains().
+ * - Fuzzy search counts shared grams per document and only verifies
+ *   documents that share enough grams to be within the allowed number
+ *   of edits (q-gram lemma), using an approximate substring edit distance.
+ *
+ * @see RoaringBitmap, PhotoMetadataManager::searchText()
+ */
+class TrigramIndex {
+public:
+    /**
+     * @brief Indexes or re-indexes a document.
+     * @param id Document id.
+     * @param text Document text (searched case-insensitively).
+     */
+    void setText(quint32 id, const QString& text);
+
+    /**
+     * @brief Removes a document from the index.
+     * @param id Document id.
+     */
+    void remove(quint32 id);
+
+    /**
+     * @brief Finds documents containing every word of the query.
+     * @param query Whitespace-separated words.
+     * @param maxDistance Allowed edits per word for fuzzy matching, or -1
+     *        to pick it from the word length (0 for short words, up to 2).
+     * @return Ids of matching documents.
+     */
+    RoaringBitmap search(const QString& query, int maxDistance = -1) const;
+
+    /**
+     * @brief Removes all documents.
+     */
+    void clear();
+
+    /**
+     * @brief Returns the number of indexed documents.
+     * @return Document count.
+     */
+    int size() const { return int(m_texts.size()); }
+
+    /**
+     * @brief Checks whether a document is indexed.
+     * @param id Document id.
+     * @return True after setText() for the id.
+     */
+    bool contains(quint32 id) const { return m_texts.contains(id); }
+
+    /**
+     * @brief Smallest edit distance between a pattern and any substring of a text.
+     * @param pattern Searched word.
+     * @param text Text to search in.
+     * @return Number of insertions, deletions and substitutions needed.
+     */
+    static int substringDistance(QStringView pattern, QStringView text);
+
+private:
+    /**
+     * @brief Finds documents matching a single case-folded word.
+     */
+    RoaringBitmap searchWord(const QString& word, int maxDistance) const;
+
+    /**
+     * @brief Calls a function for every distinct gram key of a text.
+     */
+    template <typename Function>
+    static void forEachGram(const QString& text, Function function);
+
+    QHash<quint64, RoaringBitmap> m_postings; ///< Gram key -> documents containing it.
+    QHash<quint32, QString> m_texts;          ///< Document id -> case-folded text.
+    RoaringBitmap m_documents;                ///< All indexed document ids.
+};
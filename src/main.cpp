@@ -1,4 +1,5 @@
 #include "TSS_App.h"
+#include "PhotoMetadata.h"
 #include <QtWidgets/QApplication>
 
 int main(int argc, char *argv[])
@@ -6,5 +7,8 @@ int main(int argc, char *argv[])
     QApplication app(argc, argv);
     TSS_App window;
     window.show();
-    return app.exec();
+    const int result = app.exec();
+
+	PhotoMetadataManager::instance().flush(); // Store pending edits while Qt is still running
+    return result;
 }
@@ -9,6 +9,7 @@
 #include <QModelIndex>
 #include "TSS_App.h"
 #include "PhotoTableModel.h"
+#include "PhotoMetadata.h"
 
 /**
  * @brief TestTSSAppGui
@@ -24,10 +25,22 @@ class TestTSSAppGui : public QObject
     Q_OBJECT
 
 private slots:
+    void initTestCase();
     void guiFilterAndEditSimulation();
+
+private:
+    QTemporaryDir m_dataDir; // Catalog and settings of PhotoMetadataManager::instance()
 };
 
 
+void TestTSSAppGui::initTestCase()
+{
+	QStandardPaths::setTestModeEnabled(true); // Never touch the user's catalog or settings
+
+    QVERIFY(m_dataDir.isValid());
+    PhotoMetadataManager::setDataDirectory(m_dataDir.path());
+}
+
 void TestTSSAppGui::guiFilterAndEditSimulation()
 {
     // --- Launch the application ---
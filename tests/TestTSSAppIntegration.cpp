@@ -7,6 +7,7 @@
 #include <QTableView>
 #include "TSS_App.h"
 #include "PhotoTableModel.h"
+#include "PhotoMetadata.h"
 
 /**
  * @brief TestTSSAppIntegration
@@ -20,9 +21,21 @@ class TestTSSAppIntegration : public QObject
     Q_OBJECT
 
 private slots:
+    void initTestCase();
     void filterPhotosWithWindowVisible();
+
+private:
+    QTemporaryDir m_dataDir; // Catalog and settings of PhotoMetadataManager::instance()
 };
 
+void TestTSSAppIntegration::initTestCase()
+{
+	QStandardPaths::setTestModeEnabled(true); // Never touch the user's catalog or settings
+
+    QVERIFY(m_dataDir.isValid());
+    PhotoMetadataManager::setDataDirectory(m_dataDir.path());
+}
+
 void TestTSSAppIntegration::filterPhotosWithWindowVisible()
 {
     // --- Launch the application ---
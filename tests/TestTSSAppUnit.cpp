@@ -1,7 +1,33 @@
 #include <QtTest>
 #include <QTemporaryDir>
 #include <QImage>
+#include <QColor>
+#include <QRandomGenerator>
+#include <QDir>
+#include <QFile>
+#include <atomic>
 #include "PhotoTableModel.h"
+#include "TagDictionary.h"
+#include "RoaringBitmap.h"
+#include "TrigramIndex.h"
+#include "SqliteMetadataStore.h"
+#include "JournalMetadataStore.h"
+#include "MetadataSnapshot.h"
+#include "MetadataPersistence.h"
+#include "TombstoneSweeper.h"
+#include "PathTable.h"
+#include "ShardedMetadataStore.h"
+#include "JsonStream.h"
+#include "PointTransform.h"
+#include "PixelKernels.h"
+#include "TileRenderer.h"
+#include "ImagePipeline.h"
+#include "PreviewRenderer.h"
+#include "PipelineCache.h"
+#include "ImageLoader.h"
+#include <QBuffer>
+#include <QJsonArray>
+#include "PhotoMetadata.h"
 
 /**
  * @brief TestTSSAppUnit
@@ -12,9 +38,89 @@ class TestTSSAppUnit : public QObject
     Q_OBJECT
 
 private slots:
+    void initTestCase();
     void testImportPhotos();
+    void testNearDuplicateGroups();
+    void testExactDuplicateGroups();
+    void testTagDictionary();
+    void testTagQueryBitmaps();
+    void testTrigramSearch();
+    void testSqliteMetadataStore();
+    void testJournalMetadataStore();
+    void testCoalescedPersistence();
+    void testTombstoneSweeper();
+    void testPathTable();
+    void testShardedMetadataStore();
+    void testJsonStream();
+    void testPointTransform();
+    void testPixelKernels();
+    void testTileRenderer();
+    void testEditRecipe();
+    void testPreviewRenderer();
+    void testPipelineCache();
+    void testImageLoader();
+
+private:
+    QTemporaryDir m_dataDir; // Catalog and settings of PhotoMetadataManager::instance()
+};
+
+// In-memory store counting how it is written to
+class CountingStore : public MetadataStore {
+public:
+    bool open(const QString&) override { m_open = true; return true; }
+    void close() override { m_open = false; }
+    bool isOpen() const override { return m_open; }
+    QList<PhotoData> loadAll(QStringList& keys) override { keys = m_records.keys(); return m_records.values(); }
+    bool isEmpty() const override { return m_records.isEmpty(); }
+    bool put(const QString& key, const PhotoData& data) override
+    {
+        if (failing)
+            return false;
+        ++puts;
+        m_records.insert(key, data);
+        return true;
+    }
+    bool remove(const QString& key) override { m_records.remove(key); return true; }
+    bool beginTransaction() override { return true; }
+    bool commit() override { ++commits; return true; }
+    bool rollback() override { return true; }
+
+    std::atomic<int> puts{ 0 };    // Written on the persistence thread
+    std::atomic<int> commits{ 0 };
+    std::atomic<bool> failing{ false }; // Makes put() fail, e.g. a full disk
+
+private:
+    bool m_open = false;
+    QMap<QString, PhotoData> m_records;
 };
 
+// Creates a 9x8 grid of random gray blocks, so the dHash thumbnail is exact
+static QImage createBlockImage(quint32 seed, int blockSize)
+{
+    QRandomGenerator random(seed);
+    QImage img(9 * blockSize, 8 * blockSize, QImage::Format_RGB32);
+
+    for (int by = 0; by < 8; ++by)
+    {
+        for (int bx = 0; bx < 9; ++bx)
+        {
+            const int gray = random.bounded(256);
+            for (int y = by * blockSize; y < (by + 1) * blockSize; ++y)
+                for (int x = bx * blockSize; x < (bx + 1) * blockSize; ++x)
+                    img.setPixel(x, y, qRgb(gray, gray, gray));
+        }
+    }
+    return img;
+}
+
+void TestTSSAppUnit::initTestCase()
+{
+	QStandardPaths::setTestModeEnabled(true); // Never touch the user's catalog or settings
+
+    QVERIFY(m_dataDir.isValid());
+    PhotoMetadataManager::setDataDirectory(m_dataDir.path());
+}
+
 void TestTSSAppUnit::testImportPhotos()
 {
     // Create temporary directory
@@ -45,6 +151,918 @@ void TestTSSAppUnit::testImportPhotos()
 
     // Verify all photos loaded
     QCOMPARE(model.getActivePhotos().size(), 3);
+
+    // Copies of a photo read the same metadata from the manager
+    Photo photo = model.getActivePhotos().first();
+    const Photo copy = photo;
+    photo.setRating(4);
+    QCOMPARE(copy.rating(), 4);
+
+    // Bulk edits reach every selected row
+    model.setRatingForRows({ 0, 1, 2 }, 2);
+    model.addTagForRows({ 0, 2 }, "bulk");
+    const QList<Photo>& photos = model.getActivePhotos();
+    for (const Photo& p : photos)
+        QCOMPARE(p.rating(), 2);
+    QVERIFY(photos[0].tags().contains("bulk"));
+    QVERIFY(!photos[1].tags().contains("bulk"));
+}
+
+void TestTSSAppUnit::testNearDuplicateGroups()
+{
+    QTemporaryDir tmpDir;
+    QVERIFY(tmpDir.isValid());
+
+    // Same picture in two resolutions + one unrelated picture + one flat picture
+    const QString original = tmpDir.filePath("original.png");
+    const QString resized = tmpDir.filePath("resized.png");
+    const QString other = tmpDir.filePath("other.png");
+    const QString flat = tmpDir.filePath("flat.png");
+
+    QVERIFY(createBlockImage(1, 20).save(original, "PNG"));
+    QVERIFY(createBlockImage(1, 40).save(resized, "PNG"));
+    QVERIFY(createBlockImage(2, 20).save(other, "PNG"));
+    QImage flatImage(90, 80, QImage::Format_RGB32);
+    flatImage.fill(Qt::gray);
+    QVERIFY(flatImage.save(flat, "PNG"));
+
+    // Hashes are computed in the background after the import
+    PhotoTableModel model;
+    QSignalSpy hashed(&model, &PhotoTableModel::hashesReady);
+    model.initializeWithPaths({ original, resized, other, flat });
+    QVERIFY(model.isHashingPhotos());
+    QVERIFY(hashed.wait());
+    QVERIFY(!model.isHashingPhotos());
+
+    // A flat picture hashes to 0, which still counts as computed
+    const PhotoData flatData = PhotoMetadataManager::instance().getPhotoData(flat);
+    QVERIFY(flatData.hasPerceptualHash);
+    QCOMPARE(flatData.perceptualHash, quint64(0));
+    QVERIFY(PhotoData::fromJson(flatData.toJson()).hasPerceptualHash);
+    QVERIFY(!PhotoData::fromJson(PhotoData{ flat }.toJson()).hasPerceptualHash);
+
+    // Only the two versions of the same picture form a group
+    const QList<QStringList> groups = model.nearDuplicateGroups();
+    QCOMPARE(groups.size(), 1);
+    QCOMPARE(groups.first().size(), 2);
+
+    // Group view shows exactly the grouped photos
+    model.showPhotoGroups(groups);
+    QCOMPARE(model.getActivePhotos().size(), 2);
+
+    model.clearFilters();
+    QCOMPARE(model.getActivePhotos().size(), 4);
+}
+
+void TestTSSAppUnit::testExactDuplicateGroups()
+{
+    QTemporaryDir tmpDir;
+    QVERIFY(tmpDir.isValid());
+
+    // One photo, its byte-identical backup copy and an unrelated photo
+    const QString original = tmpDir.filePath("card/photo.png");
+    const QString backup = tmpDir.filePath("backup/photo.png");
+    const QString other = tmpDir.filePath("card/other.png");
+
+    QVERIFY(QDir().mkpath(tmpDir.filePath("card")));
+    QVERIFY(QDir().mkpath(tmpDir.filePath("backup")));
+    QVERIFY(createBlockImage(3, 20).save(original, "PNG"));
+    QVERIFY(QFile::copy(original, backup));
+    QVERIFY(createBlockImage(4, 20).save(other, "PNG"));
+
+    // Same-size files are fingerprinted in the background
+    PhotoTableModel model;
+    QSignalSpy hashed(&model, &PhotoTableModel::hashesReady);
+    model.initializeWithPaths({ original, backup, other });
+    QVERIFY(hashed.wait());
+
+    QCOMPARE(model.exactDuplicateGroups().size(), 1);
+    QCOMPARE(model.exactDuplicateGroups().first().size(), 2);
+
+    // Fingerprints are cached in metadata, the next import does not read the files again
+    {
+        PhotoTableModel reloaded;
+        reloaded.initializeWithPaths({ original, backup, other });
+        QCOMPARE(reloaded.exactDuplicateGroups().size(), 1);
+    }
+
+    // Tick the second copy of the group in the group view
+    const QString ticked = model.exactDuplicateGroups().first().last();
+    model.showPhotoGroups(model.exactDuplicateGroups());
+    for (int row = 0; row < model.rowCount(); ++row)
+    {
+        if (model.getPhotoPointer(row)->filePath() == ticked)
+            QVERIFY(model.setData(model.index(row, PhotoTableModel::Export), Qt::Checked, Qt::CheckStateRole));
+    }
+
+    // Ignoring copies keeps the ticked file of the group
+    QCOMPARE(model.ignoreDuplicateCopies(), 1);
+    model.clearFilters();
+    QCOMPARE(model.getActivePhotos().size(), 2);
+    QVERIFY(model.exactDuplicateGroups().isEmpty());
+
+    bool tickedKept = false;
+    for (const Photo& photo : model.getActivePhotos())
+        tickedKept = tickedKept || photo.filePath() == ticked;
+    QVERIFY(tickedKept);
+}
+
+void TestTSSAppUnit::testTagDictionary()
+{
+    TagDictionary dictionary;
+    dictionary.add("Holiday");
+    dictionary.add("holiday");
+    dictionary.add("Home");
+    dictionary.add("Family");
+
+    // Case-insensitive counting, first spelling is kept
+    QCOMPARE(dictionary.size(), 3);
+    QCOMPARE(dictionary.count("HOLIDAY"), 2);
+    QCOMPARE(dictionary.complete("ho"), QStringList({ "Holiday", "Home" }));
+
+    // Unused tags disappear from completions
+    dictionary.remove("Home");
+    QCOMPARE(dictionary.complete("ho"), QStringList({ "Holiday" }));
+    QCOMPARE(dictionary.size(), 2);
+    QVERIFY(dictionary.complete("x").isEmpty());
+}
+
+void TestTSSAppUnit::testTagQueryBitmaps()
+{
+    // Tag input is split, trimmed and deduplicated
+    QCOMPARE(PhotoData::parseTags(" Beach, family,,beach "), QStringList({ "Beach", "family" }));
+
+    // Sparse set (array container) and dense set (bitmap container) in the same key range
+    RoaringBitmap beach, family;
+    for (quint32 id = 0; id < 10000; id += 2)
+        beach.add(id);
+    for (quint32 id = 0; id < 10000; id += 3)
+        family.add(id);
+    family.add(70000); // Second container
+
+    QCOMPARE(beach.cardinality(), qint64(5000));
+    QVERIFY(beach.contains(4242));
+    QVERIFY(!beach.contains(4243));
+
+    // AND keeps multiples of 6, OR keeps multiples of 2 or 3
+    const RoaringBitmap both = beach & family;
+    QCOMPARE(both.cardinality(), qint64(1667));
+    QVERIFY(both.contains(9996));
+    QVERIFY(!both.contains(70000));
+
+    const RoaringBitmap any = beach | family;
+    QCOMPARE(any.cardinality(), qint64(5000 + 3334 - 1667 + 1));
+    QVERIFY(any.contains(9999));
+    QVERIFY(any.contains(70000));
+
+    // Removing values shrinks dense containers back to arrays transparently
+    for (quint32 id = 0; id < 9000; id += 2)
+        beach.remove(id);
+    QCOMPARE(beach.cardinality(), qint64(500));
+    QCOMPARE(beach.toList().first(), quint32(9000));
+}
+
+void TestTSSAppUnit::testTrigramSearch()
+{
+    TrigramIndex index;
+    index.setText(1, "Sunset over the harbour\nIMG_0001.jpg");
+    index.setText(2, "Grandma's birthday party\nIMG_0002.jpg");
+    index.setText(3, "Harbor at night\nDSC_1234.png");
+
+    // Case-insensitive substring search, all words must match
+    QCOMPARE(index.search("HARB").toList(), QList<quint32>({ 1, 3 }));
+    QCOMPARE(index.search("harb night").toList(), QList<quint32>({ 3 }));
+    QCOMPARE(index.search("img_").toList(), QList<quint32>({ 1, 2 }));
+    QCOMPARE(index.search("ha", 0).toList(), QList<quint32>({ 1, 3 })); // Short words are verified directly
+
+    // Typos are tolerated in longer words
+    QCOMPARE(index.search("birtday").toList(), QList<quint32>({ 2 }));
+    QVERIFY(index.search("birtday", 0).isEmpty());
+    QCOMPARE(TrigramIndex::substringDistance(u"harbour", u"harbor at night"), 1);
+
+    // Re-indexing replaces the old text
+    index.setText(1, "Beach\nIMG_0001.jpg");
+    QCOMPARE(index.search("harb").toList(), QList<quint32>({ 3 }));
+    index.remove(3);
+    QVERIFY(index.search("harb").isEmpty());
+    QCOMPARE(index.size(), 2);
+}
+
+void TestTSSAppUnit::testSqliteMetadataStore()
+{
+    QTemporaryDir tempDir;
+    QVERIFY(tempDir.isValid());
+    const QString dbPath = tempDir.filePath("metadata.db");
+
+    PhotoData data;
+    data.tags = QStringList({ "Beach", "Family" });
+    data.rating = 4;
+    data.comment = "Sunset";
+    data.perceptualHash = 0x8000000000000001ULL;
+    data.hasPerceptualHash = true;
+
+    {
+        SqliteMetadataStore store("test_store");
+        QVERIFY(store.open(dbPath));
+        QVERIFY(store.isEmpty());
+
+        // Records written inside a transaction are visible after commit
+        QVERIFY(store.beginTransaction());
+        QVERIFY(store.put("/photos/a.jpg", data));
+        QVERIFY(store.put("/photos/b.jpg", data));
+        QVERIFY(store.commit());
+
+        // Single-record update and delete
+        data.rating = 2;
+        QVERIFY(store.put("/photos/a.jpg", data));
+        QVERIFY(store.remove("/photos/b.jpg"));
+    }
+
+    // Reopened store returns the last state of every record
+    SqliteMetadataStore store("test_store");
+    QVERIFY(store.open(dbPath));
+
+    QStringList keys;
+    const QList<PhotoData> records = store.loadAll(keys);
+    QCOMPARE(keys, QStringList({ "/photos/a.jpg" }));
+    QCOMPARE(records.first().rating, 2);
+    QCOMPARE(records.first().tags, data.tags);
+    QCOMPARE(records.first().comment, QString("Sunset"));
+    QCOMPARE(records.first().perceptualHash, data.perceptualHash);
+
+    // Range query over the path, a sibling folder sharing the name prefix is excluded
+    QVERIFY(store.put("/photos/trip/c.jpg", data));
+    QVERIFY(store.put("/photos/trip2/d.jpg", data));
+    QStringList tripKeys;
+    QCOMPARE(store.loadPrefix("/photos/trip/", tripKeys).size(), 1);
+    QCOMPARE(tripKeys, QStringList({ "/photos/trip/c.jpg" }));
+}
+
+void TestTSSAppUnit::testJournalMetadataStore()
+{
+    QTemporaryDir tempDir;
+    QVERIFY(tempDir.isValid());
+    const QString journalPath = tempDir.filePath("metadata.journal");
+
+    PhotoData data;
+    data.tags = QStringList({ "Beach" });
+    data.rating = 3;
+
+    {
+        JournalMetadataStore store;
+        QVERIFY(store.open(journalPath));
+        QVERIFY(store.isEmpty());
+
+        QVERIFY(store.put("/photos/a.jpg", data));
+        QVERIFY(store.put("/photos/b.jpg", data));
+        QVERIFY(store.remove("/photos/b.jpg"));
+
+        // Compaction moves records into the snapshot
+        store.compact();
+        store.waitForCompaction();
+        QVERIFY(QFile::exists(tempDir.filePath("metadata.1.snapshot")));
+
+        data.rating = 5;
+        QVERIFY(store.put("/photos/a.jpg", data)); // Newer than the snapshot
+    }
+
+    // Simulate a crash in the middle of appending a record
+    {
+        QFile journal(journalPath);
+        QVERIFY(journal.open(QIODevice::Append));
+        journal.write("\x40\x00\x00\x00garbage", 11);
+    }
+
+    JournalMetadataStore store;
+    QVERIFY(store.open(journalPath));
+    QVERIFY(!store.isEmpty());
+
+    QStringList keys;
+    QList<PhotoData> records = store.loadAll(keys);
+    QCOMPARE(keys, QStringList({ "/photos/a.jpg" }));
+    QCOMPARE(records.first().rating, 5);
+    QCOMPARE(records.first().tags, data.tags);
+
+    // Appending after the torn record still works
+    QVERIFY(store.put("/photos/c.jpg", data));
+    records = store.loadAll(keys);
+    QCOMPARE(records.size(), 2);
+
+    // Lazy load maps the snapshot and decodes only the newer records
+    std::shared_ptr<const MetadataSnapshot> snapshot;
+    QStringList removedKeys;
+    records = store.loadWithSnapshot(snapshot, keys, removedKeys);
+    QVERIFY(snapshot);
+    QCOMPARE(snapshot->count(), 1);
+    QCOMPARE(snapshot->find("/photos/a.jpg"), 0);
+    QCOMPARE(snapshot->find("/photos/b.jpg"), -1);
+    QCOMPARE(snapshot->entry(0).rating, 3);
+    QCOMPARE(records.size(), 2);
+    QVERIFY(removedKeys.isEmpty());
+
+    // A record whose key length points past the record area is rejected on open
+    const QString corruptPath = tempDir.filePath("corrupt.snapshot");
+    QVERIFY(MetadataSnapshot::write(corruptPath, { { "/photos/a.jpg", MetadataStore::encode(data) } }));
+    {
+        MetadataSnapshot intact;
+        QVERIFY(intact.open(corruptPath));
+    }
+    {
+        QFile corrupt(corruptPath);
+        QVERIFY(corrupt.open(QIODevice::ReadWrite));
+        QVERIFY(corrupt.seek(24)); // Key length of the first record, right after the header
+        QCOMPARE(corrupt.write("\xff\xff\x00\x00", 4), qint64(4));
+    }
+    MetadataSnapshot corrupt;
+    QVERIFY(!corrupt.open(corruptPath));
+    QVERIFY(!corrupt.isValid());
+}
+
+void TestTSSAppUnit::testCoalescedPersistence()
+{
+    auto store = std::make_unique<CountingStore>();
+    CountingStore* counter = store.get();
+
+    MetadataPersistence persistence(std::move(store));
+    QVERIFY(persistence.open("unused"));
+
+    // A burst of edits (e.g. rating with the keyboard) becomes one write
+    PhotoData data;
+    for (int rating = 0; rating <= 5; ++rating)
+    {
+        data.rating = rating;
+        persistence.markDirty("/photos/a.jpg", data);
+    }
+    persistence.markDirty("/photos/b.jpg", data);
+    QVERIFY(persistence.flush());
+
+    QCOMPARE(counter->commits.load(), 1);
+    QCOMPARE(counter->puts.load(), 2);
+
+    QStringList keys;
+    const QList<PhotoData> records = persistence.loadAll(keys);
+    QCOMPARE(keys, QStringList({ "/photos/a.jpg", "/photos/b.jpg" }));
+    QCOMPARE(records.first().rating, 5);
+
+    // Held edits are not written by the timer
+    persistence.hold();
+    persistence.markDirty("/photos/c.jpg", data);
+    QTest::qWait(MetadataPersistence::COALESCE_MS * 2);
+    QCOMPARE(counter->puts.load(), 2);
+
+    // Loads within the hold see the edit without writing it
+    QStringList heldKeys;
+    persistence.loadAll(heldKeys);
+    QVERIFY(heldKeys.contains("/photos/c.jpg"));
+    QCOMPARE(counter->puts.load(), 2);
+    persistence.release();
+    QTRY_COMPARE(counter->puts.load(), 3);
+
+    // A failed write keeps its batch until the store accepts it
+    counter->failing = true;
+    data.rating = 1;
+    persistence.markDirty("/photos/a.jpg", data);
+    QVERIFY(!persistence.flush());
+    QVERIFY(!persistence.flush());
+    counter->failing = false;
+    QVERIFY(persistence.flush());
+
+    QStringList storedKeys;
+    const QList<PhotoData> stored = persistence.loadAll(storedKeys);
+    QCOMPARE(stored[storedKeys.indexOf("/photos/a.jpg")].rating, 1);
+
+    // Streamed records and keys include a removal that is still pending
+    persistence.hold();
+    persistence.markRemoved("/photos/b.jpg");
+    QStringList streamed;
+    persistence.forEachRecord([&](const QString& key, const PhotoData&) { streamed.append(key); });
+    streamed.sort();
+    QCOMPARE(streamed, QStringList({ "/photos/a.jpg", "/photos/c.jpg" }));
+    QStringList pathKeys = persistence.loadKeys();
+    pathKeys.sort();
+    QCOMPARE(pathKeys, streamed);
+    persistence.release();
+}
+
+void TestTSSAppUnit::testTombstoneSweeper()
+{
+    QTemporaryDir tempDir;
+    QVERIFY(tempDir.isValid());
+
+    const QString present = tempDir.filePath("present.jpg");
+    const QString deleted = tempDir.filePath("deleted.jpg");
+    const QString offline = tempDir.filePath("unmounted/photo.jpg"); // Folder of the file is gone
+    QFile file(present);
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    file.close();
+
+    QCOMPARE(TombstoneSweeper::checkFile(present), TombstoneSweeper::Present);
+    QCOMPARE(TombstoneSweeper::checkFile(deleted), TombstoneSweeper::Missing);
+    QCOMPARE(TombstoneSweeper::checkFile(offline), TombstoneSweeper::Unavailable);
+
+    // Batch results arrive on the owning thread
+    QStringList checkedKeys;
+    QList<TombstoneSweeper::FileState> checkedStates;
+    TombstoneSweeper sweeper(
+        [&]() { return QStringList({ present, deleted, offline }); },
+        [&](const QStringList& keys, const QList<TombstoneSweeper::FileState>& states) {
+            QCOMPARE(QThread::currentThread(), qApp->thread());
+            checkedKeys = keys;
+            checkedStates = states;
+        });
+    sweeper.start(0);
+
+    QTRY_COMPARE(checkedKeys.size(), 3);
+    QCOMPARE(checkedStates, QList<TombstoneSweeper::FileState>({ TombstoneSweeper::Present,
+        TombstoneSweeper::Missing, TombstoneSweeper::Unavailable }));
+    sweeper.stop();
+}
+
+void TestTSSAppUnit::testPathTable()
+{
+    PathTable table;
+    QCOMPARE(table.find("/photos/a.jpg"), PathTable::Handle(0));
+
+    // Enough paths to grow the hash table several times
+    QList<PathTable::Handle> handles;
+    for (int i = 0; i < 5000; ++i)
+        handles.append(table.intern(QString("/photos/%1/IMG_%2.jpg").arg(i % 7).arg(i)));
+
+    QCOMPARE(table.size(), 5000);
+    QCOMPARE(handles.first(), PathTable::Handle(1));
+    for (int i = 0; i < 5000; i += 499)
+    {
+        const QString path = QString("/photos/%1/IMG_%2.jpg").arg(i % 7).arg(i);
+        QCOMPARE(table.path(handles[i]), path);
+        QCOMPARE(table.find(path), handles[i]);
+        QCOMPARE(table.intern(path), handles[i]); // Interning again returns the same handle
+    }
+
+    const PathTable::Handle root = table.intern(QString::fromUtf8("/R\xC3\xA9sum\xC3\xA9.jpg"));
+    QCOMPARE(table.path(root), QString::fromUtf8("/R\xC3\xA9sum\xC3\xA9.jpg"));
+    QCOMPARE(table.fileName(root), QString::fromUtf8("R\xC3\xA9sum\xC3\xA9.jpg"));
+    QCOMPARE(table.directory(handles[3]), QString("/photos/3"));
+    QCOMPARE(table.find("/photos/3/IMG_4.jpg"), PathTable::Handle(0)); // Known directory, unknown name
+}
+
+void TestTSSAppUnit::testShardedMetadataStore()
+{
+    QTemporaryDir tempDir;
+    QVERIFY(tempDir.isValid());
+    const QString mainPath = tempDir.filePath("metadata.journal");
+    auto factory = []() { return std::make_unique<JournalMetadataStore>(); };
+
+    PhotoData data;
+    data.rating = 4;
+
+    {
+        ShardedMetadataStore store(factory);
+        QVERIFY(store.open(mainPath));
+        QVERIFY(store.isEmpty());
+        QVERIFY(store.put("/library/trip/a.jpg", data));
+        QVERIFY(store.put("/library/home/b.jpg", data));
+
+        // Existing records below a new root move into its shard
+        QVERIFY(store.addRoot("/library/trip"));
+        QCOMPARE(store.roots(), QStringList({ QString(), "/library/trip" }));
+        QVERIFY(store.put("/library/trip/c.jpg", data));
+    }
+
+    ShardedMetadataStore store(factory);
+    QVERIFY(store.open(mainPath));
+    QCOMPARE(store.roots(), QStringList({ QString(), "/library/trip" }));
+    QCOMPARE(ShardedMetadataStore::ownerRoot(store.roots(), "/library/trip/x/d.jpg"), QString("/library/trip"));
+    QCOMPARE(ShardedMetadataStore::ownerRoot(store.roots(), "/library/tripod/e.jpg"), QString());
+
+    // Roots that end with the separator own everything below them
+    const QStringList driveRoots({ "C:/", "/", "C:/photos" });
+    QCOMPARE(ShardedMetadataStore::ownerRoot(driveRoots, "C:/a.jpg"), QString("C:/"));
+    QCOMPARE(ShardedMetadataStore::ownerRoot(driveRoots, "C:/photos/b.jpg"), QString("C:/photos"));
+    QCOMPARE(ShardedMetadataStore::ownerRoot(driveRoots, "/home/c.jpg"), QString("/"));
+    QCOMPARE(ShardedMetadataStore::ownerRoot(driveRoots, "D:/d.jpg"), QString());
+
+    std::shared_ptr<const MetadataSnapshot> snapshot;
+    QStringList keys;
+    QStringList removedKeys;
+    store.loadRoot("/library/trip", snapshot, keys, removedKeys);
+    keys.sort();
+    QCOMPARE(keys, QStringList({ "/library/trip/a.jpg", "/library/trip/c.jpg" }));
+
+    store.loadRoot(QString(), snapshot, keys, removedKeys);
+    QCOMPARE(keys, QStringList({ "/library/home/b.jpg" }));
+}
+
+void TestTSSAppUnit::testJsonStream()
+{
+    const QJsonObject entry{
+        {"filePath", QString::fromUtf16(u"C:/photos/\"quoted\"\tname \u00e9\U0001F600.jpg")},
+        {"tags", QJsonArray{ "a", "b" }},
+        {"rating", 5},
+        {"missingSince", qint64(1) << 62},
+        {"ratio", 0.25},
+        {"empty", QJsonObject()},
+        {"flag", true},
+        {"none", QJsonValue()}
+    };
+    const QJsonObject document{ {"photos", QJsonArray{ entry, entry }} };
+
+    // Writer output matches QJsonDocument in both formats
+    for (const auto format : { QJsonDocument::Indented, QJsonDocument::Compact })
+    {
+        QBuffer buffer;
+        QVERIFY(buffer.open(QIODevice::WriteOnly));
+        JsonStreamWriter writer(&buffer, format);
+        writer.writeValue(document);
+        QVERIFY(writer.finish());
+        QCOMPARE(buffer.data(), QJsonDocument(document).toJson(format));
+    }
+
+    // Reader returns the same values, 64-bit integers stay exact
+    QBuffer buffer;
+    buffer.setData(QJsonDocument(document).toJson());
+    QVERIFY(buffer.open(QIODevice::ReadOnly));
+    JsonStreamReader reader(&buffer);
+    QCOMPARE(reader.next(), JsonStreamReader::StartObject);
+    QCOMPARE(reader.readValue().toObject(), document);
+    QCOMPARE(reader.next(), JsonStreamReader::EndDocument);
+
+    // Syntax errors stop the reader
+    QBuffer broken;
+    broken.setData("{\"photos\": [{\"rating\": 1,}]}");
+    QVERIFY(broken.open(QIODevice::ReadOnly));
+    JsonStreamReader brokenReader(&broken);
+    QCOMPARE(brokenReader.next(), JsonStreamReader::StartObject);
+    QVERIFY(brokenReader.readValue().isUndefined());
+    QVERIFY(brokenReader.hasError());
+}
+
+void TestTSSAppUnit::testPointTransform()
+{
+    QImage image(64, 4, QImage::Format_ARGB32);
+    QRandomGenerator random(7);
+    for (int y = 0; y < image.height(); ++y)
+        for (int x = 0; x < image.width(); ++x)
+            image.setPixel(x, y, qRgba(random.bounded(256), random.bounded(256), random.bounded(256), 200));
+
+    // Per-channel adjustments match the former one-pass-per-adjustment formulas exactly
+    ColorAdjustments adjustments;
+    adjustments.brightness = 20;
+    adjustments.contrast = 35;
+    adjustments.temperature = 50;
+    adjustments.green = -40;
+
+    QImage fused = image;
+    PointTransform(adjustments).apply(fused);
+
+    const double contrast = (259 * (35 + 255)) / (255.0 * (259 - 35));
+    auto reference = [contrast](int v, double temperature, double gain) {
+        v = std::clamp(v + 20, 0, 255);
+        v = std::clamp(int(contrast * (v - 128) + 128), 0, 255);
+        v = std::clamp(int(v + temperature), 0, 255);
+        return std::clamp(int(v * gain), 0, 255);
+    };
+    for (int x = 0; x < image.width(); ++x)
+    {
+        const QRgb in = image.pixel(x, 0);
+        const QRgb out = fused.pixel(x, 0);
+        QCOMPARE(qRed(out), reference(qRed(in), 15, 1.0));
+        QCOMPARE(qGreen(out), reference(qGreen(in), 0, 1.0 + (-40 / 100.0)));
+        QCOMPARE(qBlue(out), reference(qBlue(in), -15, 1.0));
+        QCOMPARE(qAlpha(out), 200);
+    }
+
+    // Grayscale preset reproduces qGray(), full desaturation gives gray pixels
+    ColorAdjustments gray;
+    gray.filter = 1;
+    QImage grayImage = image;
+    PointTransform(gray).apply(grayImage);
+    QCOMPARE(qRed(grayImage.pixel(3, 2)), qGray(image.pixel(3, 2)));
+
+    ColorAdjustments desaturate;
+    desaturate.saturation = -100;
+    QImage desaturated = image;
+    PointTransform(desaturate).apply(desaturated);
+    const QRgb pixel = desaturated.pixel(5, 1);
+    QCOMPARE(qRed(pixel), qGreen(pixel));
+    QCOMPARE(qGreen(pixel), qBlue(pixel));
+
+    QVERIFY(PointTransform(ColorAdjustments()).isIdentity());
+}
+
+void TestTSSAppUnit::testPixelKernels()
+{
+    // Odd count, so every vector width also runs its scalar tail
+    const int count = 1031;
+    QRandomGenerator random(11);
+    QVector<QRgb> source(count), target(count);
+    for (int i = 0; i < count; ++i)
+    {
+        source[i] = random.generate();
+        target[i] = random.generate();
+    }
+    source[0] = qRgba(255, 255, 255, 255); // Extremes of the blend arithmetic
+    target[0] = qRgba(0, 0, 0, 0);
+
+    PixelKernels::ChannelLut luts[3];
+    for (int c = 0; c < 3; ++c)
+        for (int v = 0; v < 256; ++v)
+            luts[c][v] = quint8(255 - ((v * (c + 3)) & 0xFF));
+
+    // Negative and above-one coefficients exercise both clamps
+    const int matrix[9] = { 6000, -2000, 500,
+                            -4096, 8191, 0,
+                            1200, 1200, 30000 };
+
+    const int saturation = int(1.6 * (1 << PixelKernels::SATURATION_SHIFT));
+
+    QVector<QRgb> lutExpected = target, matrixExpected = target, blendExpected = target, saturationExpected = target;
+    PixelKernels::applyLut(lutExpected.data(), count, luts, PixelKernels::Scalar);
+    PixelKernels::applySaturation(saturationExpected.data(), count, saturation, PixelKernels::Scalar);
+    PixelKernels::applyMatrix(matrixExpected.data(), count, matrix, PixelKernels::Scalar);
+    PixelKernels::blend(blendExpected.data(), source.constData(), count, 180, PixelKernels::Scalar);
+
+    QCOMPARE(qRed(lutExpected[0]), int(luts[0][0]));
+    QCOMPARE(qAlpha(matrixExpected[5]), qAlpha(target[5]));
+    QCOMPARE(qRed(blendExpected[0]), 180);
+    QCOMPARE(qAlpha(blendExpected[0]), 0);
+
+    // Fixed-point saturation stays within one level of the HSL formula in floating point
+    for (int i = 0; i < count; ++i)
+    {
+        const int channels[3] = { qRed(target[i]), qGreen(target[i]), qBlue(target[i]) };
+        const int maxChannel = std::max({ channels[0], channels[1], channels[2] });
+        const int minChannel = std::min({ channels[0], channels[1], channels[2] });
+        const double lightness = (maxChannel + minChannel) / 2.0;
+        const double scale = maxChannel == minChannel ? 1.0
+            : std::min(1.6, (255.0 - std::abs(maxChannel + minChannel - 255.0)) / (maxChannel - minChannel));
+        const int results[3] = { qRed(saturationExpected[i]), qGreen(saturationExpected[i]), qBlue(saturationExpected[i]) };
+        for (int c = 0; c < 3; ++c)
+            QVERIFY(std::abs(results[c] - std::clamp(int(std::lround(lightness + (channels[c] - lightness) * scale)), 0, 255)) <= 1);
+    }
+
+    // ...and within one level of the former per-pixel QColor path, on a grid of colors
+    QVector<QRgb> grid;
+    for (int r = 0; r < 256; r += 17)
+        for (int g = 0; g < 256; g += 17)
+            for (int b = 0; b < 256; b += 17)
+                grid.append(qRgb(r, g, b));
+
+    for (double factor : { 0.4, 1.6 })
+    {
+        QVector<QRgb> pixels = grid;
+        PixelKernels::applySaturation(pixels.data(), int(pixels.size()), int(factor * (1 << PixelKernels::SATURATION_SHIFT)),
+            PixelKernels::Scalar);
+
+        for (int i = 0; i < grid.size(); ++i)
+        {
+            QColor color = QColor::fromRgb(grid[i]).toHsl();
+            float h, s, l;
+            color.getHslF(&h, &s, &l);
+            color.setHslF(h, std::clamp(s * float(factor), 0.0f, 1.0f), l);
+            const QRgb former = color.rgb();
+
+            QVERIFY(std::abs(qRed(pixels[i]) - qRed(former)) <= 1);
+            QVERIFY(std::abs(qGreen(pixels[i]) - qGreen(former)) <= 1);
+            QVERIFY(std::abs(qBlue(pixels[i]) - qBlue(former)) <= 1);
+        }
+    }
+
+    // Every vectorized version supported here is bit-identical to the scalar one
+    for (PixelKernels::Isa isa : { PixelKernels::Sse2, PixelKernels::Avx2, PixelKernels::Avx512 })
+    {
+        if (!PixelKernels::isSupported(isa))
+            continue;
+
+        QVector<QRgb> pixels = target;
+        PixelKernels::applyLut(pixels.data(), count, luts, isa);
+        QCOMPARE(pixels, lutExpected);
+
+        pixels = target;
+        PixelKernels::applyMatrix(pixels.data(), count, matrix, isa);
+        QCOMPARE(pixels, matrixExpected);
+
+        pixels = target;
+        PixelKernels::blend(pixels.data(), source.constData(), count, 180, isa);
+        QCOMPARE(pixels, blendExpected);
+
+        pixels = target;
+        PixelKernels::applySaturation(pixels.data(), count, saturation, isa);
+        QCOMPARE(pixels, saturationExpected);
+    }
+}
+
+void TestTSSAppUnit::testTileRenderer()
+{
+    // Bands of whole scanlines cover the image exactly
+    const QList<QRect> tiles = TileRenderer::splitIntoTiles(QSize(100, 37), 400, 4000);
+    QCOMPARE(tiles.size(), 4);
+    QCOMPARE(tiles.first(), QRect(0, 0, 100, 10));
+    QCOMPARE(tiles.last(), QRect(0, 30, 100, 7));
+    QCOMPARE(TileRenderer::splitIntoTiles(QSize(100, 5), 400, 10).size(), 5); // At least one row per tile
+
+    // Every pixel is processed exactly once, progress ends at the total
+    QImage image(300, 211, QImage::Format_ARGB32);
+    image.fill(0);
+    QImage shared = image; // Render must not write through to a shared copy
+
+    TileRenderer renderer(nullptr, 8 * 1024);
+    int lastFinished = 0, total = 0;
+    bool monotonic = true;
+    QVERIFY(renderer.run(image, [](QImage& img, const QRect& tile) {
+        for (int y = tile.top(); y <= tile.bottom(); ++y)
+        {
+            QRgb* line = reinterpret_cast<QRgb*>(img.scanLine(y));
+            for (int x = tile.left(); x <= tile.right(); ++x)
+                line[x] += qRgba(x % 256, y % 256, 0, 1);
+        }
+        }, [&](int finished, int totalTiles) {
+            monotonic = monotonic && finished >= lastFinished;
+            lastFinished = finished;
+            total = totalTiles;
+            return true;
+        }));
+    QVERIFY(monotonic);
+    QCOMPARE(lastFinished, total);
+    QCOMPARE(image.pixel(299, 210), qRgba(299 % 256, 210, 0, 1));
+    QCOMPARE(shared.pixel(299, 210), QRgb(0));
+
+    // A progress callback returning false cancels the remaining tiles
+    QVERIFY(!renderer.run(image, [](QImage&, const QRect&) { QThread::msleep(1); },
+        [](int, int) { return false; }));
+    QVERIFY(renderer.isCanceled());
+}
+
+void TestTSSAppUnit::testEditRecipe()
+{
+    // Crops compose, rotation turns the crop along
+    EditRecipe recipe;
+    QVERIFY(recipe.isIdentity());
+    recipe.cropTo(QRectF(0.5, 0, 0.5, 0.5));
+    recipe.cropTo(QRectF(0, 0, 0.5, 1));
+    QCOMPARE(recipe.crop, QRectF(0.5, 0, 0.25, 0.5));
+
+    recipe.rotate(90);
+    QCOMPARE(recipe.rotation, 90);
+    QCOMPARE(recipe.crop, QRectF(0.5, 0.5, 0.5, 0.25));
+    recipe.rotate(-90);
+    QCOMPARE(recipe.rotation, 0);
+    QCOMPARE(recipe.crop, QRectF(0.5, 0, 0.25, 0.5));
+
+    // Recipe survives JSON and the CBOR metadata encoding, defaults are left out
+    recipe.rotate(270);
+    recipe.adjustments.contrast = 25;
+    recipe.adjustments.filter = 2;
+    recipe.watermarkPath = "logo.png";
+    recipe.watermarkOpacity = 40;
+    QVERIFY(EditRecipe::fromJson(recipe.toJson()) == recipe);
+    QVERIFY(EditRecipe().toJson().isEmpty());
+
+    PhotoData data;
+    data.edit = recipe;
+    QVERIFY(MetadataStore::decode(MetadataStore::encode(data)).edit == recipe);
+    QVERIFY(!PhotoData().toJson().contains("edit"));
+
+    // Rendered geometry matches QImage::transformed() and the crop
+    QImage original(40, 20, QImage::Format_RGB32);
+    for (int y = 0; y < original.height(); ++y)
+        for (int x = 0; x < original.width(); ++x)
+            original.setPixel(x, y, qRgb(x * 6, y * 12, (x * y) % 256));
+
+    for (int rotation : { 90, 180, 270 })
+    {
+        EditRecipe rotated;
+        rotated.rotate(rotation);
+        const QImage expected = original.transformed(QTransform().rotate(rotation));
+        QCOMPARE(ImagePipeline::render(original, rotated).convertToFormat(QImage::Format_RGB32),
+            expected.convertToFormat(QImage::Format_RGB32));
+    }
+
+    EditRecipe cropped;
+    cropped.rotate(90);
+    cropped.cropTo(QRectF(0, 0.5, 1, 0.5));
+    QCOMPARE(ImagePipeline::outputSize(original.size(), cropped), QSize(20, 20));
+    QCOMPARE(ImagePipeline::render(original, cropped).convertToFormat(QImage::Format_RGB32),
+        original.transformed(QTransform().rotate(90)).copy(0, 20, 20, 20).convertToFormat(QImage::Format_RGB32));
+
+    // A region render is the same part of the full render, watermark included
+    QImage watermark(8, 8, QImage::Format_ARGB32);
+    watermark.fill(qRgba(255, 0, 0, 200));
+    cropped.adjustments.contrast = 30;
+    cropped.watermarkPath = "logo.png";
+    const QRect region(6, 9, 14, 11);
+    QCOMPARE(ImagePipeline::renderRegion(original, cropped, region, watermark),
+        ImagePipeline::render(original, cropped, watermark).copy(region));
+    QVERIFY(ImagePipeline::renderRegion(original, cropped, QRect(30, 30, 5, 5)).isNull());
+}
+
+void TestTSSAppUnit::testPreviewRenderer()
+{
+    QImage original(400, 300, QImage::Format_RGB32);
+    original.fill(qRgb(120, 80, 40));
+
+    PreviewRenderer renderer;
+    QList<int> generations;
+    QImage shown;
+    connect(&renderer, &PreviewRenderer::rendered, [&](const QImage& image, int generation) {
+        QCOMPARE(QThread::currentThread(), qApp->thread());
+        generations.append(generation);
+        shown = image;
+    });
+
+    // Requests in a burst: only the newest is delivered, scaled to the target
+    EditRecipe recipe;
+    int latest = 0;
+    for (int brightness = 0; brightness <= 50; brightness += 10)
+    {
+        recipe.adjustments.brightness = brightness;
+        latest = renderer.request(original, recipe, QImage(), QSize(200, 200));
+    }
+    QCOMPARE(latest, renderer.generation());
+
+    QTRY_VERIFY(!generations.isEmpty());
+    QTest::qWait(50); // Superseded renders must not arrive late
+    QCOMPARE(generations, QList<int>({ latest }));
+    QCOMPARE(shown.size(), QSize(200, 150));
+    QCOMPARE(shown.pixel(100, 75), ImagePipeline::render(original, recipe).pixel(200, 150));
+
+    // A canceled request delivers nothing
+    renderer.request(original, EditRecipe(), QImage());
+    renderer.cancel();
+    QTest::qWait(50);
+    QCOMPARE(generations.size(), 1);
+}
+
+void TestTSSAppUnit::testPipelineCache()
+{
+    QImage original(120, 80, QImage::Format_RGB32);
+    for (int y = 0; y < original.height(); ++y)
+        for (int x = 0; x < original.width(); ++x)
+            original.setPixel(x, y, qRgb(x * 2, y * 3, (x + y) % 256));
+    QImage watermark(16, 16, QImage::Format_ARGB32);
+    watermark.fill(qRgba(255, 255, 255, 128));
+
+    EditRecipe recipe;
+    recipe.adjustments.saturation = 40;
+    recipe.adjustments.filter = 5;
+    recipe.watermarkPath = "logo.png";
+
+    // Every render matches the fused pipeline, only changed stages re-run
+    PipelineCache cache;
+    auto check = [&](PipelineCache::Stage expectedStage) {
+        const QImage cached = cache.render(original, recipe, watermark);
+        QCOMPARE(cache.firstRecomputedStage(), expectedStage);
+        QCOMPARE(cached, ImagePipeline::render(original, recipe, watermark));
+    };
+
+    check(PipelineCache::Adjustments);
+    recipe.watermarkOpacity = 30;
+    check(PipelineCache::Watermark);
+    recipe.cropTo(QRectF(0.25, 0.25, 0.5, 0.5));
+    check(PipelineCache::Geometry);
+    recipe.rotate(90);
+    check(PipelineCache::Geometry);
+    recipe.adjustments.brightness = -20;
+    check(PipelineCache::Adjustments);
+    check(PipelineCache::Watermark);
+
+    // A new source image invalidates all stages
+    original.setPixel(0, 0, qRgb(0, 0, 0));
+    check(PipelineCache::Adjustments);
+}
+
+void TestTSSAppUnit::testImageLoader()
+{
+    QTemporaryDir tempDir;
+    QVERIFY(tempDir.isValid());
+
+    const QString jpegPath = tempDir.filePath("large.jpg");
+    QImage original(800, 600, QImage::Format_RGB32);
+    original.fill(qRgb(30, 90, 150));
+    QVERIFY(original.save(jpegPath));
+
+    // JPEG decodes scaled: the preview arrives first, then the full image
+    QList<QSize> sizes;
+    ImageLoader loader;
+    connect(&loader, &ImageLoader::previewLoaded, [&](const QImage& preview) { sizes.append(preview.size()); });
+    connect(&loader, &ImageLoader::imageLoaded, [&](const QImage& image) { sizes.append(image.size()); });
+    loader.load(jpegPath, 200);
+    QTRY_COMPARE(sizes.size(), 2);
+    QCOMPARE(sizes, QList<QSize>({ QSize(200, 150), QSize(800, 600) }));
+
+    // A file no larger than the preview is decoded once
+    sizes.clear();
+    loader.load(jpegPath, 1000);
+    QTRY_COMPARE(sizes.size(), 1);
+    QCOMPARE(sizes.first(), QSize(800, 600));
+
+    // A superseded load delivers nothing
+    sizes.clear();
+    loader.load(jpegPath, 200);
+    loader.load(tempDir.filePath("missing.jpg"), 200);
+    QTRY_COMPARE(sizes.size(), 1);
+    QTest::qWait(50);
+    QCOMPARE(sizes.size(), 1);
+    QVERIFY(sizes.first().isEmpty()); // Unreadable file
 }
 
 QTEST_MAIN(TestTSSAppUnit)